@@ -2,10 +2,18 @@
 #include <memory>
 #include <algorithm>
 #include <iterator>
+#include <filesystem>
 #include "HWMath.h"
 #include "Surface.h"
 #include "GDIPlusManager.h"
 #include "imgui/imgui.h"
+#include "FrameConstantRing.h"
+#include "BindableCodex.h"
+#include "Sphere.h"
+#include "VertexQuantization.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "NullGraphicsContext.h"
 
 namespace dx = DirectX;
 
@@ -23,6 +31,7 @@ App::App(int width, int height, const char* windowName)
 	light(wnd.Gfx())
 {
 	wnd.Gfx().SetProjection(DirectX::XMMatrixPerspectiveLH(1.0f, 9.0f / 16.0f, 0.5f, 40.0f));
+	Profiler::Get().SetThreadName("Render");
 }
 
 int App::Start()
@@ -36,21 +45,33 @@ int App::Start()
 			return *eCode;
 		}
 		FrameUpdate();
+		Profiler::Get().EndFrame();
 	}
 }
 
 void App::FrameUpdate()
 {
-	const auto dt = timer.Mark() * speedFactor;
+	PROFILE_ZONE("App::FrameUpdate");
+	// the simulation steps on its own thread, the frame draws it somewhere between its two latest steps
+	simulation.SetParameters(simulationParameters);
+	simulation.Sample(simulationFrame);
+	light.SetOffset(simulationFrame.lightOffset);
 
 	wnd.Gfx().BeginFrame(0.07f, 0.0f, 0.12f);
+	// before any window records a texture view, an update can swap the views out
+	textureStreamer.Update(wnd.Gfx());
 
 	wnd.Gfx().SetCamera(cam.GetMatrix());
 	light.Bind(wnd.Gfx(), cam.GetMatrix());
+	renderQueue.BeginFrame(wnd.Gfx());
 
-	nanoSuit.Draw(wnd.Gfx());
-
-	light.Draw(wnd.Gfx());
+	nanoSuit.Submit(renderQueue);
+	for (const auto& placement : simulationFrame.crowd)
+	{
+		nanoSuit.Submit(renderQueue, dx::XMLoadFloat4x4(&placement));
+	}
+	light.Submit(renderQueue);
+	renderQueue.Execute(wnd.Gfx());
 
 	// imgui windows
 	cam.SpawnControlWindow();
@@ -76,6 +97,14 @@ void App::FrameUpdate()
 	}
 	
 	ShowRawInputWindow();
+	ShowRenderStatsWindow();
+	ShowImageBenchmarkWindow();
+	ShowTextureStreamingWindow();
+	ShowSoftwareRasterizerWindow();
+	ShowJobSystemWindow();
+	ShowSimulationWindow();
+	ShowProfilerWindow();
+	ShowSubmissionBenchmarkWindow();
 
 	// present
 	wnd.Gfx().EndFrame();
@@ -101,3 +130,409 @@ void App::ShowRawInputWindow()
 	}
 	ImGui::End();
 }
+
+void App::ShowRenderStatsWindow()
+{
+	if (ImGui::Begin("Render Stats"))
+	{
+		const auto& stats = wnd.Gfx().GetBindStats();
+		ImGui::Text("Binds issued: %zu", stats.issued);
+		ImGui::Text("Binds elided: %zu", stats.elided);
+		const auto& cullStats = renderQueue.GetCullStats();
+		ImGui::Text("Meshes visible: %zu", cullStats.visible);
+		ImGui::Text("Meshes culled: %zu (%zu subtrees)", cullStats.culled, cullStats.culledNodes);
+		const auto& drawStats = renderQueue.GetDrawStats();
+		ImGui::Text("Draw calls: %zu (%zu instances)", drawStats.drawCalls, drawStats.instances);
+		ImGui::Text("Recording slices: %zu", drawStats.recordingSlices);
+		const auto& codexStats = Bind::Codex::GetStats(wnd.Gfx());
+		ImGui::Text("Shared bindables: %zu (%zu reused)", codexStats.created, codexStats.reused);
+		if (const auto pRing = wnd.Gfx().GetFrameConstants())
+		{
+			const auto& ringStats = pRing->GetStats();
+			ImGui::Text("Frame constants: %zu blocks, %zu KB in %zu maps",
+				ringStats.allocations, ringStats.bytes / 1024u, ringStats.maps);
+		}
+		ImGui::SliderInt("Crowd", &simulationParameters.crowdSize, 0, 256);
+		bool parallelRecording = renderQueue.IsParallelRecording();
+		const bool recordingChanged = ImGui::Checkbox("Parallel Recording", &parallelRecording) |
+			ImGui::SliderInt("Min Slice Draws", &minSliceDraws, 1, 256);
+		if (recordingChanged)
+		{
+			renderQueue.SetParallelRecording(parallelRecording, (size_t)minSliceDraws);
+		}
+	}
+	ImGui::End();
+}
+
+void App::ShowImageBenchmarkWindow()
+{
+	if (ImGui::Begin("Image Loading"))
+	{
+		if (ImGui::Button("Benchmark Images"))
+		{
+			// decoded megabytes per second, best of a few loads so the first one paying for the disk doesn't count
+			const auto measure = [](Surface (*load)(const std::string&), const std::string& path)
+			{
+				float best = 0.0f;
+				for (int i = 0; i < 3; i++)
+				{
+					const Timer t;
+					const auto s = load(path);
+					const float seconds = t.Peek();
+					const float megabytes = float(s.GetWidth() * s.GetHeight() * sizeof(Surface::Color)) / (1024.0f * 1024.0f);
+					best = std::max(best, megabytes / seconds);
+				}
+				return best;
+			};
+			imageBenchmarks.clear();
+			std::error_code error;
+			for (const auto& entry : std::filesystem::directory_iterator("Images", error))
+			{
+				const auto path = entry.path().string();
+				imageBenchmarks.push_back({ entry.path().filename().string(),
+					measure(&Surface::FromFile, path), measure(&Surface::FromFileGdiPlus, path) });
+			}
+		}
+		for (const auto& b : imageBenchmarks)
+		{
+			ImGui::Text("%s: %.1f MB/s decoder, %.1f MB/s gdi+", b.name.c_str(), b.decoderMBs, b.gdiPlusMBs);
+		}
+		if (ImGui::Button("Benchmark Compression"))
+		{
+			// cpu only, the decode feeding the psnr isn't part of the timing
+			compressionBenchmarks.clear();
+			std::error_code error;
+			for (const auto& entry : std::filesystem::directory_iterator("Images", error))
+			{
+				const auto s = Surface::FromFile(entry.path().string());
+				const auto pPixels = reinterpret_cast<const std::uint32_t*>(s.GetBufferPtrConst());
+				const size_t count = size_t(s.GetWidth()) * s.GetHeight();
+				const float megabytes = float(count * sizeof(Surface::Color)) / (1024.0f * 1024.0f);
+				std::vector<std::uint32_t> decoded(count);
+				for (const auto format : { BlockCompressor::Format::BC1, BlockCompressor::Format::BC3,
+					BlockCompressor::Format::BC5, BlockCompressor::Format::BC7 })
+				{
+					const Timer t;
+					const auto blocks = BlockCompressor::Encode(pPixels, s.GetWidth(), s.GetHeight(), format);
+					const float seconds = t.Peek();
+					BlockCompressor::Decode(blocks.data(), s.GetWidth(), s.GetHeight(), format, decoded.data());
+					compressionBenchmarks.push_back({ entry.path().filename().string(), format, megabytes / seconds,
+						BlockCompressor::MeasurePsnr(pPixels, decoded.data(), count, format),
+						float(count * sizeof(Surface::Color)) / float(blocks.size()) });
+				}
+			}
+		}
+		for (const auto& b : compressionBenchmarks)
+		{
+			static constexpr const char* formatNames[] = { "bc1", "bc3", "bc5", "bc7" };
+			ImGui::Text("%s %s: %.1f MB/s, %.1f dB, %.0f:1", b.name.c_str(), formatNames[(int)b.format], b.encodeMBs, b.psnr, b.ratio);
+		}
+		if (ImGui::Button("Benchmark Mips"))
+		{
+			// gradient with a noisy alpha so neither filter gets to work on flat color
+			Surface s(4096u, 4096u);
+			for (unsigned int y = 0; y < s.GetHeight(); y++)
+			{
+				for (unsigned int x = 0; x < s.GetWidth(); x++)
+				{
+					s.PutPixel(x, y, { (unsigned char)((x ^ y) * 31u), (unsigned char)x, (unsigned char)y, (unsigned char)(x + y) });
+				}
+			}
+			const float megabytes = float(s.GetWidth() * s.GetHeight() * sizeof(Surface::Color)) / (1024.0f * 1024.0f);
+			const auto measure = [&s, megabytes](Surface::MipFilter filter)
+			{
+				const Timer t;
+				const auto mips = s.MakeMipChain(filter);
+				return megabytes / t.Peek();
+			};
+			mipBenchmark = MipBenchmark{ measure(Surface::MipFilter::Box), measure(Surface::MipFilter::Kaiser) };
+		}
+		if (mipBenchmark)
+		{
+			ImGui::Text("4096x4096 mips: %.1f MB/s box, %.1f MB/s kaiser", mipBenchmark->boxMBs, mipBenchmark->kaiserMBs);
+		}
+	}
+	ImGui::End();
+}
+
+void App::ShowTextureStreamingWindow()
+{
+	if (ImGui::Begin("Texture Streaming"))
+	{
+		const auto& stats = textureStreamer.GetStats();
+		int budgetMB = int(stats.budgetBytes >> 20u);
+		if (ImGui::SliderInt("Budget (MB)", &budgetMB, 1, 256))
+		{
+			textureStreamer.SetBudget(size_t(budgetMB) << 20u);
+		}
+		ImGui::SliderFloat("Preview Size", &streamedPreviewSize, 16.0f, 2048.0f, "%.0f px", ImGuiSliderFlags_Logarithmic);
+		ImGui::Text("Resident: %.1f MB in %zu textures, %zu loading", float(stats.residentBytes) / (1024.0f * 1024.0f),
+			stats.textures, stats.pendingLoads);
+		ImGui::Text("Levels loaded: %zu, evicted: %zu", stats.levelsLoaded, stats.levelsEvicted);
+		if (const auto pView = pStreamedLogo->GetView())
+		{
+			ImGui::Text("Logo: level %u of %u resident", pStreamedLogo->GetResidentLevel(), pStreamedLogo->GetLevelCount());
+			const float aspect = float(pStreamedLogo->GetHeight()) / float(pStreamedLogo->GetWidth());
+			pStreamedLogo->RequestScreenSize(streamedPreviewSize);
+			ImGui::Image(pView, ImVec2(streamedPreviewSize, streamedPreviewSize * aspect));
+		}
+	}
+	ImGui::End();
+}
+
+void App::ShowSoftwareRasterizerWindow()
+{
+	if (ImGui::Begin("Software Rasterizer"))
+	{
+		if (ImGui::Button("Render Reference"))
+		{
+			// ring of phong spheres around the light seen through the current camera, every other one quantized
+			// so the half position / oct normal inputs get drawn too
+			struct Vertex
+			{
+				dx::XMFLOAT3 pos;
+			};
+			const auto sphere = Sphere::MakeTessellated<Vertex>(48, 96);
+			MeshCache::MeshData full{ Dvtx::VertexBuffer(Dvtx::StaticLayout<Dvtx::VertexLayout::Position3D, Dvtx::VertexLayout::Normal>::MakeDynamic()) };
+			for (const auto& v : sphere.vertices)
+			{
+				// unit sphere, the normal is the position
+				full.vertices.EmplaceBack(v.pos, v.pos);
+			}
+			full.indices = sphere.indices;
+			full.bounds = Bounds::FromPoints(reinterpret_cast<const char*>(sphere.vertices.data()), sizeof(Vertex), sphere.vertices.size());
+			const MeshCache::MeshData quantized{ Dvtx::Quantize(full.vertices, Dvtx::QuantizationBudget{}), full.indices, full.bounds };
+			const auto fullView = MeshCache::MakeView(full);
+			const auto quantizedView = MeshCache::MakeView(quantized);
+
+			SoftwareRasterizer rasterizer(1280u, 720u);
+			const auto camera = cam.GetMatrix();
+			const auto projection = wnd.Gfx().GetProjection();
+			const auto phongLight = light.GetPhongLight(camera);
+			// the default Model material
+			const SoftwareRasterizer::PhongMaterial material = { { 0.6f,0.6f,0.8f },0.6f,30.0f };
+			const auto lightPos = light.GetPosition();
+
+			const Timer t;
+			rasterizer.BeginFrame({ 255u,18u,0u,31u });
+			constexpr int sphereCount = 16;
+			for (int i = 0; i < sphereCount; i++)
+			{
+				const float angle = float(i) * 2.0f * PI / float(sphereCount);
+				rasterizer.DrawPhong(i % 2 ? quantizedView : fullView, SoftwareRasterizer::MakeTransforms(
+					dx::XMMatrixTranslation(lightPos.x + std::sin(angle) * 6.0f, lightPos.y, lightPos.z + std::cos(angle) * 6.0f),
+					camera, projection), phongLight, material);
+			}
+			rasterizer.DrawSolid(fullView, SoftwareRasterizer::MakeTransforms(dx::XMMatrixScaling(0.5f, 0.5f, 0.5f) *
+				dx::XMMatrixTranslation(lightPos.x, lightPos.y, lightPos.z), camera, projection), { 1.0f,1.0f,1.0f,1.0f });
+			rasterizer.Resolve();
+			rasterizerBenchmark = RasterizerBenchmark{ t.Peek() * 1000.0f, rasterizer.GetStats() };
+			rasterizer.GetTarget().Save("Reference.bmp");
+		}
+		if (rasterizerBenchmark)
+		{
+			const auto& stats = rasterizerBenchmark->stats;
+			const float seconds = rasterizerBenchmark->milliseconds / 1000.0f;
+			ImGui::Text("1280x720 in %.2f ms, saved to Reference.bmp", rasterizerBenchmark->milliseconds);
+			ImGui::Text("%.2f Mtris/s, %.2f Mpixels/s", float(stats.triangles) / seconds / 1e6f, float(stats.pixelsShaded) / seconds / 1e6f);
+			ImGui::Text("Triangles: %zu (%zu culled, %zu clipped), %zu binned", stats.triangles, stats.trianglesCulled,
+				stats.trianglesClipped, stats.binnedTriangles);
+			ImGui::Text("Blocks: %zu rasterized, %zu occluded", stats.blocksRasterized, stats.blocksOccluded);
+		}
+	}
+	ImGui::End();
+}
+
+void App::ShowJobSystemWindow()
+{
+	if (ImGui::Begin("Job System"))
+	{
+		auto& jobs = JobSystem::Get();
+		const auto stats = jobs.GetStats();
+		ImGui::Text("Workers: %u (+ waiting thread)", stats.workers);
+		ImGui::Text("Jobs run: %zu, stolen: %zu", stats.jobsRun, stats.jobsStolen);
+		if (ImGui::Button("Benchmark Jobs"))
+		{
+			// round trip of a job that does nothing, pushed from here and waited for
+			constexpr int emptyJobs = 100000;
+			const Timer emptyTimer;
+			{
+				JobSystem::Counter counter;
+				for (int i = 0; i < emptyJobs; i++)
+				{
+					jobs.Run([]() {}, &counter);
+				}
+				jobs.Wait(counter);
+			}
+			const float emptyJobNs = emptyTimer.Peek() * 1e9f / float(emptyJobs);
+
+			// fork / join of one job per core and a bit, nothing inside
+			constexpr int forks = 1000;
+			const Timer forkTimer;
+			for (int i = 0; i < forks; i++)
+			{
+				jobs.ParallelFor(64u, 1u, [](size_t, size_t) {});
+			}
+			const float parallelForUs = forkTimer.Peek() * 1e6f / float(forks);
+
+			// cpu bound loop without shared writes, once on this thread and once spread out
+			std::vector<float> results(1u << 16u);
+			const auto work = [&results](size_t begin, size_t end)
+			{
+				for (auto i = begin; i < end; i++)
+				{
+					float x = float(i);
+					for (int k = 0; k < 256; k++)
+					{
+						x = std::sqrt(x * 1.0001f + 1.0f);
+					}
+					results[i] = x;
+				}
+			};
+			const Timer serialTimer;
+			work(0u, results.size());
+			const float serial = serialTimer.Peek();
+			const Timer parallelTimer;
+			jobs.ParallelFor(results.size(), 256u, work);
+			const float parallel = parallelTimer.Peek();
+			jobBenchmark = JobBenchmark{ emptyJobNs, parallelForUs, serial / parallel };
+		}
+		if (jobBenchmark)
+		{
+			ImGui::Text("Empty job: %.0f ns", jobBenchmark->emptyJobNs);
+			ImGui::Text("64 way parallel for: %.1f us", jobBenchmark->parallelForUs);
+			ImGui::Text("Cpu bound loop: %.2fx over one thread", jobBenchmark->speedup);
+		}
+	}
+	ImGui::End();
+}
+
+void App::ShowSimulationWindow()
+{
+	if (ImGui::Begin("Simulation"))
+	{
+		const auto stats = simulation.GetStats();
+		ImGui::Text("Step: %zu (%.0f Hz)", simulationFrame.step, 1.0f / simulation.GetStepSeconds());
+		ImGui::Text("Drawn at: %.2f of the way from the step before", simulationFrame.alpha);
+		ImGui::Text("Last step: %.3f ms", stats.lastStepMs);
+		ImGui::Text("Steps skipped: %zu", stats.stepsSkipped);
+		ImGui::SliderFloat("Speed", &simulationParameters.speedFactor, 0.0f, 4.0f, "%.2f");
+		ImGui::SliderFloat("Light Orbit Radius", &simulationParameters.lightOrbitRadius, 0.0f, 20.0f, "%.1f");
+		ImGui::SliderFloat("Light Orbit Speed", &simulationParameters.lightOrbitSpeed, -4.0f, 4.0f, "%.2f");
+	}
+	ImGui::End();
+}
+
+void App::ShowProfilerWindow()
+{
+	if (ImGui::Begin("Profiler"))
+	{
+		auto& profiler = Profiler::Get();
+		ImGui::Text("Frame: %.2f ms", profiler.GetFrameMs());
+		ImGui::Text("Zones dropped: %zu", profiler.GetDroppedZones());
+		if (profiler.IsCapturing())
+		{
+			ImGui::Text("Capturing... %zu zones", profiler.GetCapturedZones());
+		}
+		else
+		{
+			if (ImGui::Button("Capture 60 Frames"))
+			{
+				profiler.BeginCapture(60u);
+				profilerStatus.clear();
+			}
+			if (profiler.GetCapturedZones() > 0u)
+			{
+				ImGui::SameLine();
+				if (ImGui::Button("Save Trace"))
+				{
+					profilerStatus = profiler.SaveChromeTrace("Profile.json") ?
+						"Saved Profile.json (open in chrome://tracing)" : "Failed to write Profile.json";
+				}
+			}
+		}
+		if (!profilerStatus.empty())
+		{
+			ImGui::Text("%s", profilerStatus.c_str());
+		}
+		ImGui::Separator();
+		ImGui::Columns(5, "zones");
+		ImGui::Text("Zone");
+		ImGui::NextColumn();
+		ImGui::Text("Calls");
+		ImGui::NextColumn();
+		ImGui::Text("Total ms");
+		ImGui::NextColumn();
+		ImGui::Text("Self ms");
+		ImGui::NextColumn();
+		ImGui::Text("Max ms");
+		ImGui::NextColumn();
+		for (const auto& zone : profiler.GetFrameStats())
+		{
+			ImGui::Text("%s", zone.name);
+			ImGui::NextColumn();
+			ImGui::Text("%zu", zone.calls);
+			ImGui::NextColumn();
+			ImGui::Text("%.3f", zone.totalMs);
+			ImGui::NextColumn();
+			ImGui::Text("%.3f", zone.selfMs);
+			ImGui::NextColumn();
+			ImGui::Text("%.3f", zone.maxMs);
+			ImGui::NextColumn();
+		}
+		ImGui::Columns(1);
+	}
+	ImGui::End();
+}
+
+void App::ShowSubmissionBenchmarkWindow()
+{
+	if (ImGui::Begin("Submission Benchmark"))
+	{
+		if (ImGui::Button("Measure Submission"))
+		{
+			// the model and crowd of the scene, drawn on a headless Graphics so only the cpu side is timed
+			// (the light stays out, its sphere's static binds belong to the window's device)
+			Graphics headless(1280u, 720u);
+			headless.SetProjection(wnd.Gfx().GetProjection());
+			headless.SetCamera(cam.GetMatrix());
+			const Model model{ headless, "Models\\nano.gltf", Dvtx::QuantizationBudget{}, true };
+			RenderQueue queue;
+			queue.SetParallelRecording(renderQueue.IsParallelRecording(), (size_t)minSliceDraws);
+
+			constexpr int frames = 100;
+			const Timer t;
+			for (int i = 0; i < frames; i++)
+			{
+				headless.BeginFrame(0.0f, 0.0f, 0.0f);
+				queue.BeginFrame(headless);
+				model.Submit(queue);
+				for (const auto& placement : simulationFrame.crowd)
+				{
+					model.Submit(queue, dx::XMLoadFloat4x4(&placement));
+				}
+				queue.Execute(headless);
+				headless.EndFrame();
+			}
+			const float submitUs = t.Peek() * 1e6f / float(frames);
+
+			const auto& log = *headless.GetCommandLog();
+			submissionBenchmark = SubmissionBenchmark{
+				submitUs,
+				log.GetCommands().size(),
+				log.GetBindCount(),
+				log.GetCount(CommandLog::Op::DrawIndexed) + log.GetCount(CommandLog::Op::DrawIndexedInstanced),
+				log.GetCount(CommandLog::Op::Map),
+				log.GetIndexCount()
+			};
+		}
+		if (submissionBenchmark)
+		{
+			ImGui::Text("Submit: %.1f us / frame", submissionBenchmark->submitUs);
+			ImGui::Text("Commands: %zu (%zu binds)", submissionBenchmark->commands, submissionBenchmark->binds);
+			ImGui::Text("Draw calls: %zu (%zu indices)", submissionBenchmark->drawCalls, submissionBenchmark->indices);
+			ImGui::Text("Maps: %zu", submissionBenchmark->maps);
+		}
+	}
+	ImGui::End();
+}
\ No newline at end of file
@@ -6,7 +6,15 @@
 #include "Camera.h"
 #include "PointLight.h"
 #include "Mesh.h"
+#include "RenderQueue.h"
+#include "BlockCompressor.h"
+#include "TextureStreamer.h"
+#include "SoftwareRasterizer.h"
+#include "Simulation.h"
+#include <optional>
 #include <set>
+#include <string>
+#include <vector>
 
 class App
 {
@@ -21,13 +29,86 @@ private:
 	void FrameUpdate();
 	static void ShowImguiDemoWindow(bool showDemoWindow);
 	void ShowRawInputWindow();
+	void ShowRenderStatsWindow();
+	void ShowImageBenchmarkWindow();
+	void ShowTextureStreamingWindow();
+	void ShowSoftwareRasterizerWindow();
+	void ShowJobSystemWindow();
+	void ShowSimulationWindow();
+	void ShowProfilerWindow();
+	void ShowSubmissionBenchmarkWindow();
+private:
+	// load throughput of every file in Images\ through both Surface loaders
+	struct ImageBenchmark
+	{
+		std::string name;
+		float decoderMBs;
+		float gdiPlusMBs;
+	};
+	// encode throughput, quality and size reduction of one block format on one of the Images\ files
+	struct CompressionBenchmark
+	{
+		std::string name;
+		BlockCompressor::Format format;
+		float encodeMBs;
+		float psnr;
+		float ratio;
+	};
+	// mip chain generation throughput on a synthetic 4k surface
+	struct MipBenchmark
+	{
+		float boxMBs;
+		float kaiserMBs;
+	};
+	// one cpu rendered reference frame
+	struct RasterizerBenchmark
+	{
+		float milliseconds;
+		SoftwareRasterizer::Stats stats;
+	};
+	// scheduler overhead and how far a cpu bound loop scales over the job system
+	struct JobBenchmark
+	{
+		float emptyJobNs;
+		float parallelForUs;
+		float speedup;
+	};
+	// cpu cost of submitting the scene to a headless Graphics averaged over frames, the command counts of the last one
+	struct SubmissionBenchmark
+	{
+		float submitUs;
+		size_t commands;
+		size_t binds;
+		size_t drawCalls;
+		size_t maps;
+		size_t indices;
+	};
 private:
 	int x = 0, y = 0;
 	ImguiManager imgui;
 	Window wnd;
-	Timer timer;
-	float speedFactor = 1.0f;
+	int minSliceDraws = 64;
 	Camera cam;
 	PointLight light;
-	Model nanoSuit{wnd.Gfx(), "Models\\nano.gltf"};
+	RenderQueue renderQueue;
+	// crowd and light animation, the copies of the model are drawn instanced
+	Simulation simulation;
+	Simulation::Parameters simulationParameters;
+	Simulation::Frame simulationFrame;
+	// result of the last trace save, empty before the first one
+	std::string profilerStatus;
+	std::vector<ImageBenchmark> imageBenchmarks;
+	std::vector<CompressionBenchmark> compressionBenchmarks;
+	std::optional<MipBenchmark> mipBenchmark;
+	std::optional<RasterizerBenchmark> rasterizerBenchmark;
+	std::optional<JobBenchmark> jobBenchmark;
+	std::optional<SubmissionBenchmark> submissionBenchmark;
+	TextureStreamer textureStreamer{ 64u << 20u };
+	std::shared_ptr<Bind::StreamedTexture> pStreamedLogo = textureStreamer.Load([]()
+	{
+		return Surface::FromFile("Images\\HWG_Logo.png");
+	});
+	// on screen size of the streamed texture preview, drives which of its mips get requested
+	float streamedPreviewSize = 256.0f;
+	Model nanoSuit{wnd.Gfx(), "Models\\nano.gltf", Dvtx::QuantizationBudget{}, true};
 };
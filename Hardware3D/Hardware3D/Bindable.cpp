@@ -1,10 +1,11 @@
 ﻿#include "Bindable.h"
+#include <atomic>
 
 namespace Bind
 {
-	ID3D11DeviceContext* Bindable::GetContext(Graphics& gfx) noexcept
+	GraphicsContext* Bindable::GetContext(Graphics& gfx) noexcept
 	{
-		return gfx.pContext.Get();
+		return &gfx.GetCurrentContext();
 	}
 
 	ID3D11Device* Bindable::GetDevice(Graphics& gfx) noexcept
@@ -20,5 +21,16 @@ namespace Bind
 	throw std::logic_error("Shouldn't be trying to get detailed exceptions in release mode");
 #endif
 	}
+
+	unsigned int Bindable::GetSortId() const noexcept
+	{
+		return sortId;
+	}
+
+	unsigned int Bindable::NextSortId() noexcept
+	{
+		static std::atomic<unsigned int> next = 0u;
+		return next++;
+	}
 	
 }
@@ -8,11 +8,20 @@ namespace Bind
 	{
 	public:
 		virtual void Bind(Graphics& gfx) noexcept = 0;
+		// first pass of a render queue execute, lets per-draw data be written out before anything is
+		// bound (see FrameConstantRing), each Stage is followed by a Bind for the same draw later on
+		virtual void Stage(Graphics& gfx) {}
 		virtual ~Bindable() = default;
+		// small id unique to each bindable, used to group draws by state in the render queue
+		unsigned int GetSortId() const noexcept;
 	protected:
-		static ID3D11DeviceContext* GetContext(Graphics& gfx) noexcept;
+		static GraphicsContext* GetContext(Graphics& gfx) noexcept;
 		static ID3D11Device* GetDevice(Graphics& gfx) noexcept;
 		static DxgiInfoManager& GetInfoManager(Graphics& gfx);
+	private:
+		static unsigned int NextSortId() noexcept;
+	private:
+		unsigned int sortId = NextSortId();
 	};
 	
 }
@@ -0,0 +1,45 @@
+﻿#include "BindableCodex.h"
+
+namespace Bind
+{
+	const Codex::Stats& Codex::GetStats(Graphics& gfx) noexcept
+	{
+		return Get(gfx).stats;
+	}
+
+	std::string Codex::MakeUID(const char* typeName)
+	{
+		std::string uid = typeName;
+		uid.push_back('#');
+		return uid;
+	}
+
+	void Codex::AppendUID(std::string& uid, const void* pData, size_t size)
+	{
+		uid.append(static_cast<const char*>(pData), size);
+	}
+
+	void Codex::AppendUID(std::string& uid, const std::wstring& path)
+	{
+		// length first so a path can't run into whatever gets appended after it
+		const size_t length = path.size();
+		AppendUID(uid, &length, sizeof(length));
+		AppendUID(uid, path.data(), length * sizeof(wchar_t));
+	}
+
+	std::uint64_t Codex::HashBytes(const void* pData, size_t size) noexcept
+	{
+		const auto pBytes = static_cast<const unsigned char*>(pData);
+		std::uint64_t hash = 0xCBF29CE484222325ull;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash = (hash ^ pBytes[i]) * 0x100000001B3ull;
+		}
+		return hash;
+	}
+
+	Codex& Codex::Get(Graphics& gfx) noexcept
+	{
+		return *gfx.pCodex;
+	}
+}
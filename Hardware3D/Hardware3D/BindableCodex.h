@@ -0,0 +1,52 @@
+﻿#pragma once
+#include "Bindable.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace Bind
+{
+	// registry of bindables shared between drawables, one per Graphics
+	// T::GenerateUID(params...) has to key on everything that goes into T's constructor, so asking twice
+	// for the same shader / layout / constants hands back the bindable created the first time
+	// only immutable bindables belong in here, an Update through one drawable would show up in all of them
+	class Codex
+	{
+	public:
+		struct Stats
+		{
+			size_t created = 0u;
+			size_t reused = 0u;
+		};
+	public:
+		template<class T, typename...Params>
+		static std::shared_ptr<T> Resolve(Graphics& gfx, Params&&...p)
+		{
+			auto& codex = Get(gfx);
+			const auto uid = T::GenerateUID(p...);
+			const auto i = codex.binds.find(uid);
+			if (i != codex.binds.end())
+			{
+				codex.stats.reused++;
+				return std::static_pointer_cast<T>(i->second);
+			}
+			auto pBind = std::make_shared<T>(gfx, std::forward<Params>(p)...);
+			codex.binds.emplace(uid, pBind);
+			codex.stats.created++;
+			return pBind;
+		}
+		static const Stats& GetStats(Graphics& gfx) noexcept;
+		// building blocks for GenerateUID, uids are binary strings led by the type name
+		static std::string MakeUID(const char* typeName);
+		static void AppendUID(std::string& uid, const void* pData, size_t size);
+		static void AppendUID(std::string& uid, const std::wstring& path);
+		// 64 bit fnv-1a, for keying on blobs too large to append whole
+		static std::uint64_t HashBytes(const void* pData, size_t size) noexcept;
+	private:
+		static Codex& Get(Graphics& gfx) noexcept;
+	private:
+		std::unordered_map<std::string, std::shared_ptr<Bindable>> binds;
+		Stats stats;
+	};
+}
@@ -1,5 +1,6 @@
 ﻿#pragma once
 
+#include "BindableCodex.h"
 #include "ConstantBuffers.h"
 #include "IndexBuffer.h"
 #include "InputLayout.h"
@@ -0,0 +1,746 @@
+﻿#include "BlockCompressor.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace
+{
+	// texels of one 4x4 block in row major order, channels as r g b a in 0..255
+	struct Block
+	{
+		float texels[16][4];
+	};
+
+	Block LoadBlock(const std::uint32_t* pSrc, unsigned int width, unsigned int height, unsigned int bx, unsigned int by) noexcept
+	{
+		Block block;
+		for (unsigned int i = 0; i < 16u; i++)
+		{
+			const auto x = std::min(bx * 4u + (i & 3u), width - 1u);
+			const auto y = std::min(by * 4u + (i >> 2u), height - 1u);
+			const auto p = pSrc[size_t(y) * width + x];
+			block.texels[i][0] = float((p >> 16u) & 0xFFu);
+			block.texels[i][1] = float((p >> 8u) & 0xFFu);
+			block.texels[i][2] = float(p & 0xFFu);
+			block.texels[i][3] = float(p >> 24u);
+		}
+		return block;
+	}
+
+	std::uint32_t PackBgra(unsigned int r, unsigned int g, unsigned int b, unsigned int a) noexcept
+	{
+		return (a << 24u) | (r << 16u) | (g << 8u) | b;
+	}
+
+	float Quantize(float v, float maxValue) noexcept
+	{
+		return std::min(std::max(std::round(v * maxValue / 255.0f), 0.0f), maxValue);
+	}
+
+	float DistanceSq(const float* a, const unsigned int* b, int channels) noexcept
+	{
+		float d = 0.0f;
+		for (int c = 0; c < channels; c++)
+		{
+			d += (a[c] - float(b[c])) * (a[c] - float(b[c]));
+		}
+		return d;
+	}
+
+	// endpoints of the line through the block along its principal axis (power iteration on the covariance)
+	void FitLine(const Block& block, int channels, float (&e0)[4], float (&e1)[4]) noexcept
+	{
+		float mean[4] = {};
+		for (const auto& t : block.texels)
+		{
+			for (int c = 0; c < channels; c++)
+			{
+				mean[c] += t[c] / 16.0f;
+			}
+		}
+		float cov[4][4] = {};
+		for (const auto& t : block.texels)
+		{
+			for (int r = 0; r < channels; r++)
+			{
+				for (int c = 0; c < channels; c++)
+				{
+					cov[r][c] += (t[r] - mean[r]) * (t[c] - mean[c]);
+				}
+			}
+		}
+
+		// starting from the column of the widest channel keeps the guess from being orthogonal to the answer
+		int widest = 0;
+		for (int c = 1; c < channels; c++)
+		{
+			if (cov[c][c] > cov[widest][widest])
+			{
+				widest = c;
+			}
+		}
+		float axis[4] = {};
+		for (int c = 0; c < channels; c++)
+		{
+			axis[c] = cov[c][widest];
+		}
+		for (int i = 0; i < 8; i++)
+		{
+			float next[4] = {};
+			float scale = 0.0f;
+			for (int r = 0; r < channels; r++)
+			{
+				for (int c = 0; c < channels; c++)
+				{
+					next[r] += cov[r][c] * axis[c];
+				}
+				scale = std::max(scale, std::abs(next[r]));
+			}
+			if (scale == 0.0f)
+			{
+				break;
+			}
+			for (int c = 0; c < channels; c++)
+			{
+				axis[c] = next[c] / scale;
+			}
+		}
+		float lengthSq = 0.0f;
+		for (int c = 0; c < channels; c++)
+		{
+			lengthSq += axis[c] * axis[c];
+		}
+		const float invLength = lengthSq > 0.0f ? 1.0f / std::sqrt(lengthSq) : 0.0f;
+
+		float tMin = 0.0f;
+		float tMax = 0.0f;
+		for (const auto& t : block.texels)
+		{
+			float proj = 0.0f;
+			for (int c = 0; c < channels; c++)
+			{
+				proj += (t[c] - mean[c]) * axis[c] * invLength;
+			}
+			tMin = std::min(tMin, proj);
+			tMax = std::max(tMax, proj);
+		}
+		for (int c = 0; c < 4; c++)
+		{
+			e0[c] = c < channels ? std::min(std::max(mean[c] + axis[c] * invLength * tMax, 0.0f), 255.0f) : 0.0f;
+			e1[c] = c < channels ? std::min(std::max(mean[c] + axis[c] * invLength * tMin, 0.0f), 255.0f) : 0.0f;
+		}
+	}
+
+	// least squares endpoints for texels sitting at the given fractions between e0 and e1
+	void RefineLine(const Block& block, int channels, const float (&weights)[16], float (&e0)[4], float (&e1)[4]) noexcept
+	{
+		float aa = 0.0f;
+		float ab = 0.0f;
+		float bb = 0.0f;
+		float ax[4] = {};
+		float bx[4] = {};
+		for (unsigned int i = 0; i < 16u; i++)
+		{
+			const float b = weights[i];
+			const float a = 1.0f - b;
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+			for (int c = 0; c < channels; c++)
+			{
+				ax[c] += a * block.texels[i][c];
+				bx[c] += b * block.texels[i][c];
+			}
+		}
+		const float det = aa * bb - ab * ab;
+		// every texel on the same palette entry, nothing to solve for
+		if (std::abs(det) < 1e-6f)
+		{
+			return;
+		}
+		for (int c = 0; c < channels; c++)
+		{
+			e0[c] = std::min(std::max((bb * ax[c] - ab * bx[c]) / det, 0.0f), 255.0f);
+			e1[c] = std::min(std::max((aa * bx[c] - ab * ax[c]) / det, 0.0f), 255.0f);
+		}
+	}
+
+	// bc1 color block: two 565 endpoints and 2 bit indices
+	std::uint16_t Pack565(const float (&c)[4]) noexcept
+	{
+		return std::uint16_t(((unsigned int)Quantize(c[0], 31.0f) << 11u) |
+			((unsigned int)Quantize(c[1], 63.0f) << 5u) | (unsigned int)Quantize(c[2], 31.0f));
+	}
+
+	void Unpack565(std::uint16_t v, unsigned int (&c)[3]) noexcept
+	{
+		const unsigned int r = v >> 11u;
+		const unsigned int g = (v >> 5u) & 0x3Fu;
+		const unsigned int b = v & 0x1Fu;
+		c[0] = (r << 3u) | (r >> 2u);
+		c[1] = (g << 2u) | (g >> 4u);
+		c[2] = (b << 3u) | (b >> 2u);
+	}
+
+	// returns false for the 3 color mode of bc1, where the last entry is transparent black
+	bool ColorPalette(std::uint16_t c0, std::uint16_t c1, bool forceFourColor, unsigned int (&palette)[4][3]) noexcept
+	{
+		Unpack565(c0, palette[0]);
+		Unpack565(c1, palette[1]);
+		const bool fourColor = forceFourColor || c0 > c1;
+		for (int c = 0; c < 3; c++)
+		{
+			if (fourColor)
+			{
+				palette[2][c] = (2u * palette[0][c] + palette[1][c] + 1u) / 3u;
+				palette[3][c] = (palette[0][c] + 2u * palette[1][c] + 1u) / 3u;
+			}
+			else
+			{
+				palette[2][c] = (palette[0][c] + palette[1][c] + 1u) / 2u;
+				palette[3][c] = 0u;
+			}
+		}
+		return fourColor;
+	}
+
+	void EncodeColor(const Block& block, unsigned char* pOut) noexcept
+	{
+		// fractions between endpoint 0 and 1 for each index in 4 color mode
+		static constexpr float indexWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+		float e0[4];
+		float e1[4];
+		FitLine(block, 3, e0, e1);
+		float bestError = std::numeric_limits<float>::max();
+		std::uint16_t best0 = 0u;
+		std::uint16_t best1 = 0u;
+		std::uint32_t bestIndices = 0u;
+		for (int iteration = 0; iteration < 3; iteration++)
+		{
+			auto c0 = Pack565(e0);
+			auto c1 = Pack565(e1);
+			// 4 color mode is selected by the first endpoint being larger
+			if (c0 < c1)
+			{
+				std::swap(c0, c1);
+				std::swap(e0, e1);
+			}
+			unsigned int palette[4][3];
+			ColorPalette(c0, c1, true, palette);
+			float error = 0.0f;
+			std::uint32_t indices = 0u;
+			float weights[16];
+			for (unsigned int i = 0; i < 16u; i++)
+			{
+				// equal endpoints would decode in 3 color mode, where only the first two entries are safe
+				unsigned int index = 0u;
+				float nearest = DistanceSq(block.texels[i], palette[0], 3);
+				for (unsigned int p = 1; p < (c0 == c1 ? 1u : 4u); p++)
+				{
+					const float d = DistanceSq(block.texels[i], palette[p], 3);
+					if (d < nearest)
+					{
+						nearest = d;
+						index = p;
+					}
+				}
+				error += nearest;
+				indices |= index << (i * 2u);
+				weights[i] = indexWeights[index];
+			}
+			if (error < bestError)
+			{
+				bestError = error;
+				best0 = c0;
+				best1 = c1;
+				bestIndices = indices;
+			}
+			if (error == 0.0f || c0 == c1)
+			{
+				break;
+			}
+			RefineLine(block, 3, weights, e0, e1);
+		}
+		pOut[0] = (unsigned char)best0;
+		pOut[1] = (unsigned char)(best0 >> 8u);
+		pOut[2] = (unsigned char)best1;
+		pOut[3] = (unsigned char)(best1 >> 8u);
+		for (unsigned int i = 0; i < 4u; i++)
+		{
+			pOut[4u + i] = (unsigned char)(bestIndices >> (i * 8u));
+		}
+	}
+
+	// fills rgb and sets alpha opaque (or 0 for the transparent entry of 3 color mode)
+	void DecodeColor(const unsigned char* pIn, bool forceFourColor, std::uint32_t (&texels)[16]) noexcept
+	{
+		const auto c0 = std::uint16_t(pIn[0] | (pIn[1] << 8u));
+		const auto c1 = std::uint16_t(pIn[2] | (pIn[3] << 8u));
+		unsigned int palette[4][3];
+		const bool fourColor = ColorPalette(c0, c1, forceFourColor, palette);
+		for (unsigned int i = 0; i < 16u; i++)
+		{
+			const unsigned int index = (pIn[4u + i / 4u] >> ((i % 4u) * 2u)) & 3u;
+			const unsigned int alpha = fourColor || index != 3u ? 255u : 0u;
+			texels[i] = PackBgra(palette[index][0], palette[index][1], palette[index][2], alpha);
+		}
+	}
+
+	// bc4 channel block (bc3 alpha, each half of bc5): two 8 bit endpoints and 3 bit indices
+	void ChannelPalette(unsigned int e0, unsigned int e1, unsigned int (&palette)[8]) noexcept
+	{
+		palette[0] = e0;
+		palette[1] = e1;
+		if (e0 > e1)
+		{
+			for (unsigned int i = 1; i < 7u; i++)
+			{
+				palette[i + 1u] = ((7u - i) * e0 + i * e1 + 3u) / 7u;
+			}
+		}
+		else
+		{
+			for (unsigned int i = 1; i < 5u; i++)
+			{
+				palette[i + 1u] = ((5u - i) * e0 + i * e1 + 2u) / 5u;
+			}
+			palette[6] = 0u;
+			palette[7] = 255u;
+		}
+	}
+
+	// error of the block against one endpoint pair, indices packed 3 bits per texel
+	unsigned int FitChannel(const Block& block, int channel, unsigned int e0, unsigned int e1, std::uint64_t& indices) noexcept
+	{
+		unsigned int palette[8];
+		ChannelPalette(e0, e1, palette);
+		unsigned int error = 0u;
+		indices = 0u;
+		for (unsigned int i = 0; i < 16u; i++)
+		{
+			const auto v = (int)block.texels[i][channel];
+			unsigned int index = 0u;
+			unsigned int nearest = std::numeric_limits<unsigned int>::max();
+			for (unsigned int p = 0; p < 8u; p++)
+			{
+				const auto d = (unsigned int)((v - (int)palette[p]) * (v - (int)palette[p]));
+				if (d < nearest)
+				{
+					nearest = d;
+					index = p;
+				}
+			}
+			error += nearest;
+			indices |= std::uint64_t(index) << (i * 3u);
+		}
+		return error;
+	}
+
+	void EncodeChannel(const Block& block, int channel, unsigned char* pOut) noexcept
+	{
+		// 8 interpolated values across the full range, or 6 across the values strictly inside 0..255
+		// with exact 0 and 255 on the side, whichever fits better
+		unsigned int lo = 255u;
+		unsigned int hi = 0u;
+		unsigned int innerLo = 255u;
+		unsigned int innerHi = 0u;
+		for (const auto& t : block.texels)
+		{
+			const auto v = (unsigned int)t[channel];
+			lo = std::min(lo, v);
+			hi = std::max(hi, v);
+			if (v != 0u && v != 255u)
+			{
+				innerLo = std::min(innerLo, v);
+				innerHi = std::max(innerHi, v);
+			}
+		}
+		unsigned int e0 = hi;
+		unsigned int e1 = lo;
+		std::uint64_t indices;
+		auto error = FitChannel(block, channel, e0, e1, indices);
+		if (error != 0u && (lo == 0u || hi == 255u))
+		{
+			if (innerLo > innerHi)
+			{
+				innerLo = innerHi = 0u;
+			}
+			std::uint64_t innerIndices;
+			const auto innerError = FitChannel(block, channel, innerLo, innerHi, innerIndices);
+			if (innerError < error)
+			{
+				e0 = innerLo;
+				e1 = innerHi;
+				indices = innerIndices;
+			}
+		}
+		pOut[0] = (unsigned char)e0;
+		pOut[1] = (unsigned char)e1;
+		for (unsigned int i = 0; i < 6u; i++)
+		{
+			pOut[2u + i] = (unsigned char)(indices >> (i * 8u));
+		}
+	}
+
+	void DecodeChannel(const unsigned char* pIn, unsigned int (&values)[16]) noexcept
+	{
+		unsigned int palette[8];
+		ChannelPalette(pIn[0], pIn[1], palette);
+		std::uint64_t indices = 0u;
+		for (unsigned int i = 0; i < 6u; i++)
+		{
+			indices |= std::uint64_t(pIn[2u + i]) << (i * 8u);
+		}
+		for (unsigned int i = 0; i < 16u; i++)
+		{
+			values[i] = palette[(indices >> (i * 3u)) & 7u];
+		}
+	}
+
+	// bc7 mode 6: one subset, 7 bit rgba endpoints with a p bit each and 4 bit indices
+	constexpr unsigned int bc7Weights[16] = { 0u, 4u, 9u, 13u, 17u, 21u, 26u, 30u, 34u, 38u, 43u, 47u, 51u, 55u, 60u, 64u };
+
+	// fields are packed from the least significant bit of byte 0 upwards
+	class BitWriter
+	{
+	public:
+		BitWriter(unsigned char* pOut) noexcept
+			:
+			pOut(pOut)
+		{
+			std::fill(pOut, pOut + 16, (unsigned char)0u);
+		}
+		void Put(unsigned int value, unsigned int bits) noexcept
+		{
+			for (unsigned int i = 0; i < bits; i++, pos++)
+			{
+				pOut[pos / 8u] |= (unsigned char)(((value >> i) & 1u) << (pos % 8u));
+			}
+		}
+	private:
+		unsigned char* pOut;
+		unsigned int pos = 0u;
+	};
+
+	class BitReader
+	{
+	public:
+		BitReader(const unsigned char* pIn) noexcept
+			:
+			pIn(pIn)
+		{
+		}
+		unsigned int Get(unsigned int bits) noexcept
+		{
+			unsigned int value = 0u;
+			for (unsigned int i = 0; i < bits; i++, pos++)
+			{
+				value |= ((pIn[pos / 8u] >> (pos % 8u)) & 1u) << i;
+			}
+			return value;
+		}
+	private:
+		const unsigned char* pIn;
+		unsigned int pos = 0u;
+	};
+
+	struct Bc7Endpoint
+	{
+		unsigned int values[4];
+		unsigned int pBit;
+	};
+
+	// 7 bits per channel plus a p bit shared by the channels, p picked to suit the whole endpoint
+	Bc7Endpoint QuantizeBc7(const float (&e)[4]) noexcept
+	{
+		Bc7Endpoint best = {};
+		float bestError = std::numeric_limits<float>::max();
+		for (unsigned int p = 0; p < 2u; p++)
+		{
+			Bc7Endpoint candidate = {};
+			candidate.pBit = p;
+			float error = 0.0f;
+			for (int c = 0; c < 4; c++)
+			{
+				candidate.values[c] = (unsigned int)std::min(std::max(std::round((e[c] - float(p)) / 2.0f), 0.0f), 127.0f);
+				const float d = float((candidate.values[c] << 1u) | p) - e[c];
+				error += d * d;
+			}
+			if (error < bestError)
+			{
+				bestError = error;
+				best = candidate;
+			}
+		}
+		return best;
+	}
+
+	void Bc7Palette(const Bc7Endpoint& e0, const Bc7Endpoint& e1, unsigned int (&palette)[16][4]) noexcept
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			const unsigned int v0 = (e0.values[c] << 1u) | e0.pBit;
+			const unsigned int v1 = (e1.values[c] << 1u) | e1.pBit;
+			for (unsigned int i = 0; i < 16u; i++)
+			{
+				palette[i][c] = ((64u - bc7Weights[i]) * v0 + bc7Weights[i] * v1 + 32u) >> 6u;
+			}
+		}
+	}
+
+	void EncodeBc7(const Block& block, unsigned char* pOut) noexcept
+	{
+		float e0[4];
+		float e1[4];
+		FitLine(block, 4, e0, e1);
+		float bestError = std::numeric_limits<float>::max();
+		Bc7Endpoint best0 = {};
+		Bc7Endpoint best1 = {};
+		unsigned int bestIndices[16] = {};
+		for (int iteration = 0; iteration < 3; iteration++)
+		{
+			const auto q0 = QuantizeBc7(e0);
+			const auto q1 = QuantizeBc7(e1);
+			unsigned int palette[16][4];
+			Bc7Palette(q0, q1, palette);
+			float error = 0.0f;
+			unsigned int indices[16];
+			float weights[16];
+			for (unsigned int i = 0; i < 16u; i++)
+			{
+				unsigned int index = 0u;
+				float nearest = DistanceSq(block.texels[i], palette[0], 4);
+				for (unsigned int p = 1; p < 16u; p++)
+				{
+					const float d = DistanceSq(block.texels[i], palette[p], 4);
+					if (d < nearest)
+					{
+						nearest = d;
+						index = p;
+					}
+				}
+				error += nearest;
+				indices[i] = index;
+				weights[i] = float(bc7Weights[index]) / 64.0f;
+			}
+			if (error < bestError)
+			{
+				bestError = error;
+				best0 = q0;
+				best1 = q1;
+				std::copy(std::begin(indices), std::end(indices), bestIndices);
+			}
+			if (error == 0.0f)
+			{
+				break;
+			}
+			RefineLine(block, 4, weights, e0, e1);
+		}
+
+		// the first texel's index drops its top bit, so it has to sit in the lower half of the palette
+		if (bestIndices[0] >= 8u)
+		{
+			std::swap(best0, best1);
+			for (auto& i : bestIndices)
+			{
+				i = 15u - i;
+			}
+		}
+		BitWriter writer(pOut);
+		writer.Put(1u << 6u, 7u);
+		for (int c = 0; c < 4; c++)
+		{
+			writer.Put(best0.values[c], 7u);
+			writer.Put(best1.values[c], 7u);
+		}
+		writer.Put(best0.pBit, 1u);
+		writer.Put(best1.pBit, 1u);
+		writer.Put(bestIndices[0], 3u);
+		for (unsigned int i = 1; i < 16u; i++)
+		{
+			writer.Put(bestIndices[i], 4u);
+		}
+	}
+
+	void DecodeBc7(const unsigned char* pIn, std::uint32_t (&texels)[16]) noexcept
+	{
+		BitReader reader(pIn);
+		if (reader.Get(7u) != 1u << 6u)
+		{
+			std::fill(std::begin(texels), std::end(texels), 0u);
+			return;
+		}
+		Bc7Endpoint e0 = {};
+		Bc7Endpoint e1 = {};
+		for (int c = 0; c < 4; c++)
+		{
+			e0.values[c] = reader.Get(7u);
+			e1.values[c] = reader.Get(7u);
+		}
+		e0.pBit = reader.Get(1u);
+		e1.pBit = reader.Get(1u);
+		unsigned int palette[16][4];
+		Bc7Palette(e0, e1, palette);
+		for (unsigned int i = 0; i < 16u; i++)
+		{
+			const auto& p = palette[reader.Get(i == 0u ? 3u : 4u)];
+			texels[i] = PackBgra(p[0], p[1], p[2], p[3]);
+		}
+	}
+
+	// calls f(row) for every row of blocks, one job per row
+	template<typename F>
+	void ForEachBlockRow(unsigned int rows, const F& f)
+	{
+		JobSystem::Get().ParallelFor(rows, 1u, [&f](size_t begin, size_t end)
+		{
+			for (auto y = begin; y < end; y++)
+			{
+				f((unsigned int)y);
+			}
+		});
+	}
+}
+
+size_t BlockCompressor::GetBlockBytes(Format format) noexcept
+{
+	return format == Format::BC1 ? 8u : 16u;
+}
+
+size_t BlockCompressor::GetRowPitch(Format format, unsigned int width) noexcept
+{
+	return size_t((width + 3u) / 4u) * GetBlockBytes(format);
+}
+
+size_t BlockCompressor::GetEncodedSize(Format format, unsigned int width, unsigned int height) noexcept
+{
+	return GetRowPitch(format, width) * ((height + 3u) / 4u);
+}
+
+std::vector<unsigned char> BlockCompressor::Encode(const std::uint32_t* pSrc, unsigned int width, unsigned int height, Format format)
+{
+	std::vector<unsigned char> blocks(GetEncodedSize(format, width, height));
+	const auto blocksWide = (width + 3u) / 4u;
+	const auto blockBytes = GetBlockBytes(format);
+	ForEachBlockRow((height + 3u) / 4u, [&](unsigned int by)
+	{
+		auto pOut = blocks.data() + by * GetRowPitch(format, width);
+		for (unsigned int bx = 0; bx < blocksWide; bx++, pOut += blockBytes)
+		{
+			const auto block = LoadBlock(pSrc, width, height, bx, by);
+			switch (format)
+			{
+			case Format::BC1:
+				EncodeColor(block, pOut);
+				break;
+			case Format::BC3:
+				EncodeChannel(block, 3, pOut);
+				EncodeColor(block, pOut + 8);
+				break;
+			case Format::BC5:
+				EncodeChannel(block, 0, pOut);
+				EncodeChannel(block, 1, pOut + 8);
+				break;
+			case Format::BC7:
+				EncodeBc7(block, pOut);
+				break;
+			}
+		}
+	});
+	return blocks;
+}
+
+void BlockCompressor::Decode(const unsigned char* pBlocks, unsigned int width, unsigned int height, Format format, std::uint32_t* pDst) noexcept
+{
+	const auto blockBytes = GetBlockBytes(format);
+	for (unsigned int by = 0; by < (height + 3u) / 4u; by++)
+	{
+		for (unsigned int bx = 0; bx < (width + 3u) / 4u; bx++, pBlocks += blockBytes)
+		{
+			std::uint32_t texels[16];
+			switch (format)
+			{
+			case Format::BC1:
+				DecodeColor(pBlocks, false, texels);
+				break;
+			case Format::BC3:
+			{
+				unsigned int alpha[16];
+				DecodeChannel(pBlocks, alpha);
+				DecodeColor(pBlocks + 8, true, texels);
+				for (unsigned int i = 0; i < 16u; i++)
+				{
+					texels[i] = (texels[i] & 0x00FFFFFFu) | (alpha[i] << 24u);
+				}
+				break;
+			}
+			case Format::BC5:
+			{
+				unsigned int red[16];
+				unsigned int green[16];
+				DecodeChannel(pBlocks, red);
+				DecodeChannel(pBlocks + 8, green);
+				for (unsigned int i = 0; i < 16u; i++)
+				{
+					texels[i] = PackBgra(red[i], green[i], 0u, 255u);
+				}
+				break;
+			}
+			case Format::BC7:
+				DecodeBc7(pBlocks, texels);
+				break;
+			}
+			for (unsigned int i = 0; i < 16u; i++)
+			{
+				const auto x = bx * 4u + (i & 3u);
+				const auto y = by * 4u + (i >> 2u);
+				if (x < width && y < height)
+				{
+					pDst[size_t(y) * width + x] = texels[i];
+				}
+			}
+		}
+	}
+}
+
+float BlockCompressor::MeasurePsnr(const std::uint32_t* pReference, const std::uint32_t* pTest, size_t count, Format format) noexcept
+{
+	// byte shifts of the stored channels in a bgra dword
+	static constexpr unsigned int rgb[] = { 16u, 8u, 0u };
+	static constexpr unsigned int rgba[] = { 16u, 8u, 0u, 24u };
+	static constexpr unsigned int rg[] = { 16u, 8u };
+	const unsigned int* pShifts = rgba;
+	size_t channels = 4u;
+	switch (format)
+	{
+	case Format::BC1:
+		pShifts = rgb;
+		channels = 3u;
+		break;
+	case Format::BC5:
+		pShifts = rg;
+		channels = 2u;
+		break;
+	default:
+		break;
+	}
+
+	double sum = 0.0;
+	for (size_t i = 0; i < count; i++)
+	{
+		for (size_t c = 0; c < channels; c++)
+		{
+			const int d = int((pReference[i] >> pShifts[c]) & 0xFFu) - int((pTest[i] >> pShifts[c]) & 0xFFu);
+			sum += double(d * d);
+		}
+	}
+	if (sum == 0.0)
+	{
+		return std::numeric_limits<float>::infinity();
+	}
+	const double mse = sum / double(count * channels);
+	return float(10.0 * std::log10(255.0 * 255.0 / mse));
+}
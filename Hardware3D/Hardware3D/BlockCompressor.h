@@ -0,0 +1,34 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// encodes rows of 32 bit bgra pixels (the layout of Surface::Color) into d3d block compressed formats
+// every format stores 4x4 texel blocks, partial blocks at the right / bottom edge repeat the last texel
+// plain c++ without os or device dependencies, so it runs offline and in headless benchmarks
+class BlockCompressor
+{
+public:
+	enum class Format
+	{
+		// rgb at 4 bits per texel, alpha is dropped
+		BC1,
+		// bc1 color plus interpolated alpha at 8 bits per texel
+		BC3,
+		// two independent channels (red and green) at 8 bits per texel, for normal maps
+		BC5,
+		// rgba at 8 bits per texel, noticeably better quality than bc1 / bc3 but slower to encode
+		BC7,
+	};
+public:
+	static size_t GetBlockBytes(Format format) noexcept;
+	// bytes from one row of blocks to the next
+	static size_t GetRowPitch(Format format, unsigned int width) noexcept;
+	static size_t GetEncodedSize(Format format, unsigned int width, unsigned int height) noexcept;
+	// rows of blocks are spread over a few threads
+	static std::vector<unsigned char> Encode(const std::uint32_t* pSrc, unsigned int width, unsigned int height, Format format);
+	// pDst has room for width * height pixels. bc7 is only decoded for the block mode Encode emits (mode 6)
+	static void Decode(const unsigned char* pBlocks, unsigned int width, unsigned int height, Format format, std::uint32_t* pDst) noexcept;
+	// peak signal to noise ratio in dB over the channels the format stores, infinite when the images match
+	static float MeasurePsnr(const std::uint32_t* pReference, const std::uint32_t* pTest, size_t count, Format format) noexcept;
+};
@@ -0,0 +1,112 @@
+﻿#include "Bounds.h"
+#include <algorithm>
+#include <cstring>
+
+namespace dx = DirectX;
+
+bool Bounds::IsEmpty() const noexcept
+{
+	return radius < 0.0f;
+}
+
+Bounds Bounds::FromPoints(const char* pPositions, size_t stride, size_t count) noexcept
+{
+	if (count == 0u)
+	{
+		return {};
+	}
+	const auto load = [=](size_t i)
+	{
+		dx::XMFLOAT3 p;
+		std::memcpy(&p, pPositions + stride * i, sizeof(p));
+		return dx::XMLoadFloat3(&p);
+	};
+
+	auto vMin = load(0u);
+	auto vMax = vMin;
+	for (size_t i = 1; i < count; i++)
+	{
+		const auto p = load(i);
+		vMin = dx::XMVectorMin(vMin, p);
+		vMax = dx::XMVectorMax(vMax, p);
+	}
+	const auto vCenter = dx::XMVectorScale(dx::XMVectorAdd(vMin, vMax), 0.5f);
+
+	// sphere around the box center, not minimal but never worse than the box diagonal
+	auto vRadiusSq = dx::XMVectorZero();
+	for (size_t i = 0; i < count; i++)
+	{
+		vRadiusSq = dx::XMVectorMax(vRadiusSq, dx::XMVector3LengthSq(dx::XMVectorSubtract(load(i), vCenter)));
+	}
+
+	Bounds b;
+	dx::XMStoreFloat3(&b.center, vCenter);
+	dx::XMStoreFloat3(&b.extents, dx::XMVectorSubtract(vMax, vCenter));
+	b.radius = dx::XMVectorGetX(dx::XMVectorSqrt(vRadiusSq));
+	return b;
+}
+
+Bounds Bounds::Merge(const Bounds& a, const Bounds& b) noexcept
+{
+	if (a.IsEmpty())
+	{
+		return b;
+	}
+	if (b.IsEmpty())
+	{
+		return a;
+	}
+	const auto aCenter = dx::XMLoadFloat3(&a.center);
+	const auto bCenter = dx::XMLoadFloat3(&b.center);
+	const auto aExtents = dx::XMLoadFloat3(&a.extents);
+	const auto bExtents = dx::XMLoadFloat3(&b.extents);
+	const auto vMin = dx::XMVectorMin(dx::XMVectorSubtract(aCenter, aExtents), dx::XMVectorSubtract(bCenter, bExtents));
+	const auto vMax = dx::XMVectorMax(dx::XMVectorAdd(aCenter, aExtents), dx::XMVectorAdd(bCenter, bExtents));
+
+	Bounds merged;
+	dx::XMStoreFloat3(&merged.center, dx::XMVectorScale(dx::XMVectorAdd(vMin, vMax), 0.5f));
+	dx::XMStoreFloat3(&merged.extents, dx::XMVectorScale(dx::XMVectorSubtract(vMax, vMin), 0.5f));
+
+	// enclosing sphere of both spheres, unless one already holds the other
+	const float distance = dx::XMVectorGetX(dx::XMVector3Length(dx::XMVectorSubtract(bCenter, aCenter)));
+	if (distance + b.radius <= a.radius)
+	{
+		merged.radius = a.radius;
+	}
+	else if (distance + a.radius <= b.radius)
+	{
+		merged.radius = b.radius;
+	}
+	else
+	{
+		// the merged sphere is centered on the box, so measure both spheres from there
+		const auto mergedCenter = dx::XMLoadFloat3(&merged.center);
+		merged.radius = std::max(
+			dx::XMVectorGetX(dx::XMVector3Length(dx::XMVectorSubtract(aCenter, mergedCenter))) + a.radius,
+			dx::XMVectorGetX(dx::XMVector3Length(dx::XMVectorSubtract(bCenter, mergedCenter))) + b.radius
+		);
+	}
+	return merged;
+}
+
+Bounds Bounds::Transformed(DirectX::FXMMATRIX transform) const noexcept
+{
+	if (IsEmpty())
+	{
+		return *this;
+	}
+	// row vectors, so each row is where one axis of the box ends up
+	const auto vExtents = dx::XMLoadFloat3(&extents);
+	const auto rx = dx::XMVectorMultiply(dx::XMVectorAbs(transform.r[0]), dx::XMVectorSplatX(vExtents));
+	const auto ry = dx::XMVectorMultiply(dx::XMVectorAbs(transform.r[1]), dx::XMVectorSplatY(vExtents));
+	const auto rz = dx::XMVectorMultiply(dx::XMVectorAbs(transform.r[2]), dx::XMVectorSplatZ(vExtents));
+
+	const auto scaleSq = dx::XMVectorMax(dx::XMVector3LengthSq(transform.r[0]),
+		dx::XMVectorMax(dx::XMVector3LengthSq(transform.r[1]), dx::XMVector3LengthSq(transform.r[2])));
+
+	Bounds b;
+	dx::XMStoreFloat3(&b.center, dx::XMVector3Transform(dx::XMLoadFloat3(&center), transform));
+	dx::XMStoreFloat3(&b.extents, dx::XMVectorAdd(rx, dx::XMVectorAdd(ry, rz)));
+	b.radius = radius * dx::XMVectorGetX(dx::XMVectorSqrt(scaleSq));
+	return b;
+}
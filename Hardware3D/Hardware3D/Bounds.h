@@ -0,0 +1,20 @@
+﻿#pragma once
+#include <DirectXMath.h>
+#include <cstddef>
+
+// axis aligned box and bounding sphere around the same set of points
+// the sphere is the cheap first test, the box the tighter second one
+struct Bounds
+{
+	DirectX::XMFLOAT3 center = { 0.0f,0.0f,0.0f };
+	// half size along each axis
+	DirectX::XMFLOAT3 extents = { 0.0f,0.0f,0.0f };
+	// negative for bounds that contain nothing
+	float radius = -1.0f;
+	bool IsEmpty() const noexcept;
+	// pPositions points to the first x, consecutive positions are stride bytes apart
+	static Bounds FromPoints(const char* pPositions, size_t stride, size_t count) noexcept;
+	static Bounds Merge(const Bounds& a, const Bounds& b) noexcept;
+	// box of the transformed box (so it only grows under rotation), sphere scaled by the largest axis scale
+	Bounds Transformed(DirectX::FXMMATRIX transform) const noexcept;
+};
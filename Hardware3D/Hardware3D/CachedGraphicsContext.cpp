@@ -0,0 +1,266 @@
+﻿#include "CachedGraphicsContext.h"
+#include <algorithm>
+
+CachedGraphicsContext::CachedGraphicsContext(GraphicsContext& target) noexcept
+	:
+	target(target)
+{
+}
+
+void CachedGraphicsContext::Invalidate() noexcept
+{
+	for (auto& s : vertexBuffers)
+	{
+		s.Invalidate();
+	}
+	indexBuffer.Invalidate();
+	inputLayout.Invalidate();
+	topology.Invalidate();
+	vertexShader.Invalidate();
+	pixelShader.Invalidate();
+	for (auto& s : vsConstantBuffers)
+	{
+		s.Invalidate();
+	}
+	for (auto& s : psConstantBuffers)
+	{
+		s.Invalidate();
+	}
+	for (auto& s : psShaderResources)
+	{
+		s.Invalidate();
+	}
+	for (auto& s : psSamplers)
+	{
+		s.Invalidate();
+	}
+}
+
+const CachedGraphicsContext::BindStats& CachedGraphicsContext::GetStats() const noexcept
+{
+	return stats;
+}
+
+void CachedGraphicsContext::ResetStats() noexcept
+{
+	stats = {};
+}
+
+void CachedGraphicsContext::AddStats(const BindStats& recorded) noexcept
+{
+	stats.issued += recorded.issued;
+	stats.elided += recorded.elided;
+}
+
+UINT CachedGraphicsContext::MakeConstantBufferBindings(
+	std::array<ConstantBufferBinding, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT>& bindings,
+	UINT numBuffers, ID3D11Buffer* const* ppBuffers, const UINT* pFirstConstant, const UINT* pNumConstants) noexcept
+{
+	const UINT count = std::min(numBuffers, (UINT)bindings.size());
+	for (UINT i = 0; i < count; i++)
+	{
+		if (pFirstConstant && pNumConstants)
+		{
+			bindings[i] = { ppBuffers[i], pFirstConstant[i], pNumConstants[i] };
+		}
+		else
+		{
+			bindings[i] = { ppBuffers[i], 0u, 0u };
+		}
+	}
+	return count;
+}
+
+bool CachedGraphicsContext::Filter(bool changed) noexcept
+{
+	if (changed)
+	{
+		stats.issued++;
+	}
+	else
+	{
+		stats.elided++;
+	}
+	return changed;
+}
+
+void CachedGraphicsContext::IASetVertexBuffers(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers,
+                                               const UINT* pStrides, const UINT* pOffsets) noexcept
+{
+	std::array<VertexBufferBinding, D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT> bindings;
+	const UINT count = std::min(numBuffers, (UINT)bindings.size());
+	for (UINT i = 0; i < count; i++)
+	{
+		bindings[i] = { ppBuffers[i], pStrides[i], pOffsets[i] };
+	}
+	if (Filter(UpdateSlots(vertexBuffers, startSlot, count, bindings.data())))
+	{
+		target.IASetVertexBuffers(startSlot, numBuffers, ppBuffers, pStrides, pOffsets);
+	}
+}
+
+void CachedGraphicsContext::IASetIndexBuffer(ID3D11Buffer* pBuffer, DXGI_FORMAT format, UINT offset) noexcept
+{
+	if (Filter(indexBuffer.Update({ pBuffer, format, offset })))
+	{
+		target.IASetIndexBuffer(pBuffer, format, offset);
+	}
+}
+
+void CachedGraphicsContext::IASetInputLayout(ID3D11InputLayout* pInputLayout) noexcept
+{
+	if (Filter(inputLayout.Update(pInputLayout)))
+	{
+		target.IASetInputLayout(pInputLayout);
+	}
+}
+
+void CachedGraphicsContext::IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY type) noexcept
+{
+	if (Filter(topology.Update(type)))
+	{
+		target.IASetPrimitiveTopology(type);
+	}
+}
+
+void CachedGraphicsContext::VSSetShader(ID3D11VertexShader* pShader, ID3D11ClassInstance* const* ppClassInstances,
+                                        UINT numClassInstances) noexcept
+{
+	// class linkage is never tracked, those binds always go through
+	if (numClassInstances != 0u)
+	{
+		vertexShader.Invalidate();
+	}
+	if (Filter(vertexShader.Update(pShader) || numClassInstances != 0u))
+	{
+		target.VSSetShader(pShader, ppClassInstances, numClassInstances);
+	}
+}
+
+void CachedGraphicsContext::PSSetShader(ID3D11PixelShader* pShader, ID3D11ClassInstance* const* ppClassInstances,
+                                        UINT numClassInstances) noexcept
+{
+	if (numClassInstances != 0u)
+	{
+		pixelShader.Invalidate();
+	}
+	if (Filter(pixelShader.Update(pShader) || numClassInstances != 0u))
+	{
+		target.PSSetShader(pShader, ppClassInstances, numClassInstances);
+	}
+}
+
+void CachedGraphicsContext::VSSetConstantBuffers(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers) noexcept
+{
+	std::array<ConstantBufferBinding, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT> bindings;
+	const UINT count = MakeConstantBufferBindings(bindings, numBuffers, ppBuffers, nullptr, nullptr);
+	if (Filter(UpdateSlots(vsConstantBuffers, startSlot, count, bindings.data())))
+	{
+		target.VSSetConstantBuffers(startSlot, numBuffers, ppBuffers);
+	}
+}
+
+void CachedGraphicsContext::PSSetConstantBuffers(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers) noexcept
+{
+	std::array<ConstantBufferBinding, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT> bindings;
+	const UINT count = MakeConstantBufferBindings(bindings, numBuffers, ppBuffers, nullptr, nullptr);
+	if (Filter(UpdateSlots(psConstantBuffers, startSlot, count, bindings.data())))
+	{
+		target.PSSetConstantBuffers(startSlot, numBuffers, ppBuffers);
+	}
+}
+
+void CachedGraphicsContext::VSSetConstantBuffers1(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers,
+                                                  const UINT* pFirstConstant, const UINT* pNumConstants) noexcept
+{
+	std::array<ConstantBufferBinding, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT> bindings;
+	const UINT count = MakeConstantBufferBindings(bindings, numBuffers, ppBuffers, pFirstConstant, pNumConstants);
+	if (Filter(UpdateSlots(vsConstantBuffers, startSlot, count, bindings.data())))
+	{
+		target.VSSetConstantBuffers1(startSlot, numBuffers, ppBuffers, pFirstConstant, pNumConstants);
+	}
+}
+
+void CachedGraphicsContext::PSSetConstantBuffers1(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers,
+                                                  const UINT* pFirstConstant, const UINT* pNumConstants) noexcept
+{
+	std::array<ConstantBufferBinding, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT> bindings;
+	const UINT count = MakeConstantBufferBindings(bindings, numBuffers, ppBuffers, pFirstConstant, pNumConstants);
+	if (Filter(UpdateSlots(psConstantBuffers, startSlot, count, bindings.data())))
+	{
+		target.PSSetConstantBuffers1(startSlot, numBuffers, ppBuffers, pFirstConstant, pNumConstants);
+	}
+}
+
+void CachedGraphicsContext::PSSetShaderResources(UINT startSlot, UINT numViews,
+                                                 ID3D11ShaderResourceView* const* ppViews) noexcept
+{
+	if (Filter(UpdateSlots(psShaderResources, startSlot, numViews, ppViews)))
+	{
+		target.PSSetShaderResources(startSlot, numViews, ppViews);
+	}
+}
+
+void CachedGraphicsContext::PSSetSamplers(UINT startSlot, UINT numSamplers, ID3D11SamplerState* const* ppSamplers) noexcept
+{
+	if (Filter(UpdateSlots(psSamplers, startSlot, numSamplers, ppSamplers)))
+	{
+		target.PSSetSamplers(startSlot, numSamplers, ppSamplers);
+	}
+}
+
+void CachedGraphicsContext::RSSetViewports(UINT numViewports, const D3D11_VIEWPORT* pViewports) noexcept
+{
+	target.RSSetViewports(numViewports, pViewports);
+}
+
+void CachedGraphicsContext::OMSetRenderTargets(UINT numViews, ID3D11RenderTargetView* const* ppViews,
+                                               ID3D11DepthStencilView* pDepthStencilView) noexcept
+{
+	target.OMSetRenderTargets(numViews, ppViews, pDepthStencilView);
+}
+
+void CachedGraphicsContext::OMSetDepthStencilState(ID3D11DepthStencilState* pState, UINT stencilRef) noexcept
+{
+	target.OMSetDepthStencilState(pState, stencilRef);
+}
+
+void CachedGraphicsContext::ClearRenderTargetView(ID3D11RenderTargetView* pView, const FLOAT color[4]) noexcept
+{
+	target.ClearRenderTargetView(pView, color);
+}
+
+void CachedGraphicsContext::ClearDepthStencilView(ID3D11DepthStencilView* pView, UINT clearFlags, FLOAT depth,
+                                                  UINT8 stencil) noexcept
+{
+	target.ClearDepthStencilView(pView, clearFlags, depth, stencil);
+}
+
+HRESULT CachedGraphicsContext::Map(ID3D11Resource* pResource, UINT subresource, D3D11_MAP mapType, UINT mapFlags,
+                                   D3D11_MAPPED_SUBRESOURCE* pMappedResource) noexcept
+{
+	return target.Map(pResource, subresource, mapType, mapFlags, pMappedResource);
+}
+
+void CachedGraphicsContext::Unmap(ID3D11Resource* pResource, UINT subresource) noexcept
+{
+	target.Unmap(pResource, subresource);
+}
+
+void CachedGraphicsContext::CopySubresourceRegion(ID3D11Resource* pDstResource, UINT dstSubresource, UINT dstX, UINT dstY, UINT dstZ,
+                                                  ID3D11Resource* pSrcResource, UINT srcSubresource, const D3D11_BOX* pSrcBox) noexcept
+{
+	target.CopySubresourceRegion(pDstResource, dstSubresource, dstX, dstY, dstZ, pSrcResource, srcSubresource, pSrcBox);
+}
+
+void CachedGraphicsContext::DrawIndexed(UINT indexCount, UINT startIndexLocation, INT baseVertexLocation) noexcept
+{
+	target.DrawIndexed(indexCount, startIndexLocation, baseVertexLocation);
+}
+
+void CachedGraphicsContext::DrawIndexedInstanced(UINT indexCountPerInstance, UINT instanceCount, UINT startIndexLocation,
+                                                 INT baseVertexLocation, UINT startInstanceLocation) noexcept
+{
+	target.DrawIndexedInstanced(indexCountPerInstance, instanceCount, startIndexLocation,
+		baseVertexLocation, startInstanceLocation);
+}
@@ -0,0 +1,147 @@
+﻿#pragma once
+#include "GraphicsContext.h"
+#include <array>
+
+// sits between the bindables and the real context, remembers what is bound to every pipeline
+// slot and drops calls that would rebind the same state
+class CachedGraphicsContext : public GraphicsContext
+{
+public:
+	struct BindStats
+	{
+		size_t issued = 0u;
+		size_t elided = 0u;
+	};
+private:
+	template<typename T>
+	class CachedState
+	{
+	public:
+		// returns true if the value differs from what is bound (the call needs to be issued)
+		bool Update(const T& newValue) noexcept
+		{
+			if (valid && value == newValue)
+			{
+				return false;
+			}
+			value = newValue;
+			valid = true;
+			return true;
+		}
+		void Invalidate() noexcept
+		{
+			valid = false;
+		}
+	private:
+		T value = {};
+		bool valid = false;
+	};
+	struct VertexBufferBinding
+	{
+		ID3D11Buffer* pBuffer;
+		UINT stride;
+		UINT offset;
+		bool operator==(const VertexBufferBinding& rhs) const noexcept
+		{
+			return pBuffer == rhs.pBuffer && stride == rhs.stride && offset == rhs.offset;
+		}
+	};
+	struct ConstantBufferBinding
+	{
+		ID3D11Buffer* pBuffer;
+		// both 0 when the whole buffer is bound
+		UINT firstConstant;
+		UINT numConstants;
+		bool operator==(const ConstantBufferBinding& rhs) const noexcept
+		{
+			return pBuffer == rhs.pBuffer && firstConstant == rhs.firstConstant && numConstants == rhs.numConstants;
+		}
+	};
+	struct IndexBufferBinding
+	{
+		ID3D11Buffer* pBuffer;
+		DXGI_FORMAT format;
+		UINT offset;
+		bool operator==(const IndexBufferBinding& rhs) const noexcept
+		{
+			return pBuffer == rhs.pBuffer && format == rhs.format && offset == rhs.offset;
+		}
+	};
+public:
+	CachedGraphicsContext(GraphicsContext& target) noexcept;
+	// forget all tracked state, needed whenever something binds behind the cache's back
+	void Invalidate() noexcept;
+	const BindStats& GetStats() const noexcept;
+	void ResetStats() noexcept;
+	// folds in the stats of a context whose recording was played back on this one
+	void AddStats(const BindStats& recorded) noexcept;
+
+	void IASetVertexBuffers(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers,
+		const UINT* pStrides, const UINT* pOffsets) noexcept override;
+	void IASetIndexBuffer(ID3D11Buffer* pBuffer, DXGI_FORMAT format, UINT offset) noexcept override;
+	void IASetInputLayout(ID3D11InputLayout* pInputLayout) noexcept override;
+	void IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology) noexcept override;
+	void VSSetShader(ID3D11VertexShader* pShader, ID3D11ClassInstance* const* ppClassInstances,
+		UINT numClassInstances) noexcept override;
+	void PSSetShader(ID3D11PixelShader* pShader, ID3D11ClassInstance* const* ppClassInstances,
+		UINT numClassInstances) noexcept override;
+	void VSSetConstantBuffers(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers) noexcept override;
+	void PSSetConstantBuffers(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers) noexcept override;
+	void VSSetConstantBuffers1(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers,
+		const UINT* pFirstConstant, const UINT* pNumConstants) noexcept override;
+	void PSSetConstantBuffers1(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers,
+		const UINT* pFirstConstant, const UINT* pNumConstants) noexcept override;
+	void PSSetShaderResources(UINT startSlot, UINT numViews,
+		ID3D11ShaderResourceView* const* ppViews) noexcept override;
+	void PSSetSamplers(UINT startSlot, UINT numSamplers, ID3D11SamplerState* const* ppSamplers) noexcept override;
+	void RSSetViewports(UINT numViewports, const D3D11_VIEWPORT* pViewports) noexcept override;
+	void OMSetRenderTargets(UINT numViews, ID3D11RenderTargetView* const* ppViews,
+		ID3D11DepthStencilView* pDepthStencilView) noexcept override;
+	void OMSetDepthStencilState(ID3D11DepthStencilState* pState, UINT stencilRef) noexcept override;
+	void ClearRenderTargetView(ID3D11RenderTargetView* pView, const FLOAT color[4]) noexcept override;
+	void ClearDepthStencilView(ID3D11DepthStencilView* pView, UINT clearFlags, FLOAT depth,
+		UINT8 stencil) noexcept override;
+	HRESULT Map(ID3D11Resource* pResource, UINT subresource, D3D11_MAP mapType, UINT mapFlags,
+		D3D11_MAPPED_SUBRESOURCE* pMappedResource) noexcept override;
+	void Unmap(ID3D11Resource* pResource, UINT subresource) noexcept override;
+	void CopySubresourceRegion(ID3D11Resource* pDstResource, UINT dstSubresource, UINT dstX, UINT dstY, UINT dstZ,
+		ID3D11Resource* pSrcResource, UINT srcSubresource, const D3D11_BOX* pSrcBox) noexcept override;
+	void DrawIndexed(UINT indexCount, UINT startIndexLocation, INT baseVertexLocation) noexcept override;
+	void DrawIndexedInstanced(UINT indexCountPerInstance, UINT instanceCount, UINT startIndexLocation,
+		INT baseVertexLocation, UINT startInstanceLocation) noexcept override;
+private:
+	// updates a run of slots, true if any of them changed
+	template<typename T, size_t N>
+	static bool UpdateSlots(std::array<CachedState<T>, N>& slots, UINT startSlot, UINT num, const T* pValues) noexcept
+	{
+		bool changed = false;
+		for (UINT i = 0; i < num; i++)
+		{
+			if (startSlot + i >= N)
+			{
+				return true;
+			}
+			changed |= slots[startSlot + i].Update(pValues[i]);
+		}
+		return changed;
+	}
+	// null offsets/sizes mean whole buffers, returns how many bindings were filled
+	static UINT MakeConstantBufferBindings(
+		std::array<ConstantBufferBinding, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT>& bindings,
+		UINT numBuffers, ID3D11Buffer* const* ppBuffers, const UINT* pFirstConstant, const UINT* pNumConstants) noexcept;
+	// counts the bind and tells whether it has to go through
+	bool Filter(bool changed) noexcept;
+private:
+	GraphicsContext& target;
+	BindStats stats;
+	std::array<CachedState<VertexBufferBinding>, D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT> vertexBuffers;
+	CachedState<IndexBufferBinding> indexBuffer;
+	CachedState<ID3D11InputLayout*> inputLayout;
+	CachedState<D3D11_PRIMITIVE_TOPOLOGY> topology;
+	CachedState<ID3D11VertexShader*> vertexShader;
+	CachedState<ID3D11PixelShader*> pixelShader;
+	std::array<CachedState<ConstantBufferBinding>, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT> vsConstantBuffers;
+	std::array<CachedState<ConstantBufferBinding>, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT> psConstantBuffers;
+	std::array<CachedState<ID3D11ShaderResourceView*>, D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT> psShaderResources;
+	std::array<CachedState<ID3D11SamplerState*>, D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT> psSamplers;
+};
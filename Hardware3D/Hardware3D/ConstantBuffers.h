@@ -1,6 +1,8 @@
 ﻿#pragma once
 #include "Bindable.h"
 #include "GraphicsErrorMacros.h"
+#include "BindableCodex.h"
+#include "Profiler.h"
 
 namespace Bind
 {
@@ -10,6 +12,7 @@ namespace Bind
 	public:
 		void Update(Graphics& gfx, const C& contents)
 		{
+			PROFILE_ZONE("ConstantBuffer::Update");
 			INFOMAN(gfx);
 
 			D3D11_MAPPED_SUBRESOURCE msr;
@@ -70,6 +73,14 @@ namespace Bind
 		{
 			GetContext(gfx)->VSSetConstantBuffers(slot, 1u, pConstantBuffer.GetAddressOf());
 		}
+		// only buffers created with their contents can be shared, and they must never be updated
+		static std::string GenerateUID(const C& contents, UINT slot = 0u)
+		{
+			auto uid = Codex::MakeUID(typeid(VertexConstantBuffer).name());
+			Codex::AppendUID(uid, &contents, sizeof(contents));
+			Codex::AppendUID(uid, &slot, sizeof(slot));
+			return uid;
+		}
 	};
 
 	template<typename C>
@@ -84,5 +95,13 @@ namespace Bind
 		{
 			GetContext(gfx)->PSSetConstantBuffers(slot, 1u, pConstantBuffer.GetAddressOf());
 		}
+		// only buffers created with their contents can be shared, and they must never be updated
+		static std::string GenerateUID(const C& contents, UINT slot = 0u)
+		{
+			auto uid = Codex::MakeUID(typeid(PixelConstantBuffer).name());
+			Codex::AppendUID(uid, &contents, sizeof(contents));
+			Codex::AppendUID(uid, &slot, sizeof(slot));
+			return uid;
+		}
 	};
 }
@@ -0,0 +1,74 @@
+﻿#include "DeferredContext.h"
+#include "GraphicsErrorMacros.h"
+#include <cassert>
+
+DeferredContext::DeferredContext(Graphics& gfx)
+{
+	INFOMAN(gfx);
+
+	if (gfx.IsHeadless())
+	{
+		auto pNull = std::make_unique<NullGraphicsContext>();
+		pNullContext = pNull.get();
+		pTarget = std::move(pNull);
+	}
+	else
+	{
+		GFX_THROW_INFO(gfx.pDevice->CreateDeferredContext(0u, &pDeferredContext));
+		pTarget = std::make_unique<D3DGraphicsContext>(pDeferredContext);
+	}
+	pContext = std::make_unique<CachedGraphicsContext>(*pTarget);
+}
+
+void DeferredContext::Begin(Graphics& gfx) noexcept
+{
+	// finishing a command list resets the deferred context to default state
+	pContext->Invalidate();
+	pContext->ResetStats();
+	gfx.BindFrameState(*pContext);
+	gfx.BeginRecording(*pContext);
+}
+
+void DeferredContext::Finish(Graphics& gfx)
+{
+	gfx.EndRecording();
+	if (pDeferredContext)
+	{
+		INFOMAN(gfx);
+		GFX_THROW_INFO(pDeferredContext->FinishCommandList(FALSE, &pCommandList));
+	}
+}
+
+void DeferredContext::Execute(Graphics& gfx)
+{
+	if (pDeferredContext)
+	{
+		assert("Executing a recording that was never finished" && pCommandList);
+		static_cast<D3DGraphicsContext&>(*gfx.pDeviceContext).GetD3DContext()->ExecuteCommandList(pCommandList.Get(), FALSE);
+		pCommandList = nullptr;
+	}
+	else
+	{
+		gfx.pCommandLog->Append(pNullContext->GetLog());
+		pNullContext->GetLog().Clear();
+	}
+	gfx.pContext->AddStats(pContext->GetStats());
+
+	// without restoring, executing a command list leaves the immediate context in default state
+	gfx.pContext->Invalidate();
+	gfx.BindFrameState(*gfx.pContext);
+}
+
+const CachedGraphicsContext::BindStats& DeferredContext::GetBindStats() const noexcept
+{
+	return pContext->GetStats();
+}
+
+DxgiInfoManager& DeferredContext::GetInfoManager(Graphics& gfx)
+{
+#ifndef NDEBUG
+	return gfx.infoManager;
+#else
+	throw std::logic_error("Shouldn't be trying to get detailed exceptions in release mode");
+#endif
+}
@@ -0,0 +1,36 @@
+﻿#pragma once
+#include "Graphics.h"
+#include "NullGraphicsContext.h"
+
+// records draws on another thread for the render thread to play back later
+// on a gpu device this is a d3d11 deferred context that finishes into a command list, headless the calls
+// go into a CommandLog of its own that gets appended to the frame's log
+// Begin/Finish run on the recording thread, Execute on the render thread in the order the frame needs
+// a recording starts from default state and does not see anything bound on the immediate context beforehand
+// (RenderQueue::AddFrameBind), executing one resets the immediate context to default state as well. the headless
+// CommandLog does not model state at all, so a missing bind only shows up on a gpu device
+class DeferredContext
+{
+public:
+	DeferredContext(Graphics& gfx);
+	DeferredContext(const DeferredContext&) = delete;
+	DeferredContext& operator=(const DeferredContext&) = delete;
+	// until Finish, bindables and draws issued on this thread against gfx are recorded here
+	// the recording starts out with the frame's render target, depth buffer and viewport bound
+	void Begin(Graphics& gfx) noexcept;
+	void Finish(Graphics& gfx);
+	// plays the recording back on the immediate context and empties it
+	void Execute(Graphics& gfx);
+	// binds issued to / filtered out before the recording by the last Begin/Finish
+	const CachedGraphicsContext::BindStats& GetBindStats() const noexcept;
+private:
+	static DxgiInfoManager& GetInfoManager(Graphics& gfx);
+private:
+	// null headless
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> pDeferredContext;
+	Microsoft::WRL::ComPtr<ID3D11CommandList> pCommandList;
+	// null on a gpu device
+	NullGraphicsContext* pNullContext = nullptr;
+	std::unique_ptr<GraphicsContext> pTarget;
+	std::unique_ptr<CachedGraphicsContext> pContext;
+};
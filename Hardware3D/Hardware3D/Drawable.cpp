@@ -1,12 +1,26 @@
 ﻿#include "Drawable.h"
 #include "GraphicsErrorMacros.h"
-#include "IndexBuffer.h"
+#include "BindableCommon.h"
+#include "RenderQueue.h"
+#include "InstanceBuffer.h"
+#include "Profiler.h"
 #include <cassert>
 
 using namespace Bind;
 
+namespace
+{
+	// the parts of a drawable that InstancedBinds stands in for
+	bool IsReplacedWhenInstanced(const Bindable& b) noexcept
+	{
+		return dynamic_cast<const VertexShader*>(&b) || dynamic_cast<const InputLayout*>(&b) ||
+			dynamic_cast<const TransformCbuf*>(&b);
+	}
+}
+
 void Drawable::Draw(Graphics& gfx) const noxnd
 {
+	PROFILE_ZONE("Drawable::Draw");
 	for (auto& b : binds)
 	{
 		b->Bind(gfx);
@@ -18,15 +32,128 @@ void Drawable::Draw(Graphics& gfx) const noxnd
 	gfx.DrawIndexed(pIndexBuffer->GetCount());
 }
 
-void Drawable::AddBind(std::unique_ptr<Bindable> bind) noxnd
+void Drawable::Draw(Graphics& gfx, DirectX::FXMMATRIX transform) const noxnd
+{
+	Draw(gfx);
+}
+
+void Drawable::Stage(Graphics& gfx) const
+{
+	for (auto& b : binds)
+	{
+		b->Stage(gfx);
+	}
+	for (auto& b : GetStaticBinds())
+	{
+		b->Stage(gfx);
+	}
+}
+
+void Drawable::Stage(Graphics& gfx, DirectX::FXMMATRIX transform) const
+{
+	Stage(gfx);
+}
+
+bool Drawable::SupportsInstancing() const noexcept
+{
+	return pInstancedBinds != nullptr;
+}
+
+void Drawable::DrawInstanced(Graphics& gfx, const DirectX::XMFLOAT4X4* pTransforms, UINT count) const noxnd
+{
+	PROFILE_ZONE("Drawable::DrawInstanced");
+	assert("Drawable has no instanced binds" && pInstancedBinds);
+	for (auto& b : binds)
+	{
+		if (!IsReplacedWhenInstanced(*b))
+		{
+			b->Bind(gfx);
+		}
+	}
+	for (auto& b : GetStaticBinds())
+	{
+		if (!IsReplacedWhenInstanced(*b))
+		{
+			b->Bind(gfx);
+		}
+	}
+	pInstancedBinds->Bind(gfx, pTransforms, count);
+	gfx.DrawIndexedInstanced(pIndexBuffer->GetCount(), count);
+}
+
+void Drawable::StageInstanced(Graphics& gfx, UINT count) const
+{
+	assert("Drawable has no instanced binds" && pInstancedBinds);
+	pInstancedBinds->Reserve(gfx, count);
+}
+
+void Drawable::Submit(RenderQueue& queue) const
+{
+	Submit(queue, GetTransformXM());
+}
+
+void Drawable::Submit(RenderQueue& queue, DirectX::FXMMATRIX transform) const
+{
+	queue.Submit(*this, GetStateKey(), transform);
+}
+
+std::uint64_t Drawable::GetStateKey() const noexcept
+{
+	if (!stateKeyValid)
+	{
+		unsigned int vertexShader = 0u;
+		unsigned int pixelShader = 0u;
+		unsigned int vertexBuffer = 0u;
+		unsigned int material = 0u;
+		const auto accumulate = [&](const Bindable& b)
+		{
+			if (dynamic_cast<const VertexShader*>(&b))
+			{
+				vertexShader = b.GetSortId();
+			}
+			else if (dynamic_cast<const PixelShader*>(&b))
+			{
+				pixelShader = b.GetSortId();
+			}
+			else if (dynamic_cast<const VertexBuffer*>(&b))
+			{
+				vertexBuffer = b.GetSortId();
+			}
+			else if (!dynamic_cast<const IndexBuffer*>(&b) && !dynamic_cast<const TransformCbuf*>(&b) &&
+				!dynamic_cast<const InputLayout*>(&b) && !dynamic_cast<const Topology*>(&b))
+			{
+				// whatever is left (constant buffers, textures, samplers) makes up the material
+				material = material * 31u + b.GetSortId() + 1u;
+			}
+		};
+		for (const auto& b : binds)
+		{
+			accumulate(*b);
+		}
+		for (const auto& b : GetStaticBinds())
+		{
+			accumulate(*b);
+		}
+		stateKey = RenderQueue::MakeStateKey(vertexShader, pixelShader, material, vertexBuffer);
+		stateKeyValid = true;
+	}
+	return stateKey;
+}
+
+void Drawable::AddBind(std::shared_ptr<Bindable> bind) noxnd
 {
 	assert("*Must* use AddIndexBuffer to bind index buffer" && typeid(&bind) != typeid(IndexBuffer));
 	binds.push_back(std::move(bind));
 }
 
-void Drawable::AddIndexBuffer(std::unique_ptr<IndexBuffer> iBuf) noxnd
+void Drawable::AddIndexBuffer(std::shared_ptr<IndexBuffer> iBuf) noxnd
 {
 	assert("Attempting to add index buffer a second time" && pIndexBuffer == nullptr);
 	pIndexBuffer = iBuf.get();
 	binds.push_back(std::move(iBuf));
+}
+
+void Drawable::SetInstancedBinds(std::shared_ptr<Bind::InstancedBinds> pBinds) noexcept
+{
+	pInstancedBinds = std::move(pBinds);
 }
\ No newline at end of file
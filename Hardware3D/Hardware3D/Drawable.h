@@ -1,14 +1,19 @@
 ﻿#pragma once
 #include "Graphics.h"
 #include <DirectXMath.h>
+#include <cstdint>
+#include <memory>
 #include "ConditionalNoExcept.h"
 
 namespace Bind
 {
 	class Bindable;
 	class IndexBuffer;
+	class InstancedBinds;
 }
 
+class RenderQueue;
+
 class Drawable
 {
 	template<class T>
@@ -19,6 +24,19 @@ public:
 	Drawable(const Drawable&) = delete;
 	virtual DirectX::XMMATRIX GetTransformXM() const noexcept = 0;
 	void Draw(Graphics& gfx) const noxnd;
+	// draw with the transform captured when the drawable was submitted to a render queue,
+	// drawables that take their transform from GetTransformXM() can ignore it
+	virtual void Draw(Graphics& gfx, DirectX::FXMMATRIX transform) const noxnd;
+	// stages the binds of a draw that will follow once the render queue has flushed the frame constants
+	void Stage(Graphics& gfx) const;
+	virtual void Stage(Graphics& gfx, DirectX::FXMMATRIX transform) const;
+	void Submit(RenderQueue& queue) const;
+	void Submit(RenderQueue& queue, DirectX::FXMMATRIX transform) const;
+	bool SupportsInstancing() const noexcept;
+	// count copies in a single draw, vertex shader / input layout / TransformCbuf are swapped for the instanced binds
+	void DrawInstanced(Graphics& gfx, const DirectX::XMFLOAT4X4* pTransforms, UINT count) const noxnd;
+	// makes room for an instanced draw of count copies ahead of recording it
+	void StageInstanced(Graphics& gfx, UINT count) const;
 	virtual void Update(float dt) noexcept{}
 	virtual ~Drawable() = default;
 protected:
@@ -34,11 +52,19 @@ protected:
 		}
 		return nullptr;
 	}
-	void AddBind(std::unique_ptr<Bind::Bindable> bind) noxnd;
-	void AddIndexBuffer(std::unique_ptr<Bind::IndexBuffer> iBuf) noxnd;
+	// binds can be shared with other drawables (see Bind::Codex)
+	void AddBind(std::shared_ptr<Bind::Bindable> bind) noxnd;
+	void AddIndexBuffer(std::shared_ptr<Bind::IndexBuffer> iBuf) noxnd;
+	void SetInstancedBinds(std::shared_ptr<Bind::InstancedBinds> pBinds) noexcept;
 private:
 	virtual const std::vector<std::unique_ptr<Bind::Bindable>>& GetStaticBinds() const noexcept = 0;
+	// shader / material / vertex buffer part of the render queue sort key
+	std::uint64_t GetStateKey() const noexcept;
 private:
 	const Bind::IndexBuffer* pIndexBuffer = nullptr;
-	std::vector<std::unique_ptr<Bind::Bindable>> binds;
+	// binds don't change after construction, so the state key is built on first submit
+	mutable std::uint64_t stateKey = 0u;
+	mutable bool stateKeyValid = false;
+	std::vector<std::shared_ptr<Bind::Bindable>> binds;
+	std::shared_ptr<Bind::InstancedBinds> pInstancedBinds;
 };
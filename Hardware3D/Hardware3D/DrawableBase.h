@@ -22,6 +22,15 @@ protected:
 		pIndexBuffer = iBuf.get();
 		staticBinds.push_back(std::move(iBuf));
 	}
+	// instanced binds shared by every drawable of the class, like the static binds
+	static void SetStaticInstancedBinds(std::shared_ptr<Bind::InstancedBinds> pBinds) noexcept
+	{
+		staticInstancedBinds = std::move(pBinds);
+	}
+	void SetInstancedFromStatic() noexcept
+	{
+		SetInstancedBinds(staticInstancedBinds);
+	}
 	void SetIndexFromStatic() noxnd
 	{
 		assert("Attempting to add index buffer a second time" && pIndexBuffer == nullptr);
@@ -42,7 +51,11 @@ private:
 	}
 private:
 	static std::vector<std::unique_ptr<Bind::Bindable>> staticBinds;
+	static std::shared_ptr<Bind::InstancedBinds> staticInstancedBinds;
 };
 
 template<class T>
-std::vector<std::unique_ptr<Bind::Bindable>> DrawableBase<T>::staticBinds;
\ No newline at end of file
+std::vector<std::unique_ptr<Bind::Bindable>> DrawableBase<T>::staticBinds;
+
+template<class T>
+std::shared_ptr<Bind::InstancedBinds> DrawableBase<T>::staticInstancedBinds;
\ No newline at end of file
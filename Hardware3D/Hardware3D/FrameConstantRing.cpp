@@ -0,0 +1,108 @@
+﻿#include "FrameConstantRing.h"
+#include "GraphicsErrorMacros.h"
+#include <cassert>
+#include <cstring>
+
+FrameConstantRing::FrameConstantRing(Graphics& gfx, size_t capacity)
+{
+	CreateBuffer(gfx, capacity);
+}
+
+FrameConstantRing::Allocation FrameConstantRing::Stage(const void* pData, size_t size)
+{
+	const size_t padded = (size + alignment - 1u) / alignment * alignment;
+	assert("Constants too large for a single constant buffer" && padded <= maxAllocation);
+
+	const size_t offset = staging.size();
+	staging.resize(offset + padded);
+	memcpy(staging.data() + offset, pData, size);
+	stats.allocations++;
+	stats.bytes += padded;
+	return { offset, UINT(padded / 16u) };
+}
+
+void FrameConstantRing::Flush(Graphics& gfx)
+{
+	if (staging.empty())
+	{
+		return;
+	}
+	INFOMAN(gfx);
+
+	if (staging.size() > capacity)
+	{
+		// whatever was bound from the old buffer keeps it alive until the gpu is done with it
+		size_t newCapacity = capacity;
+		while (newCapacity < staging.size())
+		{
+			newCapacity *= 2u;
+		}
+		CreateBuffer(gfx, newCapacity);
+	}
+
+	// space behind the head hasn't been handed out since the last discard, so the gpu can't be reading it
+	D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+	if (fresh || head + staging.size() > capacity)
+	{
+		mapType = D3D11_MAP_WRITE_DISCARD;
+		head = 0u;
+		fresh = false;
+	}
+
+	D3D11_MAPPED_SUBRESOURCE msr;
+	GFX_THROW_INFO(gfx.pContext->Map(pBuffer.Get(), 0u, mapType, 0u, &msr));
+	memcpy(static_cast<char*>(msr.pData) + head, staging.data(), staging.size());
+	gfx.pContext->Unmap(pBuffer.Get(), 0u);
+	stats.maps++;
+
+	flushBase = head;
+	head += staging.size();
+	staging.clear();
+}
+
+UINT FrameConstantRing::GetFirstConstant(const Allocation& allocation) const noexcept
+{
+	return UINT((flushBase + allocation.offset) / 16u);
+}
+
+ID3D11Buffer* FrameConstantRing::GetBuffer() const noexcept
+{
+	return pBuffer.Get();
+}
+
+const FrameConstantRing::Stats& FrameConstantRing::GetStats() const noexcept
+{
+	return stats;
+}
+
+void FrameConstantRing::ResetStats() noexcept
+{
+	stats = {};
+}
+
+void FrameConstantRing::CreateBuffer(Graphics& gfx, size_t size)
+{
+	INFOMAN(gfx);
+
+	D3D11_BUFFER_DESC bufDesc = {};
+	bufDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	bufDesc.Usage = D3D11_USAGE_DYNAMIC;
+	bufDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	bufDesc.MiscFlags = 0u;
+	bufDesc.ByteWidth = UINT(size);
+	bufDesc.StructureByteStride = 0u;
+	GFX_THROW_INFO(gfx.pDevice->CreateBuffer(&bufDesc, nullptr, &pBuffer));
+
+	capacity = size;
+	head = 0u;
+	fresh = true;
+}
+
+DxgiInfoManager& FrameConstantRing::GetInfoManager(Graphics& gfx)
+{
+#ifndef NDEBUG
+	return gfx.infoManager;
+#else
+	throw std::logic_error("Shouldn't be trying to get detailed exceptions in release mode");
+#endif
+}
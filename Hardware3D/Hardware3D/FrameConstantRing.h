@@ -0,0 +1,57 @@
+﻿#pragma once
+#include "Graphics.h"
+#include <vector>
+
+// per-frame constant data sub-allocated out of one large dynamic buffer
+// draws stage their constants on the cpu first, Flush then uploads everything staged since the
+// last flush with a single map and the draws bind their window of the buffer by constant offset
+class FrameConstantRing
+{
+public:
+	// a staged block, only addressable on the gpu after the next Flush
+	struct Allocation
+	{
+		// bytes from the start of the staged data
+		size_t offset;
+		UINT numConstants;
+	};
+	struct Stats
+	{
+		size_t allocations = 0u;
+		size_t bytes = 0u;
+		size_t maps = 0u;
+	};
+	// *SetConstantBuffers1 windows start on and span multiples of 16 constants
+	static constexpr size_t alignment = 256u;
+	static constexpr size_t maxAllocation = D3D11_REQ_CONSTANT_BUFFER_ELEMENT_COUNT * 16u;
+public:
+	FrameConstantRing(Graphics& gfx, size_t capacity = 1024u * 1024u);
+	Allocation Stage(const void* pData, size_t size);
+	template<typename C>
+	Allocation Stage(const C& contents)
+	{
+		return Stage(&contents, sizeof(C));
+	}
+	// copies the staged blocks in behind the last flush (no-overwrite), wrapping around to the
+	// start with a discard when they don't fit and growing the buffer when it is too small
+	void Flush(Graphics& gfx);
+	// first constant of an allocation staged before the last Flush
+	UINT GetFirstConstant(const Allocation& allocation) const noexcept;
+	ID3D11Buffer* GetBuffer() const noexcept;
+	// counted since the last ResetStats
+	const Stats& GetStats() const noexcept;
+	void ResetStats() noexcept;
+private:
+	void CreateBuffer(Graphics& gfx, size_t size);
+	static DxgiInfoManager& GetInfoManager(Graphics& gfx);
+private:
+	Microsoft::WRL::ComPtr<ID3D11Buffer> pBuffer;
+	size_t capacity = 0u;
+	// where the next flush starts writing and where the last one did
+	size_t head = 0u;
+	size_t flushBase = 0u;
+	// nothing written since the buffer was created, the first map has to discard
+	bool fresh = true;
+	std::vector<char> staging;
+	Stats stats;
+};
@@ -0,0 +1,77 @@
+﻿#include "Frustum.h"
+
+namespace dx = DirectX;
+
+Frustum::Frustum(DirectX::FXMMATRIX viewProjection) noexcept
+{
+	// planes straight from the matrix columns (Gribb, Hartmann), d3d clip space has 0 <= z <= w
+	const auto m = dx::XMMatrixTranspose(viewProjection);
+	dx::XMVECTOR planes[8] = {
+		dx::XMVectorAdd(m.r[3], m.r[0]),
+		dx::XMVectorSubtract(m.r[3], m.r[0]),
+		dx::XMVectorAdd(m.r[3], m.r[1]),
+		dx::XMVectorSubtract(m.r[3], m.r[1]),
+		m.r[2],
+		dx::XMVectorSubtract(m.r[3], m.r[2]),
+	};
+	// the second group only has two planes, repeating them keeps every lane meaningful
+	planes[6] = planes[4];
+	planes[7] = planes[5];
+
+	for (int group = 0; group < 2; group++)
+	{
+		auto group4 = dx::XMMATRIX(
+			dx::XMPlaneNormalize(planes[group * 4 + 0]),
+			dx::XMPlaneNormalize(planes[group * 4 + 1]),
+			dx::XMPlaneNormalize(planes[group * 4 + 2]),
+			dx::XMPlaneNormalize(planes[group * 4 + 3])
+		);
+		group4 = dx::XMMatrixTranspose(group4);
+		planeX[group] = group4.r[0];
+		planeY[group] = group4.r[1];
+		planeZ[group] = group4.r[2];
+		planeW[group] = group4.r[3];
+	}
+}
+
+Frustum::Result Frustum::Test(const Bounds& bounds) const noexcept
+{
+	if (bounds.IsEmpty())
+	{
+		return Result::Outside;
+	}
+	const auto cx = dx::XMVectorReplicate(bounds.center.x);
+	const auto cy = dx::XMVectorReplicate(bounds.center.y);
+	const auto cz = dx::XMVectorReplicate(bounds.center.z);
+	const auto ex = dx::XMVectorReplicate(bounds.extents.x);
+	const auto ey = dx::XMVectorReplicate(bounds.extents.y);
+	const auto ez = dx::XMVectorReplicate(bounds.extents.z);
+	const auto radius = dx::XMVectorReplicate(bounds.radius);
+	const auto zero = dx::XMVectorZero();
+
+	bool inside = true;
+	for (int group = 0; group < 2; group++)
+	{
+		// signed distance of the center to four planes at once
+		const auto distance = dx::XMVectorMultiplyAdd(planeX[group], cx,
+			dx::XMVectorMultiplyAdd(planeY[group], cy,
+				dx::XMVectorMultiplyAdd(planeZ[group], cz, planeW[group])));
+		// sphere fully behind any plane
+		if (!dx::XMVector4GreaterOrEqual(dx::XMVectorAdd(distance, radius), zero))
+		{
+			return Result::Outside;
+		}
+		// projected half size of the box onto each plane normal
+		const auto reach = dx::XMVectorMultiplyAdd(dx::XMVectorAbs(planeX[group]), ex,
+			dx::XMVectorMultiplyAdd(dx::XMVectorAbs(planeY[group]), ey,
+				dx::XMVectorMultiply(dx::XMVectorAbs(planeZ[group]), ez)));
+		if (!dx::XMVector4GreaterOrEqual(dx::XMVectorAdd(distance, reach), zero))
+		{
+			return Result::Outside;
+		}
+		// both volumes hold every point, so a plane is cleared once either of them clears it
+		const auto clearance = dx::XMVectorMin(reach, radius);
+		inside = inside && dx::XMVector4GreaterOrEqual(distance, clearance);
+	}
+	return inside ? Result::Inside : Result::Intersects;
+}
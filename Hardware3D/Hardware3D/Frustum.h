@@ -0,0 +1,25 @@
+﻿#pragma once
+#include "Bounds.h"
+
+// six planes of a view volume, tested four at a time
+// planes are kept transposed (all x, all y, ...) so one vector op covers four plane distances
+class Frustum
+{
+public:
+	enum class Result
+	{
+		Outside,
+		Intersects,
+		Inside,
+	};
+public:
+	// planes come out in the space the matrix maps from, world space for camera * projection
+	Frustum(DirectX::FXMMATRIX viewProjection) noexcept;
+	Result Test(const Bounds& bounds) const noexcept;
+private:
+	// left, right, bottom, top | near, far, near, far
+	DirectX::XMVECTOR planeX[2];
+	DirectX::XMVECTOR planeY[2];
+	DirectX::XMVECTOR planeZ[2];
+	DirectX::XMVECTOR planeW[2];
+};
@@ -4,6 +4,10 @@
 #include <d3dcompiler.h>
 #include <DirectXMath.h>
 #include "GraphicsErrorMacros.h"
+#include "NullGraphicsContext.h"
+#include "FrameConstantRing.h"
+#include "BindableCodex.h"
+#include "Profiler.h"
 #include "imgui/imgui_impl_dx11.h"
 #include "imgui/imgui_impl_win32.h"
 
@@ -13,6 +17,17 @@ namespace dx = DirectX;
 #pragma comment(lib, "d3d11.lib")
 #pragma comment(lib, "D3DCompiler.lib")
 
+namespace
+{
+	// set while a thread records through a DeferredContext, draws against that Graphics from the
+	// thread go to the recording context instead of the immediate one
+	struct Recording
+	{
+		const Graphics* pGfx = nullptr;
+		CachedGraphicsContext* pContext = nullptr;
+	};
+	thread_local Recording recording;
+}
 
 Graphics::Graphics(HWND hWnd, UINT width, UINT height)
 {
@@ -42,6 +57,7 @@ Graphics::Graphics(HWND hWnd, UINT width, UINT height)
 	HRESULT hr;
 
 	// create device, front/back buffers, swap chain, rendering context
+	wrl::ComPtr<ID3D11DeviceContext> pImmediateContext;
 	GFX_THROW_INFO(D3D11CreateDeviceAndSwapChain(
 		nullptr,
 		D3D_DRIVER_TYPE_HARDWARE,
@@ -54,8 +70,12 @@ Graphics::Graphics(HWND hWnd, UINT width, UINT height)
 		&pSwap,
 		&pDevice,
 		nullptr,
-		&pContext
+		&pImmediateContext
 	));
+	pDeviceContext = std::make_unique<D3DGraphicsContext>(pImmediateContext);
+	pContext = std::make_unique<CachedGraphicsContext>(*pDeviceContext);
+	CreateFrameConstants();
+	pCodex = std::make_unique<Bind::Codex>();
 
 	// gain access to texture sub-resource in swap chain (back buffer)
 	wrl::ComPtr<ID3D11Resource> pBackBuffer;
@@ -67,11 +87,7 @@ Graphics::Graphics(HWND hWnd, UINT width, UINT height)
 	depthDesc.DepthEnable = TRUE;
 	depthDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
 	depthDesc.DepthFunc = D3D11_COMPARISON_LESS;
-	wrl::ComPtr<ID3D11DepthStencilState> pDepthSState;
-	GFX_THROW_INFO(pDevice->CreateDepthStencilState(&depthDesc, &pDepthSState));
-
-	// bind depth state
-	pContext->OMSetDepthStencilState(pDepthSState.Get(), 1u);
+	GFX_THROW_INFO(pDevice->CreateDepthStencilState(&depthDesc, &pDepthState));
 
 	// create depth stencil texture
 	wrl::ComPtr<ID3D11Texture2D> pDepthStencil;
@@ -96,30 +112,82 @@ Graphics::Graphics(HWND hWnd, UINT width, UINT height)
 
 	GFX_THROW_INFO(pDevice->CreateDepthStencilView(pDepthStencil.Get(), &dsvDesc, &pDSV));
 
-	// bind depth stencil view to OM
-	pContext->OMSetRenderTargets(1u, pTarget.GetAddressOf(), pDSV.Get());
-
 	// configure viewport
-	D3D11_VIEWPORT vp{};
-	vp.Width = (FLOAT)width;
-	vp.Height = (FLOAT)height;
-	vp.MinDepth = 0.0f;
-	vp.MaxDepth = 1.0f;
-	vp.TopLeftX = 0.0f;
-	vp.TopLeftY = 0.0f;
-	pContext->RSSetViewports(1u, &vp);
+	viewport.Width = (FLOAT)width;
+	viewport.Height = (FLOAT)height;
+	viewport.MinDepth = 0.0f;
+	viewport.MaxDepth = 1.0f;
+	viewport.TopLeftX = 0.0f;
+	viewport.TopLeftY = 0.0f;
+
+	// bind depth state, depth stencil view and viewport
+	BindFrameState(*pContext);
 
 	// init imgui d3d impl
-	ImGui_ImplDX11_Init(pDevice.Get(), pContext.Get());
+	ImGui_ImplDX11_Init(pDevice.Get(), pImmediateContext.Get());
+}
+
+Graphics::Graphics(UINT width, UINT height)
+	:
+	imGuiEnabled(false)
+{
+	UINT deviceCreateFlags = 0u;
+#ifndef NDEBUG
+	deviceCreateFlags |= D3D11_CREATE_DEVICE_DEBUG;
+#endif
+
+	// for checking results of d3d functions
+	HRESULT hr;
+
+	// warp device only backs resource creation so bindables can be built as usual,
+	// its immediate context is never used
+	GFX_THROW_INFO(D3D11CreateDevice(
+		nullptr,
+		D3D_DRIVER_TYPE_WARP,
+		nullptr,
+		deviceCreateFlags,
+		nullptr,
+		0,
+		D3D11_SDK_VERSION,
+		&pDevice,
+		nullptr,
+		nullptr
+	));
+
+	auto pNullContext = std::make_unique<NullGraphicsContext>();
+	pCommandLog = &pNullContext->GetLog();
+	pDeviceContext = std::move(pNullContext);
+	pContext = std::make_unique<CachedGraphicsContext>(*pDeviceContext);
+	CreateFrameConstants();
+	pCodex = std::make_unique<Bind::Codex>();
+
+	// configure viewport
+	viewport.Width = (FLOAT)width;
+	viewport.Height = (FLOAT)height;
+	viewport.MinDepth = 0.0f;
+	viewport.MaxDepth = 1.0f;
+	viewport.TopLeftX = 0.0f;
+	viewport.TopLeftY = 0.0f;
+	BindFrameState(*pContext);
 }
 
 Graphics::~Graphics()
 {
-	ImGui_ImplDX11_Shutdown();
+	if (!IsHeadless())
+	{
+		ImGui_ImplDX11_Shutdown();
+	}
 }
 
 void Graphics::EndFrame()
 {
+	PROFILE_ZONE("Graphics::EndFrame");
+	// nothing to present without a swap chain
+	if (IsHeadless())
+	{
+		return;
+	}
+
 	// imgui frame end
 	if (imGuiEnabled)
 	{
@@ -148,8 +216,21 @@ void Graphics::EndFrame()
 
 void Graphics::BeginFrame(float red, float green, float blue) noexcept
 {
+	// headless frames start from an empty log
+	if (pCommandLog)
+	{
+		pCommandLog->Clear();
+	}
+	// imgui binds straight to the d3d context, so assume nothing about what is bound
+	pContext->Invalidate();
+	pContext->ResetStats();
+	if (pFrameConstants)
+	{
+		pFrameConstants->ResetStats();
+	}
+
 	// imgui begin frame
-	if(imGuiEnabled)
+	if(imGuiEnabled && !IsHeadless())
 	{
 		ImGui_ImplDX11_NewFrame();
 		ImGui_ImplWin32_NewFrame();
@@ -181,9 +262,62 @@ void Graphics::ToggleImGui() noexcept
 	imGuiEnabled = !imGuiEnabled;
 }
 
+bool Graphics::IsHeadless() const noexcept
+{
+	return pSwap == nullptr;
+}
+
+const CommandLog* Graphics::GetCommandLog() const noexcept
+{
+	return pCommandLog;
+}
+
+const CachedGraphicsContext::BindStats& Graphics::GetBindStats() const noexcept
+{
+	return pContext->GetStats();
+}
+
 void Graphics::DrawIndexed(UINT count) noxnd
 {
-	GFX_THROW_INFO_ONLY(pContext->DrawIndexed(count, 0u, 0u));
+	GFX_THROW_INFO_ONLY(GetCurrentContext().DrawIndexed(count, 0u, 0u));
+}
+
+void Graphics::DrawIndexedInstanced(UINT count, UINT instanceCount) noxnd
+{
+	GFX_THROW_INFO_ONLY(GetCurrentContext().DrawIndexedInstanced(count, instanceCount, 0u, 0u, 0u));
+}
+
+void Graphics::BindFrameState(GraphicsContext& context) noexcept
+{
+	// headless there is nothing to render into
+	if (pDepthState)
+	{
+		context.OMSetDepthStencilState(pDepthState.Get(), 1u);
+	}
+	if (pTarget)
+	{
+		context.OMSetRenderTargets(1u, pTarget.GetAddressOf(), pDSV.Get());
+	}
+	context.RSSetViewports(1u, &viewport);
+}
+
+CachedGraphicsContext& Graphics::GetCurrentContext() noexcept
+{
+	if (recording.pGfx == this)
+	{
+		return *recording.pContext;
+	}
+	return *pContext;
+}
+
+void Graphics::BeginRecording(CachedGraphicsContext& context) noexcept
+{
+	recording = { this, &context };
+}
+
+void Graphics::EndRecording() noexcept
+{
+	recording = {};
 }
 
 void Graphics::SetProjection(DirectX::FXMMATRIX proj) noexcept
@@ -313,3 +447,24 @@ const char* Graphics::DeviceRemovedException::GetType() const noexcept
 {
 	return "Half-Way Engine Graphics Exception [Device Removed] (DXGI_ERROR_DEVICE_REMOVED)";
 }
+
+FrameConstantRing* Graphics::GetFrameConstants() noexcept
+{
+	return pFrameConstants.get();
+}
+
+const FrameConstantRing* Graphics::GetFrameConstants() const noexcept
+{
+	return pFrameConstants.get();
+}
+
+void Graphics::CreateFrameConstants()
+{
+	// binding with offsets and no-overwrite maps of constant buffers both arrived with d3d11.1
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+	if (SUCCEEDED(pDevice->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))) &&
+		options.ConstantBufferOffsetting && options.MapNoOverwriteOnDynamicConstantBuffer)
+	{
+		pFrameConstants = std::make_unique<FrameConstantRing>(*this);
+	}
+}
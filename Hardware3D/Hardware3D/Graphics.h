@@ -11,16 +11,25 @@
 #include <memory>
 #include <random>
 #include "ConditionalNoExcept.h"
+#include "CachedGraphicsContext.h"
+
+class CommandLog;
+class FrameConstantRing;
+class DeferredContext;
 
 namespace Bind
 {
 	class Bindable;
+	class Codex;
 }
 
 
 class Graphics
 {
 	friend class Bind::Bindable;
+	friend class Bind::Codex;
+	friend class FrameConstantRing;
+	friend class DeferredContext;
 public:
 	class Exception : public D3DException
 	{
@@ -60,6 +69,9 @@ public:
 	};
 public:
 	Graphics(HWND hWnd, UINT width = 1200, UINT height = 800);
+	// headless graphics, resources are created on a software device and every context call is
+	// recorded into a CommandLog instead of being executed, no window or gpu required
+	Graphics(UINT width, UINT height);
 	Graphics(const Graphics&) = delete;
 	Graphics(const Graphics&&) = delete;
 	Graphics& operator=(const Graphics&) = delete;
@@ -69,6 +81,8 @@ public:
 	void EndFrame();
 	void BeginFrame(float red, float green, float blue) noexcept;
 	void DrawIndexed(UINT count) noxnd;
+	// count indices per instance, the per-instance data comes from whatever stream is bound as instance data
+	void DrawIndexedInstanced(UINT count, UINT instanceCount) noxnd;
 	void SetProjection(DirectX::FXMMATRIX proj) noexcept;
 	DirectX::XMMATRIX GetProjection() const noexcept;
 	void SetCamera(DirectX::FXMMATRIX cam) noexcept;
@@ -77,6 +91,22 @@ public:
 	void DisableImGui() noexcept;
 	bool IsImGuiEnabled() const noexcept;
 	void ToggleImGui() noexcept;
+	bool IsHeadless() const noexcept;
+	// commands recorded since the last BeginFrame, nullptr unless headless
+	const CommandLog* GetCommandLog() const noexcept;
+	// binds issued to / filtered out before the device context since the last BeginFrame
+	const CachedGraphicsContext::BindStats& GetBindStats() const noexcept;
+	// ring for per-draw constants, nullptr when the device can't bind constant buffers with offsets (pre d3d11.1)
+	FrameConstantRing* GetFrameConstants() noexcept;
+	const FrameConstantRing* GetFrameConstants() const noexcept;
+private:
+	void CreateFrameConstants();
+	// render target, depth buffer/state and viewport every frame draws with
+	void BindFrameState(GraphicsContext& context) noexcept;
+	// the immediate context, or the one this thread records into between BeginRecording and EndRecording
+	CachedGraphicsContext& GetCurrentContext() noexcept;
+	void BeginRecording(CachedGraphicsContext& context) noexcept;
+	void EndRecording() noexcept;
 private:
 	bool imGuiEnabled = true;
 	DirectX::XMMATRIX projection;
@@ -87,7 +117,14 @@ private:
 	
 	Microsoft::WRL::ComPtr<ID3D11Device> pDevice;
 	Microsoft::WRL::ComPtr<IDXGISwapChain> pSwap;
-	Microsoft::WRL::ComPtr<ID3D11DeviceContext> pContext;
+	std::unique_ptr<GraphicsContext> pDeviceContext;
+	std::unique_ptr<CachedGraphicsContext> pContext;
+	CommandLog* pCommandLog = nullptr;
+	std::unique_ptr<FrameConstantRing> pFrameConstants;
+	// shared bindables are device objects, so each Graphics keeps its own registry
+	std::unique_ptr<Bind::Codex> pCodex;
 	Microsoft::WRL::ComPtr<ID3D11RenderTargetView> pTarget;
 	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> pDSV;
+	Microsoft::WRL::ComPtr<ID3D11DepthStencilState> pDepthState;
+	D3D11_VIEWPORT viewport = {};
 };
@@ -0,0 +1,139 @@
+﻿#include "GraphicsContext.h"
+#include <cassert>
+
+D3DGraphicsContext::D3DGraphicsContext(Microsoft::WRL::ComPtr<ID3D11DeviceContext> pContext) noexcept
+	:
+	pContext(std::move(pContext))
+{
+	// only there on d3d11.1 and later, callers check the device options before binding with offsets
+	this->pContext.As(&pContext1);
+}
+
+ID3D11DeviceContext* D3DGraphicsContext::GetD3DContext() const noexcept
+{
+	return pContext.Get();
+}
+
+void D3DGraphicsContext::IASetVertexBuffers(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers,
+                                            const UINT* pStrides, const UINT* pOffsets) noexcept
+{
+	pContext->IASetVertexBuffers(startSlot, numBuffers, ppBuffers, pStrides, pOffsets);
+}
+
+void D3DGraphicsContext::IASetIndexBuffer(ID3D11Buffer* pBuffer, DXGI_FORMAT format, UINT offset) noexcept
+{
+	pContext->IASetIndexBuffer(pBuffer, format, offset);
+}
+
+void D3DGraphicsContext::IASetInputLayout(ID3D11InputLayout* pInputLayout) noexcept
+{
+	pContext->IASetInputLayout(pInputLayout);
+}
+
+void D3DGraphicsContext::IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology) noexcept
+{
+	pContext->IASetPrimitiveTopology(topology);
+}
+
+void D3DGraphicsContext::VSSetShader(ID3D11VertexShader* pShader, ID3D11ClassInstance* const* ppClassInstances,
+                                     UINT numClassInstances) noexcept
+{
+	pContext->VSSetShader(pShader, ppClassInstances, numClassInstances);
+}
+
+void D3DGraphicsContext::PSSetShader(ID3D11PixelShader* pShader, ID3D11ClassInstance* const* ppClassInstances,
+                                     UINT numClassInstances) noexcept
+{
+	pContext->PSSetShader(pShader, ppClassInstances, numClassInstances);
+}
+
+void D3DGraphicsContext::VSSetConstantBuffers(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers) noexcept
+{
+	pContext->VSSetConstantBuffers(startSlot, numBuffers, ppBuffers);
+}
+
+void D3DGraphicsContext::PSSetConstantBuffers(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers) noexcept
+{
+	pContext->PSSetConstantBuffers(startSlot, numBuffers, ppBuffers);
+}
+
+void D3DGraphicsContext::VSSetConstantBuffers1(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers,
+                                               const UINT* pFirstConstant, const UINT* pNumConstants) noexcept
+{
+	assert("Constant buffer offsets need d3d11.1" && pContext1);
+	pContext1->VSSetConstantBuffers1(startSlot, numBuffers, ppBuffers, pFirstConstant, pNumConstants);
+}
+
+void D3DGraphicsContext::PSSetConstantBuffers1(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers,
+                                               const UINT* pFirstConstant, const UINT* pNumConstants) noexcept
+{
+	assert("Constant buffer offsets need d3d11.1" && pContext1);
+	pContext1->PSSetConstantBuffers1(startSlot, numBuffers, ppBuffers, pFirstConstant, pNumConstants);
+}
+
+void D3DGraphicsContext::PSSetShaderResources(UINT startSlot, UINT numViews,
+                                              ID3D11ShaderResourceView* const* ppViews) noexcept
+{
+	pContext->PSSetShaderResources(startSlot, numViews, ppViews);
+}
+
+void D3DGraphicsContext::PSSetSamplers(UINT startSlot, UINT numSamplers, ID3D11SamplerState* const* ppSamplers) noexcept
+{
+	pContext->PSSetSamplers(startSlot, numSamplers, ppSamplers);
+}
+
+void D3DGraphicsContext::RSSetViewports(UINT numViewports, const D3D11_VIEWPORT* pViewports) noexcept
+{
+	pContext->RSSetViewports(numViewports, pViewports);
+}
+
+void D3DGraphicsContext::OMSetRenderTargets(UINT numViews, ID3D11RenderTargetView* const* ppViews,
+                                            ID3D11DepthStencilView* pDepthStencilView) noexcept
+{
+	pContext->OMSetRenderTargets(numViews, ppViews, pDepthStencilView);
+}
+
+void D3DGraphicsContext::OMSetDepthStencilState(ID3D11DepthStencilState* pState, UINT stencilRef) noexcept
+{
+	pContext->OMSetDepthStencilState(pState, stencilRef);
+}
+
+void D3DGraphicsContext::ClearRenderTargetView(ID3D11RenderTargetView* pView, const FLOAT color[4]) noexcept
+{
+	pContext->ClearRenderTargetView(pView, color);
+}
+
+void D3DGraphicsContext::ClearDepthStencilView(ID3D11DepthStencilView* pView, UINT clearFlags, FLOAT depth,
+                                               UINT8 stencil) noexcept
+{
+	pContext->ClearDepthStencilView(pView, clearFlags, depth, stencil);
+}
+
+HRESULT D3DGraphicsContext::Map(ID3D11Resource* pResource, UINT subresource, D3D11_MAP mapType, UINT mapFlags,
+                                D3D11_MAPPED_SUBRESOURCE* pMappedResource) noexcept
+{
+	return pContext->Map(pResource, subresource, mapType, mapFlags, pMappedResource);
+}
+
+void D3DGraphicsContext::Unmap(ID3D11Resource* pResource, UINT subresource) noexcept
+{
+	pContext->Unmap(pResource, subresource);
+}
+
+void D3DGraphicsContext::CopySubresourceRegion(ID3D11Resource* pDstResource, UINT dstSubresource, UINT dstX, UINT dstY, UINT dstZ,
+                                               ID3D11Resource* pSrcResource, UINT srcSubresource, const D3D11_BOX* pSrcBox) noexcept
+{
+	pContext->CopySubresourceRegion(pDstResource, dstSubresource, dstX, dstY, dstZ, pSrcResource, srcSubresource, pSrcBox);
+}
+
+void D3DGraphicsContext::DrawIndexed(UINT indexCount, UINT startIndexLocation, INT baseVertexLocation) noexcept
+{
+	pContext->DrawIndexed(indexCount, startIndexLocation, baseVertexLocation);
+}
+
+void D3DGraphicsContext::DrawIndexedInstanced(UINT indexCountPerInstance, UINT instanceCount, UINT startIndexLocation,
+                                              INT baseVertexLocation, UINT startInstanceLocation) noexcept
+{
+	pContext->DrawIndexedInstanced(indexCountPerInstance, instanceCount, startIndexLocation,
+		baseVertexLocation, startInstanceLocation);
+}
@@ -0,0 +1,106 @@
+﻿#pragma once
+#include "WinInclude.h"
+#include <d3d11_1.h>
+#include <wrl.h>
+
+// the subset of ID3D11DeviceContext the engine submits through, signatures mirror d3d11 so
+// bindables can be written against either a hardware context or one of the recording backends
+class GraphicsContext
+{
+public:
+	GraphicsContext() = default;
+	GraphicsContext(const GraphicsContext&) = delete;
+	GraphicsContext& operator=(const GraphicsContext&) = delete;
+	virtual ~GraphicsContext() = default;
+
+	// input assembler
+	virtual void IASetVertexBuffers(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers,
+		const UINT* pStrides, const UINT* pOffsets) noexcept = 0;
+	virtual void IASetIndexBuffer(ID3D11Buffer* pBuffer, DXGI_FORMAT format, UINT offset) noexcept = 0;
+	virtual void IASetInputLayout(ID3D11InputLayout* pInputLayout) noexcept = 0;
+	virtual void IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology) noexcept = 0;
+
+	// shader stages
+	virtual void VSSetShader(ID3D11VertexShader* pShader, ID3D11ClassInstance* const* ppClassInstances,
+		UINT numClassInstances) noexcept = 0;
+	virtual void PSSetShader(ID3D11PixelShader* pShader, ID3D11ClassInstance* const* ppClassInstances,
+		UINT numClassInstances) noexcept = 0;
+	virtual void VSSetConstantBuffers(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers) noexcept = 0;
+	virtual void PSSetConstantBuffers(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers) noexcept = 0;
+	// d3d11.1 binds of a window into a larger buffer, offsets and sizes are in constants (16 bytes)
+	// and have to be multiples of 16
+	virtual void VSSetConstantBuffers1(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers,
+		const UINT* pFirstConstant, const UINT* pNumConstants) noexcept = 0;
+	virtual void PSSetConstantBuffers1(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers,
+		const UINT* pFirstConstant, const UINT* pNumConstants) noexcept = 0;
+	virtual void PSSetShaderResources(UINT startSlot, UINT numViews,
+		ID3D11ShaderResourceView* const* ppViews) noexcept = 0;
+	virtual void PSSetSamplers(UINT startSlot, UINT numSamplers, ID3D11SamplerState* const* ppSamplers) noexcept = 0;
+
+	// rasterizer / output merger
+	virtual void RSSetViewports(UINT numViewports, const D3D11_VIEWPORT* pViewports) noexcept = 0;
+	virtual void OMSetRenderTargets(UINT numViews, ID3D11RenderTargetView* const* ppViews,
+		ID3D11DepthStencilView* pDepthStencilView) noexcept = 0;
+	virtual void OMSetDepthStencilState(ID3D11DepthStencilState* pState, UINT stencilRef) noexcept = 0;
+	virtual void ClearRenderTargetView(ID3D11RenderTargetView* pView, const FLOAT color[4]) noexcept = 0;
+	virtual void ClearDepthStencilView(ID3D11DepthStencilView* pView, UINT clearFlags, FLOAT depth,
+		UINT8 stencil) noexcept = 0;
+
+	// resource access
+	virtual HRESULT Map(ID3D11Resource* pResource, UINT subresource, D3D11_MAP mapType, UINT mapFlags,
+		D3D11_MAPPED_SUBRESOURCE* pMappedResource) noexcept = 0;
+	virtual void Unmap(ID3D11Resource* pResource, UINT subresource) noexcept = 0;
+	virtual void CopySubresourceRegion(ID3D11Resource* pDstResource, UINT dstSubresource, UINT dstX, UINT dstY, UINT dstZ,
+		ID3D11Resource* pSrcResource, UINT srcSubresource, const D3D11_BOX* pSrcBox) noexcept = 0;
+
+	// draw
+	virtual void DrawIndexed(UINT indexCount, UINT startIndexLocation, INT baseVertexLocation) noexcept = 0;
+	virtual void DrawIndexedInstanced(UINT indexCountPerInstance, UINT instanceCount, UINT startIndexLocation,
+		INT baseVertexLocation, UINT startInstanceLocation) noexcept = 0;
+};
+
+// forwards everything straight to a d3d11 device context
+class D3DGraphicsContext : public GraphicsContext
+{
+public:
+	D3DGraphicsContext(Microsoft::WRL::ComPtr<ID3D11DeviceContext> pContext) noexcept;
+	ID3D11DeviceContext* GetD3DContext() const noexcept;
+
+	void IASetVertexBuffers(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers,
+		const UINT* pStrides, const UINT* pOffsets) noexcept override;
+	void IASetIndexBuffer(ID3D11Buffer* pBuffer, DXGI_FORMAT format, UINT offset) noexcept override;
+	void IASetInputLayout(ID3D11InputLayout* pInputLayout) noexcept override;
+	void IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology) noexcept override;
+	void VSSetShader(ID3D11VertexShader* pShader, ID3D11ClassInstance* const* ppClassInstances,
+		UINT numClassInstances) noexcept override;
+	void PSSetShader(ID3D11PixelShader* pShader, ID3D11ClassInstance* const* ppClassInstances,
+		UINT numClassInstances) noexcept override;
+	void VSSetConstantBuffers(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers) noexcept override;
+	void PSSetConstantBuffers(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers) noexcept override;
+	void VSSetConstantBuffers1(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers,
+		const UINT* pFirstConstant, const UINT* pNumConstants) noexcept override;
+	void PSSetConstantBuffers1(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers,
+		const UINT* pFirstConstant, const UINT* pNumConstants) noexcept override;
+	void PSSetShaderResources(UINT startSlot, UINT numViews,
+		ID3D11ShaderResourceView* const* ppViews) noexcept override;
+	void PSSetSamplers(UINT startSlot, UINT numSamplers, ID3D11SamplerState* const* ppSamplers) noexcept override;
+	void RSSetViewports(UINT numViewports, const D3D11_VIEWPORT* pViewports) noexcept override;
+	void OMSetRenderTargets(UINT numViews, ID3D11RenderTargetView* const* ppViews,
+		ID3D11DepthStencilView* pDepthStencilView) noexcept override;
+	void OMSetDepthStencilState(ID3D11DepthStencilState* pState, UINT stencilRef) noexcept override;
+	void ClearRenderTargetView(ID3D11RenderTargetView* pView, const FLOAT color[4]) noexcept override;
+	void ClearDepthStencilView(ID3D11DepthStencilView* pView, UINT clearFlags, FLOAT depth,
+		UINT8 stencil) noexcept override;
+	HRESULT Map(ID3D11Resource* pResource, UINT subresource, D3D11_MAP mapType, UINT mapFlags,
+		D3D11_MAPPED_SUBRESOURCE* pMappedResource) noexcept override;
+	void Unmap(ID3D11Resource* pResource, UINT subresource) noexcept override;
+	void CopySubresourceRegion(ID3D11Resource* pDstResource, UINT dstSubresource, UINT dstX, UINT dstY, UINT dstZ,
+		ID3D11Resource* pSrcResource, UINT srcSubresource, const D3D11_BOX* pSrcBox) noexcept override;
+	void DrawIndexed(UINT indexCount, UINT startIndexLocation, INT baseVertexLocation) noexcept override;
+	void DrawIndexedInstanced(UINT indexCountPerInstance, UINT instanceCount, UINT startIndexLocation,
+		INT baseVertexLocation, UINT startInstanceLocation) noexcept override;
+private:
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> pContext;
+	// null on runtimes older than d3d11.1
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext1> pContext1;
+};
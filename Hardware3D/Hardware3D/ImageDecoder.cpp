@@ -0,0 +1,1067 @@
+﻿#include "ImageDecoder.h"
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#include <emmintrin.h>
+#define IMAGE_DECODER_SSE2 1
+#else
+#define IMAGE_DECODER_SSE2 0
+#endif
+
+namespace
+{
+	// images larger than this are rejected up front rather than trusting the header with the allocation
+	constexpr std::uint64_t maxPixels = 1ull << 28u;
+
+	std::uint32_t ReadBE32(const unsigned char* p) noexcept
+	{
+		return (std::uint32_t(p[0]) << 24u) | (std::uint32_t(p[1]) << 16u) | (std::uint32_t(p[2]) << 8u) | p[3];
+	}
+
+	std::uint16_t ReadLE16(const unsigned char* p) noexcept
+	{
+		return std::uint16_t(p[0] | (p[1] << 8u));
+	}
+
+	std::uint32_t ReadLE32(const unsigned char* p) noexcept
+	{
+		return p[0] | (std::uint32_t(p[1]) << 8u) | (std::uint32_t(p[2]) << 16u) | (std::uint32_t(p[3]) << 24u);
+	}
+
+	constexpr std::uint32_t opaque = 0xFF000000u;
+
+	// row converters into bgra, the sse2 loops take whatever fits in 16 byte steps and leave the tail
+	// to the scalar loop. source layouts are named in memory order
+	void BgraToBgra(const unsigned char* pSrc, std::uint32_t* pDst, unsigned int count) noexcept
+	{
+		memcpy(pDst, pSrc, size_t(count) * 4u);
+	}
+
+	void BgrxToBgra(const unsigned char* pSrc, std::uint32_t* pDst, unsigned int count) noexcept
+	{
+		unsigned int i = 0u;
+#if IMAGE_DECODER_SSE2
+		const __m128i alpha = _mm_set1_epi32(int(opaque));
+		for (; i + 4u <= count; i += 4u)
+		{
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i * 4u));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i), _mm_or_si128(v, alpha));
+		}
+#endif
+		for (; i < count; i++)
+		{
+			pDst[i] = ReadLE32(pSrc + i * 4u) | opaque;
+		}
+	}
+
+	void RgbaToBgra(const unsigned char* pSrc, std::uint32_t* pDst, unsigned int count) noexcept
+	{
+		unsigned int i = 0u;
+#if IMAGE_DECODER_SSE2
+		// swap bytes 0 and 2 of every pixel, green and alpha stay put
+		const __m128i maskAG = _mm_set1_epi32(int(0xFF00FF00u));
+		const __m128i maskLow = _mm_set1_epi32(0xFF);
+		for (; i + 4u <= count; i += 4u)
+		{
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i * 4u));
+			const __m128i ag = _mm_and_si128(v, maskAG);
+			const __m128i r = _mm_slli_epi32(_mm_and_si128(v, maskLow), 16);
+			const __m128i b = _mm_and_si128(_mm_srli_epi32(v, 16), maskLow);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i), _mm_or_si128(ag, _mm_or_si128(r, b)));
+		}
+#endif
+		for (; i < count; i++)
+		{
+			const auto p = pSrc + i * 4u;
+			pDst[i] = (std::uint32_t(p[3]) << 24u) | (std::uint32_t(p[0]) << 16u) | (std::uint32_t(p[1]) << 8u) | p[2];
+		}
+	}
+
+#if IMAGE_DECODER_SSE2
+	// 4 packed 3 byte pixels spread out into the low 3 bytes of each lane, reads 16 bytes
+	__m128i Gather3(const unsigned char* pSrc) noexcept
+	{
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc));
+		const __m128i ab = _mm_unpacklo_epi32(v, _mm_srli_si128(v, 3));
+		const __m128i cd = _mm_unpacklo_epi32(_mm_srli_si128(v, 6), _mm_srli_si128(v, 9));
+		return _mm_unpacklo_epi64(ab, cd);
+	}
+#endif
+
+	void BgrToBgra(const unsigned char* pSrc, std::uint32_t* pDst, unsigned int count) noexcept
+	{
+		unsigned int i = 0u;
+#if IMAGE_DECODER_SSE2
+		const __m128i maskBGR = _mm_set1_epi32(0x00FFFFFF);
+		const __m128i alpha = _mm_set1_epi32(int(opaque));
+		// the 16 byte load of 4 pixels needs 2 more pixels of source behind them
+		for (; i + 6u <= count; i += 4u)
+		{
+			const __m128i v = _mm_and_si128(Gather3(pSrc + i * 3u), maskBGR);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i), _mm_or_si128(v, alpha));
+		}
+#endif
+		for (; i < count; i++)
+		{
+			const auto p = pSrc + i * 3u;
+			pDst[i] = opaque | (std::uint32_t(p[2]) << 16u) | (std::uint32_t(p[1]) << 8u) | p[0];
+		}
+	}
+
+	void RgbToBgra(const unsigned char* pSrc, std::uint32_t* pDst, unsigned int count) noexcept
+	{
+		unsigned int i = 0u;
+#if IMAGE_DECODER_SSE2
+		const __m128i maskG = _mm_set1_epi32(0x0000FF00);
+		const __m128i maskLow = _mm_set1_epi32(0xFF);
+		const __m128i alpha = _mm_set1_epi32(int(opaque));
+		for (; i + 6u <= count; i += 4u)
+		{
+			const __m128i v = Gather3(pSrc + i * 3u);
+			const __m128i g = _mm_and_si128(v, maskG);
+			const __m128i r = _mm_slli_epi32(_mm_and_si128(v, maskLow), 16);
+			const __m128i b = _mm_and_si128(_mm_srli_epi32(v, 16), maskLow);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i), _mm_or_si128(_mm_or_si128(g, alpha), _mm_or_si128(r, b)));
+		}
+#endif
+		for (; i < count; i++)
+		{
+			const auto p = pSrc + i * 3u;
+			pDst[i] = opaque | (std::uint32_t(p[0]) << 16u) | (std::uint32_t(p[1]) << 8u) | p[2];
+		}
+	}
+
+	void GrayToBgra(const unsigned char* pSrc, std::uint32_t* pDst, unsigned int count) noexcept
+	{
+		unsigned int i = 0u;
+#if IMAGE_DECODER_SSE2
+		const __m128i ones = _mm_set1_epi8(-1);
+		for (; i + 16u <= count; i += 16u)
+		{
+			// (g g) and (g ff) word pairs interleave into g g g ff
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i));
+			const __m128i ggLo = _mm_unpacklo_epi8(v, v);
+			const __m128i gaLo = _mm_unpacklo_epi8(v, ones);
+			const __m128i ggHi = _mm_unpackhi_epi8(v, v);
+			const __m128i gaHi = _mm_unpackhi_epi8(v, ones);
+			const auto pOut = reinterpret_cast<__m128i*>(pDst + i);
+			_mm_storeu_si128(pOut + 0, _mm_unpacklo_epi16(ggLo, gaLo));
+			_mm_storeu_si128(pOut + 1, _mm_unpackhi_epi16(ggLo, gaLo));
+			_mm_storeu_si128(pOut + 2, _mm_unpacklo_epi16(ggHi, gaHi));
+			_mm_storeu_si128(pOut + 3, _mm_unpackhi_epi16(ggHi, gaHi));
+		}
+#endif
+		for (; i < count; i++)
+		{
+			pDst[i] = opaque | (std::uint32_t(pSrc[i]) * 0x010101u);
+		}
+	}
+
+	void GrayAlphaToBgra(const unsigned char* pSrc, std::uint32_t* pDst, unsigned int count) noexcept
+	{
+		unsigned int i = 0u;
+#if IMAGE_DECODER_SSE2
+		const __m128i maskLow = _mm_set1_epi16(0xFF);
+		for (; i + 8u <= count; i += 8u)
+		{
+			// every word is (g a), pair it with a (g g) word
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i * 2u));
+			const __m128i g = _mm_and_si128(v, maskLow);
+			const __m128i gg = _mm_or_si128(g, _mm_slli_epi16(g, 8));
+			const auto pOut = reinterpret_cast<__m128i*>(pDst + i);
+			_mm_storeu_si128(pOut + 0, _mm_unpacklo_epi16(gg, v));
+			_mm_storeu_si128(pOut + 1, _mm_unpackhi_epi16(gg, v));
+		}
+#endif
+		for (; i < count; i++)
+		{
+			const auto p = pSrc + i * 2u;
+			pDst[i] = (std::uint32_t(p[1]) << 24u) | (std::uint32_t(p[0]) * 0x010101u);
+		}
+	}
+
+	void IndexedToBgra(const unsigned char* pSrc, std::uint32_t* pDst, unsigned int count,
+		const std::array<std::uint32_t, 256>& palette) noexcept
+	{
+		for (unsigned int i = 0; i < count; i++)
+		{
+			pDst[i] = palette[pSrc[i]];
+		}
+	}
+
+	// zlib stream decoder (rfc 1950 / 1951), just what png needs
+	class Inflater
+	{
+	private:
+		class Huffman
+		{
+		public:
+			// codes up to fastBits long resolve with one lookup into symbol << 4 | length, 0 for longer codes
+			static constexpr unsigned int fastBits = 10u;
+			static constexpr unsigned int maxBits = 15u;
+		public:
+			// false for over-subscribed code sets, incomplete ones are allowed (single distance codes)
+			bool Build(const unsigned char* pLengths, unsigned int count) noexcept
+			{
+				counts.fill(0u);
+				for (unsigned int i = 0; i < count; i++)
+				{
+					counts[pLengths[i]]++;
+				}
+				counts[0] = 0u;
+				int left = 1;
+				for (unsigned int len = 1; len <= maxBits; len++)
+				{
+					left = (left << 1) - counts[len];
+					if (left < 0)
+					{
+						return false;
+					}
+				}
+
+				// symbols sorted by code length, then value, is the canonical code order
+				std::array<std::uint16_t, maxBits + 2u> offsets = {};
+				for (unsigned int len = 1; len <= maxBits; len++)
+				{
+					offsets[len + 1] = offsets[len] + counts[len];
+				}
+				std::array<std::uint16_t, maxBits + 1u> nextCode = {};
+				std::uint16_t code = 0u;
+				for (unsigned int len = 1; len <= maxBits; len++)
+				{
+					code = std::uint16_t((code + counts[len - 1]) << 1u);
+					nextCode[len] = code;
+				}
+
+				fast.fill(0u);
+				for (unsigned int s = 0; s < count; s++)
+				{
+					const unsigned int len = pLengths[s];
+					if (len == 0u)
+					{
+						continue;
+					}
+					symbols[offsets[len]++] = std::uint16_t(s);
+					const unsigned int c = nextCode[len]++;
+					if (len <= fastBits)
+					{
+						// codes are packed msb first, the bit buffer is read lsb first
+						unsigned int reversed = 0u;
+						for (unsigned int b = 0; b < len; b++)
+						{
+							reversed |= ((c >> b) & 1u) << (len - 1u - b);
+						}
+						for (unsigned int i = reversed; i < (1u << fastBits); i += 1u << len)
+						{
+							fast[i] = std::uint16_t((s << 4u) | len);
+						}
+					}
+				}
+				return true;
+			}
+		private:
+			friend class Inflater;
+			std::array<std::uint16_t, 1u << fastBits> fast;
+			std::array<std::uint16_t, maxBits + 1u> counts;
+			std::array<std::uint16_t, 288> symbols;
+		};
+	public:
+		Inflater(const unsigned char* pData, size_t size) noexcept
+			:
+			pCur(pData),
+			pEnd(pData + size)
+		{}
+		// out has to be sized to the exact decompressed size, false on malformed streams
+		bool Inflate(std::vector<unsigned char>& out) noexcept
+		{
+			if (pEnd - pCur < 2)
+			{
+				return false;
+			}
+			const unsigned int cmf = pCur[0];
+			const unsigned int flg = pCur[1];
+			// deflate only, no preset dictionary
+			if ((cmf & 0x0Fu) != 8u || ((cmf << 8u) | flg) % 31u != 0u || (flg & 0x20u))
+			{
+				return false;
+			}
+			pCur += 2;
+
+			pOut = out.data();
+			pOutEnd = out.data() + out.size();
+			pOutBegin = out.data();
+			bool final = false;
+			while (!final)
+			{
+				final = GetBits(1u) != 0u;
+				const auto type = GetBits(2u);
+				bool ok = false;
+				switch (type)
+				{
+				case 0u:
+					ok = Stored();
+					break;
+				case 1u:
+					ok = BuildFixed() && Codes();
+					break;
+				case 2u:
+					ok = BuildDynamic() && Codes();
+					break;
+				}
+				if (!ok || padBytes > 8u)
+				{
+					return false;
+				}
+			}
+			return pOut == pOutEnd;
+		}
+	private:
+		void Refill() noexcept
+		{
+			while (bitCount <= 56u)
+			{
+				if (pCur < pEnd)
+				{
+					bitBuffer |= std::uint64_t(*pCur++) << bitCount;
+				}
+				else
+				{
+					// zeros past the end, too many of them consumed means the stream was truncated
+					padBytes++;
+				}
+				bitCount += 8u;
+			}
+		}
+		unsigned int GetBits(unsigned int n) noexcept
+		{
+			if (bitCount < n)
+			{
+				Refill();
+			}
+			const auto v = (unsigned int)(bitBuffer & ((1ull << n) - 1u));
+			bitBuffer >>= n;
+			bitCount -= n;
+			return v;
+		}
+		int DecodeSymbol(const Huffman& h) noexcept
+		{
+			if (bitCount < Huffman::maxBits)
+			{
+				Refill();
+			}
+			const auto entry = h.fast[bitBuffer & ((1u << Huffman::fastBits) - 1u)];
+			if (entry != 0u)
+			{
+				const unsigned int len = entry & 0xFu;
+				bitBuffer >>= len;
+				bitCount -= len;
+				return entry >> 4u;
+			}
+			// canonical decode one bit at a time for the long codes
+			int code = 0;
+			int first = 0;
+			int index = 0;
+			for (unsigned int len = 1; len <= Huffman::maxBits; len++)
+			{
+				code |= int((bitBuffer >> (len - 1u)) & 1u);
+				const int count = h.counts[len];
+				if (code - count < first)
+				{
+					bitBuffer >>= len;
+					bitCount -= len;
+					return h.symbols[index + (code - first)];
+				}
+				index += count;
+				first = (first + count) << 1;
+				code <<= 1;
+			}
+			return -1;
+		}
+		bool Stored() noexcept
+		{
+			// whole bytes from here on, whatever is left in the bit buffer comes first
+			GetBits(bitCount & 7u);
+			const auto len = GetBits(16u);
+			const auto nlen = GetBits(16u);
+			if ((len ^ 0xFFFFu) != nlen || size_t(pOutEnd - pOut) < len)
+			{
+				return false;
+			}
+			unsigned int remaining = len;
+			while (remaining > 0u && bitCount >= 8u)
+			{
+				*pOut++ = (unsigned char)GetBits(8u);
+				remaining--;
+			}
+			if (size_t(pEnd - pCur) < remaining)
+			{
+				return false;
+			}
+			memcpy(pOut, pCur, remaining);
+			pOut += remaining;
+			pCur += remaining;
+			return true;
+		}
+		bool BuildFixed() noexcept
+		{
+			std::array<unsigned char, 288 + 32> lengths;
+			std::fill(lengths.begin(), lengths.begin() + 144, (unsigned char)8u);
+			std::fill(lengths.begin() + 144, lengths.begin() + 256, (unsigned char)9u);
+			std::fill(lengths.begin() + 256, lengths.begin() + 280, (unsigned char)7u);
+			std::fill(lengths.begin() + 280, lengths.begin() + 288, (unsigned char)8u);
+			std::fill(lengths.begin() + 288, lengths.end(), (unsigned char)5u);
+			return literals.Build(lengths.data(), 288u) && distances.Build(lengths.data() + 288, 30u);
+		}
+		bool BuildDynamic() noexcept
+		{
+			static constexpr unsigned char order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+			const unsigned int literalCount = GetBits(5u) + 257u;
+			const unsigned int distanceCount = GetBits(5u) + 1u;
+			const unsigned int codeLengthCount = GetBits(4u) + 4u;
+			if (literalCount > 286u || distanceCount > 30u)
+			{
+				return false;
+			}
+
+			std::array<unsigned char, 19> codeLengthLengths = {};
+			for (unsigned int i = 0; i < codeLengthCount; i++)
+			{
+				codeLengthLengths[order[i]] = (unsigned char)GetBits(3u);
+			}
+			Huffman codeLengths;
+			if (!codeLengths.Build(codeLengthLengths.data(), 19u))
+			{
+				return false;
+			}
+
+			// literal and distance lengths are one run, repeats may cross from one into the other
+			std::array<unsigned char, 286 + 30> lengths = {};
+			const unsigned int total = literalCount + distanceCount;
+			unsigned int n = 0u;
+			while (n < total)
+			{
+				const int symbol = DecodeSymbol(codeLengths);
+				if (symbol < 0)
+				{
+					return false;
+				}
+				if (symbol < 16)
+				{
+					lengths[n++] = (unsigned char)symbol;
+					continue;
+				}
+				unsigned char value = 0u;
+				unsigned int repeat;
+				if (symbol == 16)
+				{
+					if (n == 0u)
+					{
+						return false;
+					}
+					value = lengths[n - 1u];
+					repeat = 3u + GetBits(2u);
+				}
+				else if (symbol == 17)
+				{
+					repeat = 3u + GetBits(3u);
+				}
+				else
+				{
+					repeat = 11u + GetBits(7u);
+				}
+				if (n + repeat > total)
+				{
+					return false;
+				}
+				std::fill_n(lengths.begin() + n, repeat, value);
+				n += repeat;
+			}
+			// a block without an end code could never finish
+			if (lengths[256] == 0u)
+			{
+				return false;
+			}
+			return literals.Build(lengths.data(), literalCount) &&
+				distances.Build(lengths.data() + literalCount, distanceCount);
+		}
+		bool Codes() noexcept
+		{
+			static constexpr std::uint16_t lengthBase[29] = {
+				3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+				35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+			static constexpr unsigned char lengthExtra[29] = {
+				0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+				3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+			static constexpr std::uint16_t distanceBase[30] = {
+				1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129,
+				193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+			static constexpr unsigned char distanceExtra[30] = {
+				0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+				6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+			for (;;)
+			{
+				const int symbol = DecodeSymbol(literals);
+				if (symbol < 256)
+				{
+					if (symbol < 0 || pOut == pOutEnd)
+					{
+						return false;
+					}
+					*pOut++ = (unsigned char)symbol;
+					continue;
+				}
+				if (symbol == 256)
+				{
+					return true;
+				}
+				const int lengthIndex = symbol - 257;
+				if (lengthIndex >= 29)
+				{
+					return false;
+				}
+				const unsigned int length = lengthBase[lengthIndex] + GetBits(lengthExtra[lengthIndex]);
+				const int distanceIndex = DecodeSymbol(distances);
+				if (distanceIndex < 0 || distanceIndex >= 30)
+				{
+					return false;
+				}
+				const size_t distance = distanceBase[distanceIndex] + GetBits(distanceExtra[distanceIndex]);
+				if (distance > size_t(pOut - pOutBegin) || length > size_t(pOutEnd - pOut))
+				{
+					return false;
+				}
+				// matches may overlap their own output, copy forwards a byte at a time
+				const unsigned char* pFrom = pOut - distance;
+				for (unsigned int i = 0; i < length; i++)
+				{
+					pOut[i] = pFrom[i];
+				}
+				pOut += length;
+			}
+		}
+	private:
+		const unsigned char* pCur;
+		const unsigned char* pEnd;
+		std::uint64_t bitBuffer = 0u;
+		unsigned int bitCount = 0u;
+		unsigned int padBytes = 0u;
+		unsigned char* pOutBegin = nullptr;
+		unsigned char* pOut = nullptr;
+		unsigned char* pOutEnd = nullptr;
+		Huffman literals;
+		Huffman distances;
+	};
+
+	unsigned char Paeth(int a, int b, int c) noexcept
+	{
+		const int p = a + b - c;
+		const int pa = std::abs(p - a);
+		const int pb = std::abs(p - b);
+		const int pc = std::abs(p - c);
+		if (pa <= pb && pa <= pc)
+		{
+			return (unsigned char)a;
+		}
+		return (unsigned char)(pb <= pc ? b : c);
+	}
+
+	// undoes the png filter of one row in place, pPrior is the previous unfiltered row (or zeros)
+	bool Unfilter(unsigned char filter, unsigned char* pRow, const unsigned char* pPrior, size_t rowBytes,
+		size_t bpp) noexcept
+	{
+		switch (filter)
+		{
+		case 0u:
+			return true;
+		case 1u:
+			for (size_t i = bpp; i < rowBytes; i++)
+			{
+				pRow[i] = (unsigned char)(pRow[i] + pRow[i - bpp]);
+			}
+			return true;
+		case 2u:
+			for (size_t i = 0; i < rowBytes; i++)
+			{
+				pRow[i] = (unsigned char)(pRow[i] + pPrior[i]);
+			}
+			return true;
+		case 3u:
+			for (size_t i = 0; i < bpp; i++)
+			{
+				pRow[i] = (unsigned char)(pRow[i] + (pPrior[i] >> 1u));
+			}
+			for (size_t i = bpp; i < rowBytes; i++)
+			{
+				pRow[i] = (unsigned char)(pRow[i] + ((pRow[i - bpp] + pPrior[i]) >> 1u));
+			}
+			return true;
+		case 4u:
+			for (size_t i = 0; i < bpp; i++)
+			{
+				pRow[i] = (unsigned char)(pRow[i] + pPrior[i]);
+			}
+			for (size_t i = bpp; i < rowBytes; i++)
+			{
+				pRow[i] = (unsigned char)(pRow[i] + Paeth(pRow[i - bpp], pPrior[i], pPrior[i - bpp]));
+			}
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	unsigned int PngChannels(unsigned char colorType) noexcept
+	{
+		switch (colorType)
+		{
+		case 0u:
+		case 3u:
+			return 1u;
+		case 2u:
+			return 3u;
+		case 4u:
+			return 2u;
+		default:
+			return 4u;
+		}
+	}
+
+	bool IsPngDepthValid(unsigned char colorType, unsigned char depth) noexcept
+	{
+		switch (colorType)
+		{
+		case 0u:
+			return depth == 1u || depth == 2u || depth == 4u || depth == 8u || depth == 16u;
+		case 3u:
+			return depth == 1u || depth == 2u || depth == 4u || depth == 8u;
+		case 2u:
+		case 4u:
+		case 6u:
+			return depth == 8u || depth == 16u;
+		default:
+			return false;
+		}
+	}
+
+	constexpr unsigned char pngSignature[8] = { 0x89u, 'P', 'N', 'G', '\r', '\n', 0x1Au, '\n' };
+	constexpr size_t tgaHeaderSize = 18u;
+	constexpr size_t bmpFileHeaderSize = 14u;
+}
+
+std::optional<ImageDecoder::Info> ImageDecoder::ReadInfo(const unsigned char* pData, size_t size) noexcept
+{
+	std::optional<Info> info;
+	// png: signature followed by the IHDR chunk
+	if (size >= 33u && memcmp(pData, pngSignature, sizeof(pngSignature)) == 0)
+	{
+		if (ReadBE32(pData + 8) != 13u || memcmp(pData + 12, "IHDR", 4u) != 0)
+		{
+			return std::nullopt;
+		}
+		const auto colorType = pData[25];
+		if (!IsPngDepthValid(colorType, pData[24]) || pData[26] != 0u || pData[27] != 0u || pData[28] != 0u)
+		{
+			return std::nullopt;
+		}
+		info = Info{ Format::Png, ReadBE32(pData + 16), ReadBE32(pData + 20) };
+	}
+	// bmp: file header and at least a BITMAPINFOHEADER
+	else if (size >= bmpFileHeaderSize + 40u && pData[0] == 'B' && pData[1] == 'M')
+	{
+		const auto pInfo = pData + bmpFileHeaderSize;
+		const auto headerSize = ReadLE32(pInfo);
+		const auto width = std::int32_t(ReadLE32(pInfo + 4));
+		const auto height = std::int32_t(ReadLE32(pInfo + 8));
+		const auto bitCount = ReadLE16(pInfo + 14);
+		const auto compression = ReadLE32(pInfo + 16);
+		if (headerSize < 40u || width <= 0 || height == 0 || height == INT32_MIN)
+		{
+			return std::nullopt;
+		}
+		// BI_RGB at 8, 24 or 32 bits, BI_BITFIELDS only with the plain bgra masks
+		bool supported = compression == 0u && (bitCount == 8u || bitCount == 24u || bitCount == 32u);
+		if (compression == 3u && bitCount == 32u && size >= bmpFileHeaderSize + 52u)
+		{
+			supported = ReadLE32(pInfo + 40) == 0x00FF0000u && ReadLE32(pInfo + 44) == 0x0000FF00u &&
+				ReadLE32(pInfo + 48) == 0x000000FFu;
+		}
+		if (!supported)
+		{
+			return std::nullopt;
+		}
+		info = Info{ Format::Bmp, (unsigned int)(width), (unsigned int)(height < 0 ? -height : height) };
+	}
+	// tga has no magic number, accept headers that make sense for the handled variants
+	else if (size >= tgaHeaderSize)
+	{
+		const auto colorMapType = pData[1];
+		const auto imageType = pData[2];
+		const auto depth = pData[16];
+		const auto descriptor = pData[17];
+		const bool trueColor = (imageType == 2u || imageType == 10u) && (depth == 24u || depth == 32u);
+		const bool gray = (imageType == 3u || imageType == 11u) && depth == 8u;
+		// right to left pixel order is practically never written
+		if (colorMapType > 1u || !(trueColor || gray) || (descriptor & 0x10u))
+		{
+			return std::nullopt;
+		}
+		info = Info{ Format::Tga, ReadLE16(pData + 12), ReadLE16(pData + 14) };
+	}
+
+	if (!info || info->width == 0u || info->height == 0u ||
+		std::uint64_t(info->width) * info->height > maxPixels)
+	{
+		return std::nullopt;
+	}
+	return info;
+}
+
+void ImageDecoder::Decode(const unsigned char* pData, size_t size, const Info& info, std::uint32_t* pDst)
+{
+	switch (info.format)
+	{
+	case Format::Png:
+		DecodePng(pData, size, info, pDst);
+		break;
+	case Format::Tga:
+		DecodeTga(pData, size, info, pDst);
+		break;
+	case Format::Bmp:
+		DecodeBmp(pData, size, info, pDst);
+		break;
+	}
+}
+
+void ImageDecoder::DecodePng(const unsigned char* pData, size_t size, const Info& info, std::uint32_t* pDst)
+{
+	const unsigned char depth = pData[24];
+	const unsigned char colorType = pData[25];
+
+	// collect palette, transparency and the compressed stream (usually split over many IDAT chunks)
+	std::array<std::uint32_t, 256> palette;
+	palette.fill(opaque);
+	std::optional<std::array<std::uint16_t, 3>> transparentKey;
+	std::vector<unsigned char> compressed;
+	size_t pos = sizeof(pngSignature);
+	for (;;)
+	{
+		if (size - pos < 12u)
+		{
+			throw Exception(__LINE__, __FILE__, "png chunk runs past the end of the file");
+		}
+		const size_t length = ReadBE32(pData + pos);
+		const auto pType = pData + pos + 4;
+		const auto pChunk = pData + pos + 8;
+		if (length > size - pos - 12u)
+		{
+			throw Exception(__LINE__, __FILE__, "png chunk runs past the end of the file");
+		}
+		if (memcmp(pType, "IDAT", 4u) == 0)
+		{
+			compressed.insert(compressed.end(), pChunk, pChunk + length);
+		}
+		else if (memcmp(pType, "PLTE", 4u) == 0)
+		{
+			for (size_t i = 0; i < std::min<size_t>(length / 3u, 256u); i++)
+			{
+				const auto p = pChunk + i * 3u;
+				palette[i] = opaque | (std::uint32_t(p[0]) << 16u) | (std::uint32_t(p[1]) << 8u) | p[2];
+			}
+		}
+		else if (memcmp(pType, "tRNS", 4u) == 0)
+		{
+			if (colorType == 3u)
+			{
+				for (size_t i = 0; i < std::min<size_t>(length, 256u); i++)
+				{
+					palette[i] = (palette[i] & 0x00FFFFFFu) | (std::uint32_t(pChunk[i]) << 24u);
+				}
+			}
+			else if (colorType == 0u && length >= 2u)
+			{
+				const std::uint16_t g = std::uint16_t((pChunk[0] << 8u) | pChunk[1]);
+				transparentKey = std::array<std::uint16_t, 3>{ g, g, g };
+			}
+			else if (colorType == 2u && length >= 6u)
+			{
+				transparentKey = std::array<std::uint16_t, 3>{
+					std::uint16_t((pChunk[0] << 8u) | pChunk[1]),
+					std::uint16_t((pChunk[2] << 8u) | pChunk[3]),
+					std::uint16_t((pChunk[4] << 8u) | pChunk[5]) };
+			}
+		}
+		else if (memcmp(pType, "IEND", 4u) == 0)
+		{
+			break;
+		}
+		pos += length + 12u;
+	}
+
+	const unsigned int width = info.width;
+	const unsigned int height = info.height;
+	const unsigned int channels = PngChannels(colorType);
+	const size_t bitsPerPixel = size_t(channels) * depth;
+	const size_t rowBytes = (width * bitsPerPixel + 7u) / 8u;
+	// filters work on whole bytes, sub byte formats count as 1
+	const size_t bpp = std::max<size_t>(bitsPerPixel / 8u, 1u);
+
+	std::vector<unsigned char> raw(height * (rowBytes + 1u));
+	if (!Inflater(compressed.data(), compressed.size()).Inflate(raw))
+	{
+		throw Exception(__LINE__, __FILE__, "png image data is corrupt or truncated");
+	}
+
+	// samples of non 8 bit images are brought to 8 bits in here before the swizzle
+	std::vector<unsigned char> narrow(depth == 8u ? 0u : size_t(width) * channels);
+	const std::vector<unsigned char> zeros(rowBytes, 0u);
+	for (unsigned int y = 0; y < height; y++)
+	{
+		unsigned char* const pRow = raw.data() + y * (rowBytes + 1u) + 1u;
+		const unsigned char* const pPrior = y == 0u ? zeros.data() : pRow - (rowBytes + 1u);
+		if (!Unfilter(pRow[-1], pRow, pPrior, rowBytes, bpp))
+		{
+			throw Exception(__LINE__, __FILE__, "png row has an unknown filter type");
+		}
+
+		const unsigned char* pSamples = pRow;
+		if (depth == 16u)
+		{
+			// big endian, the high byte comes first
+			for (size_t i = 0; i < narrow.size(); i++)
+			{
+				narrow[i] = pRow[i * 2u];
+			}
+			pSamples = narrow.data();
+		}
+		else if (depth < 8u)
+		{
+			// palette indices stay as they are, gray levels get scaled up to the full range
+			const unsigned int mask = (1u << depth) - 1u;
+			const unsigned int scale = colorType == 3u ? 1u : 255u / mask;
+			for (unsigned int x = 0; x < width; x++)
+			{
+				const size_t bit = size_t(x) * depth;
+				const unsigned int shift = 8u - depth - (unsigned int)(bit & 7u);
+				narrow[x] = (unsigned char)(((pRow[bit >> 3u] >> shift) & mask) * scale);
+			}
+			pSamples = narrow.data();
+		}
+
+		std::uint32_t* const pOut = pDst + size_t(y) * width;
+		switch (colorType)
+		{
+		case 0u:
+			GrayToBgra(pSamples, pOut, width);
+			break;
+		case 2u:
+			RgbToBgra(pSamples, pOut, width);
+			break;
+		case 3u:
+			IndexedToBgra(pSamples, pOut, width, palette);
+			break;
+		case 4u:
+			GrayAlphaToBgra(pSamples, pOut, width);
+			break;
+		case 6u:
+			RgbaToBgra(pSamples, pOut, width);
+			break;
+		}
+
+		if (transparentKey)
+		{
+			// keys are compared at the sample depth of the file
+			const unsigned int keyShift = depth == 16u ? 8u : 0u;
+			const auto scale = depth < 8u ? 255u / ((1u << depth) - 1u) : 1u;
+			const auto key = [&](size_t c) { return std::uint32_t((*transparentKey)[c] >> keyShift) * scale & 0xFFu; };
+			const std::uint32_t keyColor = (key(0) << 16u) | (key(1) << 8u) | key(2);
+			for (unsigned int x = 0; x < width; x++)
+			{
+				if ((pOut[x] & 0x00FFFFFFu) == keyColor)
+				{
+					pOut[x] = keyColor;
+				}
+			}
+		}
+	}
+}
+
+void ImageDecoder::DecodeTga(const unsigned char* pData, size_t size, const Info& info, std::uint32_t* pDst)
+{
+	const size_t idLength = pData[0];
+	const bool hasColorMap = pData[1] == 1u;
+	const auto imageType = pData[2];
+	const size_t colorMapBytes = hasColorMap ? ReadLE16(pData + 5) * ((pData[7] + 7u) / 8u) : 0u;
+	const size_t pixelBytes = pData[16] / 8u;
+	const bool topDown = (pData[17] & 0x20u) != 0u;
+	const bool rle = imageType >= 9u;
+
+	const unsigned int width = info.width;
+	const unsigned int height = info.height;
+	const size_t imageBytes = size_t(width) * height * pixelBytes;
+	size_t pos = tgaHeaderSize + idLength + colorMapBytes;
+	if (pos > size)
+	{
+		throw Exception(__LINE__, __FILE__, "tga header runs past the end of the file");
+	}
+
+	// run length encoded packets may cross rows, expand the whole image before swizzling
+	std::vector<unsigned char> expanded;
+	const unsigned char* pPixels = pData + pos;
+	if (rle)
+	{
+		expanded.resize(imageBytes);
+		size_t out = 0u;
+		while (out < imageBytes)
+		{
+			if (pos >= size)
+			{
+				throw Exception(__LINE__, __FILE__, "tga image data is truncated");
+			}
+			const unsigned int header = pData[pos++];
+			const size_t count = std::min<size_t>((header & 0x7Fu) + 1u, (imageBytes - out) / pixelBytes);
+			if (header & 0x80u)
+			{
+				if (size - pos < pixelBytes)
+				{
+					throw Exception(__LINE__, __FILE__, "tga image data is truncated");
+				}
+				for (size_t i = 0; i < count; i++)
+				{
+					memcpy(&expanded[out + i * pixelBytes], pData + pos, pixelBytes);
+				}
+				pos += pixelBytes;
+			}
+			else
+			{
+				if (size - pos < count * pixelBytes)
+				{
+					throw Exception(__LINE__, __FILE__, "tga image data is truncated");
+				}
+				memcpy(&expanded[out], pData + pos, count * pixelBytes);
+				pos += count * pixelBytes;
+			}
+			out += count * pixelBytes;
+		}
+		pPixels = expanded.data();
+	}
+	else if (size - pos < imageBytes)
+	{
+		throw Exception(__LINE__, __FILE__, "tga image data is truncated");
+	}
+
+	const size_t rowBytes = size_t(width) * pixelBytes;
+	for (unsigned int y = 0; y < height; y++)
+	{
+		const auto pRow = pPixels + size_t(topDown ? y : height - 1u - y) * rowBytes;
+		std::uint32_t* const pOut = pDst + size_t(y) * width;
+		switch (pixelBytes)
+		{
+		case 4u:
+			BgraToBgra(pRow, pOut, width);
+			break;
+		case 3u:
+			BgrToBgra(pRow, pOut, width);
+			break;
+		default:
+			GrayToBgra(pRow, pOut, width);
+			break;
+		}
+	}
+}
+
+void ImageDecoder::DecodeBmp(const unsigned char* pData, size_t size, const Info& info, std::uint32_t* pDst)
+{
+	const auto pInfo = pData + bmpFileHeaderSize;
+	const size_t pixelOffset = ReadLE32(pData + 10);
+	const size_t headerSize = ReadLE32(pInfo);
+	const bool topDown = std::int32_t(ReadLE32(pInfo + 8)) < 0;
+	const unsigned int bitCount = ReadLE16(pInfo + 14);
+	const auto compression = ReadLE32(pInfo + 16);
+
+	const unsigned int width = info.width;
+	const unsigned int height = info.height;
+	// rows are padded to 4 bytes
+	const size_t stride = (size_t(width) * bitCount + 31u) / 32u * 4u;
+	if (pixelOffset > size || size - pixelOffset < stride * (height - 1u) + (size_t(width) * bitCount + 7u) / 8u)
+	{
+		throw Exception(__LINE__, __FILE__, "bmp image data is truncated");
+	}
+
+	std::array<std::uint32_t, 256> palette;
+	palette.fill(opaque);
+	if (bitCount == 8u)
+	{
+		// bgrx entries straight after the info header
+		const auto colorsUsed = ReadLE32(pInfo + 32);
+		const size_t paletteSize = colorsUsed == 0u ? 256u : std::min<size_t>(colorsUsed, 256u);
+		const size_t paletteOffset = bmpFileHeaderSize + headerSize;
+		if (paletteOffset > size || (size - paletteOffset) / 4u < paletteSize)
+		{
+			throw Exception(__LINE__, __FILE__, "bmp palette is truncated");
+		}
+		for (size_t i = 0; i < paletteSize; i++)
+		{
+			palette[i] = ReadLE32(pData + paletteOffset + i * 4u) | opaque;
+		}
+	}
+	// alpha only counts when a bitfield mask says there is some, plain 32 bit bmp leave the byte unused
+	const bool hasAlpha = compression == 3u && headerSize >= 56u && ReadLE32(pInfo + 52) == 0xFF000000u;
+
+	for (unsigned int y = 0; y < height; y++)
+	{
+		const auto pRow = pData + pixelOffset + size_t(topDown ? y : height - 1u - y) * stride;
+		std::uint32_t* const pOut = pDst + size_t(y) * width;
+		switch (bitCount)
+		{
+		case 32u:
+			if (hasAlpha)
+			{
+				BgraToBgra(pRow, pOut, width);
+			}
+			else
+			{
+				BgrxToBgra(pRow, pOut, width);
+			}
+			break;
+		case 24u:
+			BgrToBgra(pRow, pOut, width);
+			break;
+		default:
+			IndexedToBgra(pRow, pOut, width, palette);
+			break;
+		}
+	}
+}
+
+
+ImageDecoder::Exception::Exception(int line, const char* file, std::string note) noexcept
+	:
+	D3DException(line, file),
+	note(std::move(note))
+{
+}
+
+const char* ImageDecoder::Exception::what() const noexcept
+{
+	std::ostringstream oss;
+	oss << D3DException::what() << std::endl
+		<< "[Note] " << GetNote();
+	whatBuffer = oss.str();
+	return whatBuffer.c_str();
+}
+
+const char* ImageDecoder::Exception::GetType() const noexcept
+{
+	return "Half-Way Engine Image Decoder Exception";
+}
+
+const std::string& ImageDecoder::Exception::GetNote() const noexcept
+{
+	return note;
+}
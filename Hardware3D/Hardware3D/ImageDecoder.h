@@ -0,0 +1,45 @@
+﻿#pragma once
+#include "D3DException.h"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+// decodes png, tga and bmp straight into rows of 32 bit bgra pixels (the layout of Surface::Color)
+// plain c++ with sse2 pixel swizzles where available, no os or third party dependencies
+class ImageDecoder
+{
+public:
+	enum class Format
+	{
+		Png,
+		Tga,
+		Bmp,
+	};
+	struct Info
+	{
+		Format format;
+		unsigned int width;
+		unsigned int height;
+	};
+	class Exception : public D3DException
+	{
+	public:
+		Exception(int line, const char* file, std::string note) noexcept;
+		const char* what() const noexcept override;
+		const char* GetType() const noexcept override;
+		const std::string& GetNote() const noexcept;
+	private:
+		std::string note;
+	};
+public:
+	// nullopt when the data isn't in one of the formats / variants handled here
+	// (interlaced png, rle or 16 bit bmp, color mapped tga, ...), callers can fall back to another loader
+	static std::optional<Info> ReadInfo(const unsigned char* pData, size_t size) noexcept;
+	// pDst has room for width * height pixels, throws on truncated or corrupt data
+	static void Decode(const unsigned char* pData, size_t size, const Info& info, std::uint32_t* pDst);
+private:
+	static void DecodePng(const unsigned char* pData, size_t size, const Info& info, std::uint32_t* pDst);
+	static void DecodeTga(const unsigned char* pData, size_t size, const Info& info, std::uint32_t* pDst);
+	static void DecodeBmp(const unsigned char* pData, size_t size, const Info& info, std::uint32_t* pDst);
+};
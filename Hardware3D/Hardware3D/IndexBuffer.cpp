@@ -1,35 +1,80 @@
 ﻿#include "IndexBuffer.h"
 #include "GraphicsErrorMacros.h"
+#include <algorithm>
 
 namespace Bind
 {
 	IndexBuffer::IndexBuffer(Graphics& gfx, const std::vector<unsigned short>& indices)
 		:
-		count((UINT)indices.size())
+		IndexBuffer(gfx, indices.data(), indices.size())
+	{
+	}
+
+	IndexBuffer::IndexBuffer(Graphics& gfx, const std::vector<unsigned int>& indices)
+		:
+		IndexBuffer(gfx, indices.data(), indices.size())
+	{
+	}
+
+	IndexBuffer::IndexBuffer(Graphics& gfx, const unsigned short* pIndices, size_t indexCount)
+		:
+		count((UINT)indexCount)
+	{
+		Create(gfx, pIndices, DXGI_FORMAT_R16_UINT);
+	}
+
+	IndexBuffer::IndexBuffer(Graphics& gfx, const unsigned int* pIndices, size_t indexCount)
+		:
+		count((UINT)indexCount)
+	{
+		const auto fitsShort = std::all_of(pIndices, pIndices + indexCount, [](unsigned int i)
+		{
+			return i <= 0xFFFFu;
+		});
+		if (fitsShort)
+		{
+			const std::vector<unsigned short> narrowed(pIndices, pIndices + indexCount);
+			Create(gfx, narrowed.data(), DXGI_FORMAT_R16_UINT);
+		}
+		else
+		{
+			Create(gfx, pIndices, DXGI_FORMAT_R32_UINT);
+		}
+	}
+
+	void IndexBuffer::Create(Graphics& gfx, const void* pIndices, DXGI_FORMAT indexFormat)
 	{
 		INFOMAN(gfx);
 
+		format = indexFormat;
+		const UINT indexSize = format == DXGI_FORMAT_R16_UINT ? sizeof(unsigned short) : sizeof(unsigned int);
+
 		D3D11_BUFFER_DESC indexBufDesc = {};
 		indexBufDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
 		indexBufDesc.Usage = D3D11_USAGE_DEFAULT;
 		indexBufDesc.CPUAccessFlags = 0u;
 		indexBufDesc.MiscFlags = 0u;
-		indexBufDesc.ByteWidth = UINT(count * sizeof(unsigned short));
-		indexBufDesc.StructureByteStride = sizeof(unsigned short);
+		indexBufDesc.ByteWidth = UINT(count * indexSize);
+		indexBufDesc.StructureByteStride = indexSize;
 
 		D3D11_SUBRESOURCE_DATA indexSubData = {};
-		indexSubData.pSysMem = indices.data();
+		indexSubData.pSysMem = pIndices;
 		GFX_THROW_INFO(GetDevice(gfx)->CreateBuffer(&indexBufDesc, &indexSubData, &pIndexBuffer));
 	}
 
 	void IndexBuffer::Bind(Graphics& gfx) noexcept
 	{
-		GetContext(gfx)->IASetIndexBuffer(pIndexBuffer.Get(), DXGI_FORMAT_R16_UINT, 0u);
+		GetContext(gfx)->IASetIndexBuffer(pIndexBuffer.Get(), format, 0u);
 	}
 
 	UINT IndexBuffer::GetCount() const noexcept
 	{
 		return count;
 	}
+
+	DXGI_FORMAT IndexBuffer::GetFormat() const noexcept
+	{
+		return format;
+	}
 	
 }
@@ -3,14 +3,22 @@
 
 namespace Bind
 {
+	// 32 bit index data is narrowed to 16 bits whenever every index fits
 	class IndexBuffer : public Bindable
 	{
 	public:
 		IndexBuffer(Graphics& gfx, const std::vector<unsigned short>& indices);
+		IndexBuffer(Graphics& gfx, const std::vector<unsigned int>& indices);
+		IndexBuffer(Graphics& gfx, const unsigned short* pIndices, size_t indexCount);
+		IndexBuffer(Graphics& gfx, const unsigned int* pIndices, size_t indexCount);
 		void Bind(Graphics& gfx) noexcept override;
 		UINT GetCount() const noexcept;
+		DXGI_FORMAT GetFormat() const noexcept;
+	private:
+		void Create(Graphics& gfx, const void* pIndices, DXGI_FORMAT indexFormat);
 	protected:
 		UINT count;
+		DXGI_FORMAT format = DXGI_FORMAT_R16_UINT;
 		Microsoft::WRL::ComPtr<ID3D11Buffer> pIndexBuffer;
 	};
 	
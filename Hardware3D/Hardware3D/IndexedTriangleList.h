@@ -8,7 +8,7 @@ class IndexedTriangleList
 {
 public:
 	IndexedTriangleList() = default;
-	IndexedTriangleList(std::vector<T> vertsIn, std::vector<unsigned short> indicesIn)
+	IndexedTriangleList(std::vector<T> vertsIn, std::vector<unsigned int> indicesIn)
 		:
 	vertices(std::move(vertsIn)),
 	indices(std::move(indicesIn))
@@ -49,5 +49,5 @@ public:
 	}
 public:
 	std::vector<T> vertices;
-	std::vector<unsigned short> indices;
+	std::vector<unsigned int> indices;
 };
\ No newline at end of file
@@ -1,15 +1,24 @@
 ﻿#include "InputLayout.h"
 #include "GraphicsErrorMacros.h"
+#include "BindableCodex.h"
+#include <cstring>
 
 namespace Bind
 {
 	InputLayout::InputLayout(Graphics& gfx, const std::vector<D3D11_INPUT_ELEMENT_DESC>& layout,
 	                         ID3DBlob* pVertexShaderByteCode)
+		:
+		InputLayout(gfx, layout.data(), layout.size(), pVertexShaderByteCode)
+	{
+	}
+
+	InputLayout::InputLayout(Graphics& gfx, const D3D11_INPUT_ELEMENT_DESC* pLayout, size_t elementCount,
+	                         ID3DBlob* pVertexShaderByteCode)
 	{
 		INFOMAN(gfx);
 
 		GFX_THROW_INFO(GetDevice(gfx)->CreateInputLayout(
-			layout.data(), (UINT)layout.size(),
+			pLayout, (UINT)elementCount,
 			pVertexShaderByteCode->GetBufferPointer(),
 			pVertexShaderByteCode->GetBufferSize(),
 			&pInputLayout
@@ -20,5 +29,33 @@ namespace Bind
 	{
 		GetContext(gfx)->IASetInputLayout(pInputLayout.Get());
 	}
+
+	std::string InputLayout::GenerateUID(const std::vector<D3D11_INPUT_ELEMENT_DESC>& layout,
+	                                     ID3DBlob* pVertexShaderByteCode)
+	{
+		return GenerateUID(layout.data(), layout.size(), pVertexShaderByteCode);
+	}
+
+	std::string InputLayout::GenerateUID(const D3D11_INPUT_ELEMENT_DESC* pLayout, size_t elementCount,
+	                                     ID3DBlob* pVertexShaderByteCode)
+	{
+		auto uid = Codex::MakeUID(typeid(InputLayout).name());
+		for (size_t i = 0; i < elementCount; i++)
+		{
+			const auto& e = pLayout[i];
+			// semantic names are pointers, key on the text
+			Codex::AppendUID(uid, e.SemanticName, strlen(e.SemanticName) + 1u);
+			Codex::AppendUID(uid, &e.SemanticIndex, sizeof(e.SemanticIndex));
+			Codex::AppendUID(uid, &e.Format, sizeof(e.Format));
+			Codex::AppendUID(uid, &e.InputSlot, sizeof(e.InputSlot));
+			Codex::AppendUID(uid, &e.AlignedByteOffset, sizeof(e.AlignedByteOffset));
+			Codex::AppendUID(uid, &e.InputSlotClass, sizeof(e.InputSlotClass));
+			Codex::AppendUID(uid, &e.InstanceDataStepRate, sizeof(e.InstanceDataStepRate));
+		}
+		const auto bytecodeHash = Codex::HashBytes(pVertexShaderByteCode->GetBufferPointer(),
+			pVertexShaderByteCode->GetBufferSize());
+		Codex::AppendUID(uid, &bytecodeHash, sizeof(bytecodeHash));
+		return uid;
+	}
 	
 }
@@ -7,7 +7,13 @@ namespace Bind
 	{
 	public:
 		InputLayout(Graphics& gfx, const std::vector<D3D11_INPUT_ELEMENT_DESC>& layout, ID3DBlob* pVertexShaderByteCode);
+		// for layouts that only exist as fixed arrays, like Dvtx::StaticLayout::desc
+		InputLayout(Graphics& gfx, const D3D11_INPUT_ELEMENT_DESC* pLayout, size_t elementCount, ID3DBlob* pVertexShaderByteCode);
 		void Bind(Graphics& gfx) noexcept override;
+		// keyed on the element descs and the contents of the bytecode the layout is validated against
+		static std::string GenerateUID(const std::vector<D3D11_INPUT_ELEMENT_DESC>& layout, ID3DBlob* pVertexShaderByteCode);
+		static std::string GenerateUID(const D3D11_INPUT_ELEMENT_DESC* pLayout, size_t elementCount,
+			ID3DBlob* pVertexShaderByteCode);
 	protected:
 		Microsoft::WRL::ComPtr<ID3D11InputLayout> pInputLayout;
 	};
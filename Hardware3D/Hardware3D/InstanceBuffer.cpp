@@ -0,0 +1,96 @@
+﻿#include "InstanceBuffer.h"
+#include "GraphicsErrorMacros.h"
+#include "BindableCodex.h"
+#include <algorithm>
+#include <cstring>
+
+namespace Bind
+{
+	InstanceBuffer::InstanceBuffer(Graphics& gfx)
+		:
+		viewCbuf(gfx, 0u)
+	{
+	}
+
+	void InstanceBuffer::Reserve(Graphics& gfx, UINT count)
+	{
+		INFOMAN(gfx);
+
+		if (count > capacity)
+		{
+			// doubling keeps a slowly growing crowd from recreating the buffer every frame
+			capacity = std::max(count, capacity * 2u);
+			D3D11_BUFFER_DESC bufDesc = {};
+			bufDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+			bufDesc.Usage = D3D11_USAGE_DYNAMIC;
+			bufDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+			bufDesc.MiscFlags = 0u;
+			bufDesc.ByteWidth = UINT(sizeof(DirectX::XMFLOAT4X4) * capacity);
+			bufDesc.StructureByteStride = sizeof(DirectX::XMFLOAT4X4);
+			GFX_THROW_INFO(GetDevice(gfx)->CreateBuffer(&bufDesc, nullptr, &pInstanceBuffer));
+		}
+	}
+
+	void InstanceBuffer::Update(Graphics& gfx, const DirectX::XMFLOAT4X4* pTransforms, UINT count)
+	{
+		INFOMAN(gfx);
+
+		Reserve(gfx, count);
+
+		D3D11_MAPPED_SUBRESOURCE msr;
+		GFX_THROW_INFO(GetContext(gfx)->Map(pInstanceBuffer.Get(), 0u, D3D11_MAP_WRITE_DISCARD, 0u, &msr));
+		std::memcpy(msr.pData, pTransforms, sizeof(DirectX::XMFLOAT4X4) * count);
+		GetContext(gfx)->Unmap(pInstanceBuffer.Get(), 0u);
+
+		const ViewTransforms vt =
+		{
+			DirectX::XMMatrixTranspose(gfx.GetCamera()),
+			DirectX::XMMatrixTranspose(gfx.GetProjection())
+		};
+		viewCbuf.Update(gfx, vt);
+	}
+
+	void InstanceBuffer::Bind(Graphics& gfx) noexcept
+	{
+		const UINT stride = sizeof(DirectX::XMFLOAT4X4);
+		const UINT offset = 0u;
+		GetContext(gfx)->IASetVertexBuffers(slot, 1u, pInstanceBuffer.GetAddressOf(), &stride, &offset);
+		viewCbuf.Bind(gfx);
+	}
+
+	std::vector<D3D11_INPUT_ELEMENT_DESC> InstanceBuffer::MakeLayout(const D3D11_INPUT_ELEMENT_DESC* pVertexLayout,
+	                                                                 size_t elementCount)
+	{
+		std::vector<D3D11_INPUT_ELEMENT_DESC> layout(pVertexLayout, pVertexLayout + elementCount);
+		for (UINT row = 0; row < 4u; row++)
+		{
+			layout.push_back({ "InstanceTransform", row, DXGI_FORMAT_R32G32B32A32_FLOAT, slot,
+				row * (UINT)sizeof(DirectX::XMFLOAT4), D3D11_INPUT_PER_INSTANCE_DATA, 1u });
+		}
+		return layout;
+	}
+
+
+	InstancedBinds::InstancedBinds(Graphics& gfx, const std::wstring& vertexShaderPath,
+	                               const D3D11_INPUT_ELEMENT_DESC* pVertexLayout, size_t elementCount)
+		:
+		pVertexShader(Codex::Resolve<VertexShader>(gfx, vertexShaderPath)),
+		pInputLayout(Codex::Resolve<InputLayout>(gfx, InstanceBuffer::MakeLayout(pVertexLayout, elementCount),
+			pVertexShader->GetBytecode())),
+		instances(gfx)
+	{
+	}
+
+	void InstancedBinds::Bind(Graphics& gfx, const DirectX::XMFLOAT4X4* pTransforms, UINT count)
+	{
+		instances.Update(gfx, pTransforms, count);
+		pVertexShader->Bind(gfx);
+		pInputLayout->Bind(gfx);
+		instances.Bind(gfx);
+	}
+
+	void InstancedBinds::Reserve(Graphics& gfx, UINT count)
+	{
+		instances.Reserve(gfx, count);
+	}
+}
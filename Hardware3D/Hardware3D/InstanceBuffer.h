@@ -0,0 +1,54 @@
+﻿#pragma once
+#include "Bindable.h"
+#include "ConstantBuffers.h"
+#include "InputLayout.h"
+#include "VertexShader.h"
+#include <DirectXMath.h>
+#include <memory>
+#include <vector>
+
+namespace Bind
+{
+	// per instance model transforms as a second vertex stream, plus the view and projection
+	// the instanced shaders combine them with (they take the place of TransformCbuf)
+	class InstanceBuffer : public Bindable
+	{
+	public:
+		static constexpr UINT slot = 1u;
+	private:
+		struct ViewTransforms
+		{
+			DirectX::XMMATRIX view;
+			DirectX::XMMATRIX projection;
+		};
+	public:
+		InstanceBuffer(Graphics& gfx);
+		// grows the stream to fit count instances, an Update that fits then never touches the buffer object
+		// so draws can be recorded on several threads at once
+		void Reserve(Graphics& gfx, UINT count);
+		// grows the stream when count doesn't fit
+		void Update(Graphics& gfx, const DirectX::XMFLOAT4X4* pTransforms, UINT count);
+		void Bind(Graphics& gfx) noexcept override;
+		// vertex layout followed by the four rows of the instance transform (InstanceTransform0-3)
+		static std::vector<D3D11_INPUT_ELEMENT_DESC> MakeLayout(const D3D11_INPUT_ELEMENT_DESC* pVertexLayout, size_t elementCount);
+	private:
+		UINT capacity = 0u;
+		Microsoft::WRL::ComPtr<ID3D11Buffer> pInstanceBuffer;
+		VertexConstantBuffer<ViewTransforms> viewCbuf;
+	};
+
+	// everything an instanced draw binds in place of a drawable's vertex shader, input layout and TransformCbuf
+	// drawables of the same kind can share one
+	class InstancedBinds
+	{
+	public:
+		InstancedBinds(Graphics& gfx, const std::wstring& vertexShaderPath,
+			const D3D11_INPUT_ELEMENT_DESC* pVertexLayout, size_t elementCount);
+		void Bind(Graphics& gfx, const DirectX::XMFLOAT4X4* pTransforms, UINT count);
+		void Reserve(Graphics& gfx, UINT count);
+	private:
+		std::shared_ptr<VertexShader> pVertexShader;
+		std::shared_ptr<InputLayout> pInputLayout;
+		InstanceBuffer instances;
+	};
+}
@@ -0,0 +1,288 @@
+﻿#include "JobSystem.h"
+#include "Profiler.h"
+#include <string>
+
+struct JobSystem::Job
+{
+	std::function<void()> task;
+	Counter* pCounter;
+};
+
+namespace
+{
+	// which system's deque the calling thread owns, if any
+	thread_local const JobSystem* pWorkerSystem = nullptr;
+	thread_local int workerIndex = -1;
+}
+
+bool JobSystem::Counter::IsDone() const noexcept
+{
+	return pending.load(std::memory_order_acquire) == 0u;
+}
+
+JobSystem::WorkQueue::WorkQueue() noexcept
+{
+	for (auto& j : jobs)
+	{
+		j.store(nullptr, std::memory_order_relaxed);
+	}
+}
+
+bool JobSystem::WorkQueue::Push(Job* pJob) noexcept
+{
+	const auto b = bottom.load(std::memory_order_relaxed);
+	const auto t = top.load(std::memory_order_acquire);
+	if (b - t >= capacity)
+	{
+		return false;
+	}
+	jobs[size_t(b & (capacity - 1))].store(pJob, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	bottom.store(b + 1, std::memory_order_relaxed);
+	return true;
+}
+
+JobSystem::Job* JobSystem::WorkQueue::Pop() noexcept
+{
+	const auto b = bottom.load(std::memory_order_relaxed) - 1;
+	bottom.store(b, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	auto t = top.load(std::memory_order_relaxed);
+	if (t > b)
+	{
+		bottom.store(b + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+	auto pJob = jobs[size_t(b & (capacity - 1))].load(std::memory_order_relaxed);
+	if (t == b)
+	{
+		// last one left, a thief may be after it too
+		if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			pJob = nullptr;
+		}
+		bottom.store(b + 1, std::memory_order_relaxed);
+	}
+	return pJob;
+}
+
+JobSystem::Job* JobSystem::WorkQueue::Steal() noexcept
+{
+	auto t = top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	const auto b = bottom.load(std::memory_order_acquire);
+	if (t >= b)
+	{
+		return nullptr;
+	}
+	const auto pJob = jobs[size_t(t & (capacity - 1))].load(std::memory_order_relaxed);
+	if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+	{
+		return nullptr;
+	}
+	return pJob;
+}
+
+JobSystem::JobSystem(unsigned int workerCount)
+{
+	for (unsigned int i = 0; i < workerCount; i++)
+	{
+		queues.push_back(std::make_unique<WorkQueue>());
+	}
+	for (unsigned int i = 0; i < workerCount; i++)
+	{
+		workers.emplace_back([this, i]() { RunWorker(i); });
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (auto& w : workers)
+	{
+		w.join();
+	}
+	// whatever nobody waited for is dropped
+	for (auto& q : queues)
+	{
+		while (const auto pJob = q->Pop())
+		{
+			delete pJob;
+		}
+	}
+	for (const auto pJob : sharedJobs)
+	{
+		delete pJob;
+	}
+}
+
+JobSystem& JobSystem::Get()
+{
+	static JobSystem system;
+	return system;
+}
+
+void JobSystem::Run(std::function<void()> task, Counter* pCounter, Counter* pDependency)
+{
+	const auto pJob = new Job{ std::move(task), pCounter };
+	if (pCounter)
+	{
+		pCounter->pending.fetch_add(1u, std::memory_order_relaxed);
+	}
+	if (pDependency)
+	{
+		std::lock_guard<std::mutex> lock(pDependency->mutex);
+		if (pDependency->pending.load(std::memory_order_acquire) != 0u)
+		{
+			pDependency->continuations.push_back(pJob);
+			return;
+		}
+	}
+	Schedule(pJob);
+}
+
+void JobSystem::Wait(Counter& counter)
+{
+	while (counter.pending.load(std::memory_order_acquire) != 0u)
+	{
+		if (const auto pJob = FindJob())
+		{
+			Execute(pJob);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+	// the last job may still be holding the counter
+	std::lock_guard<std::mutex> lock(counter.mutex);
+}
+
+JobSystem::Stats JobSystem::GetStats() const noexcept
+{
+	return { (unsigned int)workers.size(), jobsRun.load(std::memory_order_relaxed), jobsStolen.load(std::memory_order_relaxed) };
+}
+
+void JobSystem::Schedule(Job* pJob)
+{
+	// counted before it shows up in a queue, so whoever takes it never sees the count drop below zero
+	queuedJobs.fetch_add(1u, std::memory_order_seq_cst);
+	const auto index = GetWorkerIndex();
+	if (index >= 0)
+	{
+		if (!queues[index]->Push(pJob))
+		{
+			// deque full, nothing is lost by doing it right here
+			queuedJobs.fetch_sub(1u, std::memory_order_relaxed);
+			Execute(pJob);
+			return;
+		}
+	}
+	else
+	{
+		std::lock_guard<std::mutex> lock(sharedMutex);
+		sharedJobs.push_back(pJob);
+	}
+	if (sleepingWorkers.load(std::memory_order_seq_cst) != 0u)
+	{
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+		}
+		wake.notify_one();
+	}
+}
+
+void JobSystem::Execute(Job* pJob) noexcept
+{
+	pJob->task();
+	jobsRun.fetch_add(1u, std::memory_order_relaxed);
+	const auto pCounter = pJob->pCounter;
+	delete pJob;
+	if (pCounter)
+	{
+		Signal(*pCounter);
+	}
+}
+
+void JobSystem::Signal(Counter& counter)
+{
+	std::vector<Job*> released;
+	{
+		std::lock_guard<std::mutex> lock(counter.mutex);
+		if (counter.pending.fetch_sub(1u, std::memory_order_acq_rel) == 1u)
+		{
+			released.swap(counter.continuations);
+		}
+	}
+	for (const auto pJob : released)
+	{
+		Schedule(pJob);
+	}
+}
+
+JobSystem::Job* JobSystem::FindJob() noexcept
+{
+	const auto index = GetWorkerIndex();
+	Job* pJob = nullptr;
+	if (index >= 0)
+	{
+		pJob = queues[index]->Pop();
+	}
+	if (!pJob)
+	{
+		std::lock_guard<std::mutex> lock(sharedMutex);
+		if (!sharedJobs.empty())
+		{
+			pJob = sharedJobs.front();
+			sharedJobs.pop_front();
+		}
+	}
+	// start next to our own deque so thieves spread out over the victims
+	for (size_t i = 1; !pJob && i <= queues.size(); i++)
+	{
+		const auto victim = (size_t(index + 1) + i) % queues.size();
+		if (int(victim) != index && (pJob = queues[victim]->Steal()))
+		{
+			jobsStolen.fetch_add(1u, std::memory_order_relaxed);
+		}
+	}
+	if (pJob)
+	{
+		queuedJobs.fetch_sub(1u, std::memory_order_relaxed);
+	}
+	return pJob;
+}
+
+void JobSystem::RunWorker(unsigned int index) noexcept
+{
+	pWorkerSystem = this;
+	workerIndex = int(index);
+	Profiler::Get().SetThreadName("Job Worker " + std::to_string(index));
+	while (!stopping.load(std::memory_order_relaxed))
+	{
+		if (const auto pJob = FindJob())
+		{
+			Execute(pJob);
+			continue;
+		}
+		// announce the sleep before checking for work, so a push either sees us asleep or we see its job
+		sleepingWorkers.fetch_add(1u, std::memory_order_seq_cst);
+		{
+			std::unique_lock<std::mutex> lock(sleepMutex);
+			wake.wait(lock, [this]()
+			{
+				return queuedJobs.load(std::memory_order_seq_cst) != 0u || stopping.load(std::memory_order_relaxed);
+			});
+		}
+		sleepingWorkers.fetch_sub(1u, std::memory_order_relaxed);
+	}
+}
+
+int JobSystem::GetWorkerIndex() const noexcept
+{
+	return pWorkerSystem == this ? workerIndex : -1;
+}
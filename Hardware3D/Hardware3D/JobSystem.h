@@ -0,0 +1,142 @@
+﻿#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// task scheduler shared by everything in the engine that splits work over cores
+// every worker owns a deque it pushes to and pops from at the back, idle workers steal from the front of the
+// others'. jobs pushed from threads outside the system go through a shared queue instead
+// a thread waiting on a counter runs jobs until the counter drains, so jobs may wait on jobs they spawned
+class JobSystem
+{
+private:
+	struct Job;
+public:
+	// jobs still to finish. waiting for it or running jobs after it is how dependencies are expressed
+	// a counter must outlive the jobs counted on it and the jobs waiting for it
+	class Counter
+	{
+		friend class JobSystem;
+	public:
+		Counter() = default;
+		Counter(const Counter&) = delete;
+		Counter& operator=(const Counter&) = delete;
+		bool IsDone() const noexcept;
+	private:
+		std::atomic<unsigned int> pending{ 0u };
+		// held while the count drops, so a finished wait knows the last job let go of the counter
+		std::mutex mutex;
+		// jobs to start once pending gets to zero
+		std::vector<Job*> continuations;
+	};
+	struct Stats
+	{
+		unsigned int workers;
+		// totals since the system was created
+		size_t jobsRun;
+		size_t jobsStolen;
+	};
+public:
+	// one worker less than there are cores, whoever waits makes up for it
+	JobSystem(unsigned int workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1u);
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+	~JobSystem();
+	// the engine wide instance
+	static JobSystem& Get();
+	// task must not throw. pCounter (if any) counts the job as pending until it returns
+	// with a dependency the job only starts once that counter has drained
+	void Run(std::function<void()> task, Counter* pCounter = nullptr, Counter* pDependency = nullptr);
+	// runs other jobs while waiting
+	void Wait(Counter& counter);
+	// f(begin, end) for every grain sized range of [0, count), returns once all of them have run
+	// the first exception thrown by f is rethrown here after the others finished
+	template<typename F>
+	void ParallelFor(size_t count, size_t grain, const F& f)
+	{
+		grain = std::max(grain, size_t(1u));
+		if (count <= grain)
+		{
+			if (count > 0u)
+			{
+				f(size_t(0u), count);
+			}
+			return;
+		}
+		Counter counter;
+		std::exception_ptr pError;
+		std::mutex errorMutex;
+		for (size_t begin = 0u; begin < count; begin += grain)
+		{
+			Run([&f, &pError, &errorMutex, begin, end = std::min(count, begin + grain)]()
+			{
+				try
+				{
+					f(begin, end);
+				}
+				catch (...)
+				{
+					std::lock_guard<std::mutex> lock(errorMutex);
+					if (!pError)
+					{
+						pError = std::current_exception();
+					}
+				}
+			}, &counter);
+		}
+		Wait(counter);
+		if (pError)
+		{
+			std::rethrow_exception(pError);
+		}
+	}
+	Stats GetStats() const noexcept;
+private:
+	// chase-lev deque of a fixed size, only the owner pushes and pops, anyone may steal
+	class WorkQueue
+	{
+	public:
+		WorkQueue() noexcept;
+		// false when full
+		bool Push(Job* pJob) noexcept;
+		Job* Pop() noexcept;
+		Job* Steal() noexcept;
+	private:
+		static constexpr std::int64_t capacity = 4096;
+		alignas(64) std::atomic<std::int64_t> top{ 0 };
+		alignas(64) std::atomic<std::int64_t> bottom{ 0 };
+		std::array<std::atomic<Job*>, capacity> jobs;
+	};
+private:
+	void Schedule(Job* pJob);
+	void Execute(Job* pJob) noexcept;
+	// counts the job on its counter as done and starts what was waiting for it
+	void Signal(Counter& counter);
+	// own deque first, then the shared queue, then the other workers
+	Job* FindJob() noexcept;
+	void RunWorker(unsigned int index) noexcept;
+	// index of the calling thread's deque, -1 for threads outside the system
+	int GetWorkerIndex() const noexcept;
+private:
+	std::vector<std::unique_ptr<WorkQueue>> queues;
+	std::vector<std::thread> workers;
+	std::mutex sharedMutex;
+	std::deque<Job*> sharedJobs;
+	// jobs sitting in any queue, idle workers sleep while there are none
+	std::atomic<size_t> queuedJobs{ 0u };
+	std::atomic<unsigned int> sleepingWorkers{ 0u };
+	std::mutex sleepMutex;
+	std::condition_variable wake;
+	std::atomic<bool> stopping{ false };
+	std::atomic<size_t> jobsRun{ 0u };
+	std::atomic<size_t> jobsStolen{ 0u };
+};
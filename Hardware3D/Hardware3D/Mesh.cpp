@@ -1,10 +1,21 @@
 ﻿#include "Mesh.h"
 #include "imgui/imgui.h"
+#include "JobSystem.h"
+#include "Profiler.h"
 #include <unordered_map>
 #include <sstream>
+#include <algorithm>
 
 namespace dx = DirectX;
 
+namespace
+{
+	// fifo size the optimizer targets, a conservative guess for current hardware
+	constexpr unsigned int optimizerCacheSize = 16u;
+	// folded into the cache key so optimized and raw imports never share a cache file
+	constexpr std::uint64_t optimizerKey = 0x9E3779B97F4A7C15ull;
+}
+
 ModelException::ModelException(int line, const char* file, std::string note) noexcept
 	:
 	D3DException(line, file),
@@ -32,7 +43,10 @@ const std::string& ModelException::GetNote() const noexcept
 }
 
 // Mesh
-Mesh::Mesh(Graphics& gfx, std::vector<std::unique_ptr<Bind::Bindable>> bindPtrs)
+Mesh::Mesh(Graphics& gfx, std::vector<std::shared_ptr<Bind::Bindable>> bindPtrs, const Bounds& bounds,
+           std::shared_ptr<Bind::InstancedBinds> pInstancedBinds)
+	:
+	bounds(bounds)
 {
 	if (!IsStaticInitialized())
 	{
@@ -41,10 +55,9 @@ Mesh::Mesh(Graphics& gfx, std::vector<std::unique_ptr<Bind::Bindable>> bindPtrs)
 
 	for (auto& pb : bindPtrs)
 	{
-		if (auto pi = dynamic_cast<Bind::IndexBuffer*>(pb.get()))
+		if (auto pi = std::dynamic_pointer_cast<Bind::IndexBuffer>(pb))
 		{
-			AddIndexBuffer(std::unique_ptr<Bind::IndexBuffer>{pi});
-			pb.release();
+			AddIndexBuffer(std::move(pi));
 		}
 		else
 		{
@@ -53,6 +66,7 @@ Mesh::Mesh(Graphics& gfx, std::vector<std::unique_ptr<Bind::Bindable>> bindPtrs)
 	}
 
 	AddBind(std::make_unique<Bind::TransformCbuf>(gfx, *this));
+	SetInstancedBinds(std::move(pInstancedBinds));
 }
 
 void Mesh::Draw(Graphics& gfx, DirectX::FXMMATRIX accumulatedTransform) const noxnd
@@ -61,76 +75,20 @@ void Mesh::Draw(Graphics& gfx, DirectX::FXMMATRIX accumulatedTransform) const no
 	Drawable::Draw(gfx);
 }
 
-DirectX::XMMATRIX Mesh::GetTransformXM() const noexcept
-{
-	return DirectX::XMLoadFloat4x4(&transform);
-}
-
-
-// Node
-Node::Node(const std::string& name, std::vector<Mesh*> meshPtrs, const DirectX::XMMATRIX& transform) noxnd
-	:
-	name(name),
-	meshPtrs(std::move(meshPtrs))
-{
-	DirectX::XMStoreFloat4x4(&this->transform, transform);
-	DirectX::XMStoreFloat4x4(&appliedTransform, dx::XMMatrixIdentity());
-}
-
-void Node::Draw(Graphics& gfx, DirectX::FXMMATRIX accumulatedTransform) const noxnd
+void Mesh::Stage(Graphics& gfx, DirectX::FXMMATRIX accumulatedTransform) const
 {
-	const auto built = 
-		dx::XMLoadFloat4x4(&appliedTransform) *
-		dx::XMLoadFloat4x4(&transform) *
-		accumulatedTransform;
-
-	for (const auto pm : meshPtrs)
-	{
-		pm->Draw(gfx, built);
-	}
-	for (const auto& pc : childPtrs)
-	{
-		pc->Draw(gfx, built);
-	}
-}
-
-void Node::AddChild(std::unique_ptr<Node> pChild) noxnd
-{
-	assert(pChild);
-	childPtrs.push_back(std::move(pChild));
+	DirectX::XMStoreFloat4x4(&transform, accumulatedTransform);
+	Drawable::Stage(gfx);
 }
 
-void Node::ShowTree(int& nodeIndexTracked, std::optional<int>& selectedIndex, Node*& pSelectedNode) const noexcept
+DirectX::XMMATRIX Mesh::GetTransformXM() const noexcept
 {
-	// nodeIndex serves as the uid for gui tree nodes, incremented throughout recursion
-	const int currentNodeIndex = nodeIndexTracked;
-	nodeIndexTracked++;
-	// build up flags for current node
-	const auto node_flags = ImGuiTreeNodeFlags_OpenOnArrow
-		| ((currentNodeIndex == selectedIndex.value_or( -1 )) ? ImGuiTreeNodeFlags_Selected : 0)
-		| ((childPtrs.size() == 0) ? ImGuiTreeNodeFlags_Leaf : 0);
-	// render this node
-	const auto expanded = ImGui::TreeNodeEx( (void*)(intptr_t)currentNodeIndex,node_flags,name.c_str());
-	// processing for selecting node
-	if( ImGui::IsItemClicked() )
-	{
-		selectedIndex = currentNodeIndex;
-		pSelectedNode = const_cast<Node*>(this);
-	}
-	// recursive rendering of open node's children
-	if( expanded )
-	{
-		for( const auto& pChild : childPtrs )
-		{
-			pChild->ShowTree( nodeIndexTracked,selectedIndex,pSelectedNode );
-		}
-		ImGui::TreePop();
-	}
+	return DirectX::XMLoadFloat4x4(&transform);
 }
 
-void Node::SetAppliedTransform(DirectX::FXMMATRIX transform) noexcept
+const Bounds& Mesh::GetBounds() const noexcept
 {
-	dx::XMStoreFloat4x4(&appliedTransform, transform);
+	return bounds;
 }
 
 
@@ -138,27 +96,32 @@ void Node::SetAppliedTransform(DirectX::FXMMATRIX transform) noexcept
 class ModelWindow // pImpl idiom, only defined in this .cpp
 {
 public:
-	void Show(const char* windowName, const Node& root) noexcept
+	void Show(const char* windowName, const SceneGraph& graph, const std::optional<MeshOptimizer::Report>& optimizerReport) noexcept
 	{
 		// window name defaults to "Model"
 		windowName = windowName ? windowName : "Model";
-		// need an int to track node indices and selected node
-		int nodeIndexTracker = 0;
 		if (ImGui::Begin(windowName))
 		{
 			ImGui::Columns(2, nullptr, true);
-			root.ShowTree(nodeIndexTracker, selectedIndex, pSelectedNode);
+			graph.ShowTree(0u, selectedIndex);
 
 			ImGui::NextColumn();
-			if (pSelectedNode != nullptr)
+			if (selectedIndex)
 			{
 				auto& transform = transforms[*selectedIndex];
 				ImGui::Text("Orientation");
-				ImGui::SliderAngle("Roll", &transform.roll, -180.0f, 180.0f);
-				ImGui::SliderAngle("Pitch", &transform.pitch, -180.0f, 180.0f);
-				ImGui::SliderAngle("Yaw", &transform.yaw, -180.0f, 180.0f);
+				transformChanged |= ImGui::SliderAngle("Roll", &transform.roll, -180.0f, 180.0f);
+				transformChanged |= ImGui::SliderAngle("Pitch", &transform.pitch, -180.0f, 180.0f);
+				transformChanged |= ImGui::SliderAngle("Yaw", &transform.yaw, -180.0f, 180.0f);
 
-				ImGui::DragFloat3("Position", transform.pos, 1.0f, -20.0f, 20.0f);
+				transformChanged |= ImGui::DragFloat3("Position", transform.pos, 1.0f, -20.0f, 20.0f);
+			}
+			ImGui::Columns(1);
+			if (optimizerReport)
+			{
+				ImGui::Text("Vertex cache (fifo %u)", optimizerCacheSize);
+				ImGui::Text("ACMR %.3f -> %.3f", optimizerReport->before.GetACMR(), optimizerReport->after.GetACMR());
+				ImGui::Text("ATVR %.3f -> %.3f", optimizerReport->before.GetATVR(), optimizerReport->after.GetATVR());
 			}
 		}
 		ImGui::End();
@@ -171,14 +134,22 @@ public:
 			dx::XMMatrixTranslation(transform.pos[0], transform.pos[1], transform.pos[2]);
 	}
 
-	Node* GetSelectedNode() const noexcept
+	std::optional<int> GetSelectedIndex() const noexcept
 	{
-		return pSelectedNode;
+		return selectedIndex;
+	}
+
+	// true once after the selected node's transform was edited
+	bool TakeTransformChange() noexcept
+	{
+		const bool changed = transformChanged;
+		transformChanged = false;
+		return changed;
 	}
 
 private:
 	std::optional<int> selectedIndex;
-	Node* pSelectedNode = nullptr;
+	bool transformChanged = false;
 
 	struct TransformParameters
 	{
@@ -191,123 +162,222 @@ private:
 	std::unordered_map<int, TransformParameters> transforms;
 };
 
-Model::Model(Graphics& gfx, const std::string fileName)
+Model::Model(Graphics& gfx, const std::string fileName, std::optional<Dvtx::QuantizationBudget> quantization,
+             bool optimizeMeshes)
 	:
 	pWindow(std::make_unique<ModelWindow>())
 {
+	PROFILE_ZONE("Model::Model");
+	constexpr unsigned int importFlags =
+		aiProcess_Triangulate |
+		aiProcess_JoinIdenticalVertices |
+		aiProcess_ConvertToLeftHanded |
+		aiProcess_GenNormals;
+
+	// cache hit builds everything straight from the mapped file
+	std::uint64_t importKey = quantization ?
+		(std::uint64_t(quantization->GetHash()) << 32u) | importFlags :
+		importFlags;
+	if (optimizeMeshes)
+	{
+		importKey ^= optimizerKey;
+	}
+	const MeshCache cache(fileName, importKey);
+	if (cache.IsLoaded())
+	{
+		for (const auto& mesh : cache.GetMeshes())
+		{
+			meshPtrs.push_back(MakeMesh(gfx, mesh));
+		}
+		pGraph = std::make_unique<SceneGraph>(cache.GetNodes(), meshPtrs);
+		return;
+	}
+
 	Assimp::Importer imp;
-	const auto pScene = imp.ReadFile(fileName.c_str(),
-	                                 aiProcess_Triangulate |
-	                                 aiProcess_JoinIdenticalVertices |
-	                                 aiProcess_ConvertToLeftHanded |
-	                                 aiProcess_GenNormals
-	);
+	const auto pScene = imp.ReadFile(fileName.c_str(), importFlags);
 
 	if (pScene == nullptr)
 	{
 		throw ModelException(__LINE__, __FILE__, imp.GetErrorString());
 	}
 
-	for (size_t i = 0; i < pScene->mNumMeshes; i++)
+	if (optimizeMeshes)
 	{
-		meshPtrs.push_back(ParseMesh(gfx, *pScene->mMeshes[i]));
+		optimizerReport.emplace();
 	}
+	const auto meshes = ParseMeshes(*pScene, quantization, optimizerReport);
+	std::vector<MeshCache::NodeRecord> nodes;
+	ParseNode(*pScene->mRootNode, nodes);
+
+	cache.Write(meshes, nodes);
 
-	pRoot = ParseNode(*pScene->mRootNode);
+	for (const auto& mesh : meshes)
+	{
+		meshPtrs.push_back(MakeMesh(gfx, MeshCache::MakeView(mesh)));
+	}
+	pGraph = std::make_unique<SceneGraph>(nodes, meshPtrs);
 }
 
-void Model::Draw(Graphics& gfx) const noxnd
+void Model::Submit(RenderQueue& queue) const noxnd
 {
-	if (auto node = pWindow->GetSelectedNode())
+	// an unedited model does no transform work here, Submit only rebuilds what was dirtied
+	if (pWindow->TakeTransformChange())
 	{
-		node->SetAppliedTransform(pWindow->GetTransform());
+		pGraph->SetAppliedTransform(*pWindow->GetSelectedIndex(), pWindow->GetTransform());
 	}
-	pRoot->Draw(gfx, dx::XMMatrixIdentity());
+	pGraph->Update();
+	pGraph->Submit(queue);
+}
+
+void Model::Submit(RenderQueue& queue, DirectX::FXMMATRIX placement) const noxnd
+{
+	pGraph->Update();
+	pGraph->Submit(queue, placement);
 }
 
 void Model::ShowWindow(const char* windowName) noexcept
 {
-	pWindow->Show(windowName, *pRoot);
+	pWindow->Show(windowName, *pGraph, optimizerReport);
 }
 
-std::unique_ptr<Mesh> Model::ParseMesh(Graphics& gfx, const aiMesh& mesh)
+std::vector<MeshCache::MeshData> Model::ParseMeshes(const aiScene& scene,
+                                                   const std::optional<Dvtx::QuantizationBudget>& quantization,
+                                                   std::optional<MeshOptimizer::Report>& optimizerReport)
 {
-	namespace dx = DirectX;
-	using Dvtx::VertexLayout;
+	// meshes don't depend on each other so the cpu side is built as one job per mesh,
+	// the gpu resources are created afterwards on the calling thread
+	std::vector<std::optional<MeshCache::MeshData>> parsed(scene.mNumMeshes);
+	// per mesh so jobs never share one, summed up at the end
+	std::vector<std::optional<MeshOptimizer::Report>> reports(scene.mNumMeshes, optimizerReport);
+	JobSystem::Get().ParallelFor(scene.mNumMeshes, 1u, [&](size_t begin, size_t end)
+	{
+		for (auto i = begin; i < end; i++)
+		{
+			parsed[i].emplace(ParseMesh(*scene.mMeshes[i], quantization, reports[i]));
+		}
+	});
 
-	Dvtx::VertexBuffer vbuf(std::move(
-		VertexLayout{}
-		.Append(VertexLayout::Position3D)
-		.Append(VertexLayout::Normal)
-	));
+	if (optimizerReport)
+	{
+		for (const auto& r : reports)
+		{
+			optimizerReport->before += r->before;
+			optimizerReport->after += r->after;
+		}
+	}
 
-	for (unsigned int i = 0; i < mesh.mNumVertices; i++)
+	std::vector<MeshCache::MeshData> meshes;
+	meshes.reserve(parsed.size());
+	for (auto& m : parsed)
 	{
-		vbuf.EmplaceBack(
-			*reinterpret_cast<dx::XMFLOAT3*>(&mesh.mVertices[i]),
-			*reinterpret_cast<dx::XMFLOAT3*>(&mesh.mNormals[i])
-		);
+		meshes.push_back(std::move(*m));
 	}
+	return meshes;
+}
+
+MeshCache::MeshData Model::ParseMesh(const aiMesh& mesh, const std::optional<Dvtx::QuantizationBudget>& quantization,
+                                     std::optional<MeshOptimizer::Report>& optimizerReport)
+{
+	namespace dx = DirectX;
+	using Dvtx::VertexLayout;
+
+	using Layout = Dvtx::StaticLayout<VertexLayout::Position3D, VertexLayout::Normal>;
 
-	std::vector<unsigned short> indices;
-	indices.reserve(mesh.mNumFaces * 3);
+	MeshCache::MeshData data{ Dvtx::VertexBuffer(Layout::MakeDynamic()) };
+
+	// taken before any quantization so culling never sees a shrunk mesh
+	data.bounds = Bounds::FromPoints(reinterpret_cast<const char*>(mesh.mVertices), sizeof(aiVector3D), mesh.mNumVertices);
+	data.vertices.EmplaceBackBulk(mesh.mNumVertices,
+		reinterpret_cast<const dx::XMFLOAT3*>(mesh.mVertices),
+		reinterpret_cast<const dx::XMFLOAT3*>(mesh.mNormals)
+	);
+	data.indices.reserve(mesh.mNumFaces * 3);
 	for (unsigned int i = 0; i < mesh.mNumFaces; i++)
 	{
 		const auto& face = mesh.mFaces[i];
 		assert(face.mNumIndices == 3);
-		indices.push_back(face.mIndices[0]);
-		indices.push_back(face.mIndices[1]);
-		indices.push_back(face.mIndices[2]);
+		data.indices.push_back(face.mIndices[0]);
+		data.indices.push_back(face.mIndices[1]);
+		data.indices.push_back(face.mIndices[2]);
 	}
 
-	std::vector<std::unique_ptr<Bind::Bindable>> bindablePtrs;
+	// reordering works on the full precision positions, so it has to run before quantizing
+	if (optimizerReport)
+	{
+		optimizerReport = MeshOptimizer::Optimize(data.vertices, data.indices, optimizerCacheSize);
+	}
+	if (quantization)
+	{
+		data.vertices = Dvtx::Quantize(data.vertices, *quantization);
+	}
 
-	bindablePtrs.push_back(std::make_unique<Bind::VertexBuffer>(gfx, vbuf));
+	return data;
+}
 
-	bindablePtrs.push_back(std::make_unique<Bind::IndexBuffer>(gfx, indices));
+void Model::ParseNode(const aiNode& node, std::vector<MeshCache::NodeRecord>& records)
+{
+	namespace dx = DirectX;
+	MeshCache::NodeRecord record;
+	record.name = node.mName.C_Str();
+	dx::XMStoreFloat4x4(&record.transform, dx::XMMatrixTranspose(dx::XMLoadFloat4x4(
+		reinterpret_cast<const dx::XMFLOAT4X4*>(&node.mTransformation)
+	)));
+	record.meshIndices.assign(node.mMeshes, node.mMeshes + node.mNumMeshes);
+	record.childCount = node.mNumChildren;
+	records.push_back(std::move(record));
 
-	auto pvs = std::make_unique<Bind::VertexShader>(gfx, L"PhongVS.cso");
+	for (size_t i = 0; i < node.mNumChildren; i++)
+	{
+		ParseNode(*node.mChildren[i], records);
+	}
+}
+
+std::unique_ptr<Mesh> Model::MakeMesh(Graphics& gfx, const MeshCache::MeshView& mesh)
+{
+	std::vector<std::shared_ptr<Bind::Bindable>> bindablePtrs;
+
+	bindablePtrs.push_back(std::make_shared<Bind::VertexBuffer>(gfx, mesh.layout, mesh.pVertices, mesh.vertexBytes));
+
+	if (mesh.indexSize == sizeof(unsigned short))
+	{
+		bindablePtrs.push_back(std::make_shared<Bind::IndexBuffer>(gfx,
+			static_cast<const unsigned short*>(mesh.pIndices), mesh.indexCount));
+	}
+	else
+	{
+		bindablePtrs.push_back(std::make_shared<Bind::IndexBuffer>(gfx,
+			static_cast<const unsigned int*>(mesh.pIndices), mesh.indexCount));
+	}
+
+	// octahedron encoded normals need decoding in the vertex shader, half positions are expanded by the input assembler
+	bool octNormals = false;
+	for (size_t i = 0; i < mesh.layout.GetElementCount(); i++)
+	{
+		octNormals |= mesh.layout.ResolveByIndex(i).GetType() == Dvtx::VertexLayout::NormalOct16;
+	}
+	// shaders, layouts and material constants are shared by every mesh built from the same inputs
+	auto pvs = Bind::Codex::Resolve<Bind::VertexShader>(gfx, std::wstring(octNormals ? L"PhongOctVS.cso" : L"PhongVS.cso"));
 	auto pvsbc = pvs->GetBytecode();
 	bindablePtrs.push_back(std::move(pvs));
 
-	bindablePtrs.push_back(std::make_unique<Bind::PixelShader>(gfx, L"PhongPS.cso"));
+	bindablePtrs.push_back(Bind::Codex::Resolve<Bind::PixelShader>(gfx, std::wstring(L"PhongPS.cso")));
 
-	bindablePtrs.push_back(std::make_unique<Bind::InputLayout>(gfx, vbuf.GetLayout().GetD3DLayout(), pvsbc));
+	const auto layoutDesc = mesh.layout.GetD3DLayout();
+	bindablePtrs.push_back(Bind::Codex::Resolve<Bind::InputLayout>(gfx, layoutDesc, pvsbc));
+	auto pInstanced = std::make_shared<Bind::InstancedBinds>(gfx,
+		octNormals ? L"PhongOctInstancedVS.cso" : L"PhongInstancedVS.cso", layoutDesc.data(), layoutDesc.size());
 
 	struct PSMaterialConstant
 	{
 		DirectX::XMFLOAT3 color = {0.6f, 0.6f, 0.8f};
 		float specularIntensity = 0.6f;
 		float specularPower = 30.0f;
-		float padding[3];
+		// zeroed, the contents are part of the codex key
+		float padding[3] = {};
 	} pmc;
-	bindablePtrs.push_back(std::make_unique<Bind::PixelConstantBuffer<PSMaterialConstant>>(gfx, pmc, 1u));
-
-	return std::make_unique<Mesh>(gfx, std::move(bindablePtrs));
-}
-
-std::unique_ptr<Node> Model::ParseNode(const aiNode& node) noexcept
-{
-	namespace dx = DirectX;
-	const auto transform = dx::XMMatrixTranspose(dx::XMLoadFloat4x4(
-		reinterpret_cast<const dx::XMFLOAT4X4*>(&node.mTransformation)
-	));
-
-	std::vector<Mesh*> curMeshPtrs;
-	curMeshPtrs.reserve(node.mNumMeshes);
-	for (size_t i = 0; i < node.mNumMeshes; i++)
-	{
-		const auto meshIdx = node.mMeshes[i];
-		curMeshPtrs.push_back(meshPtrs.at(meshIdx).get());
-	}
-
-	auto pNode = std::make_unique<Node>(node.mName.C_Str(), std::move(curMeshPtrs), transform);
-	for (size_t i = 0; i < node.mNumChildren; i++)
-	{
-		pNode->AddChild(ParseNode(*node.mChildren[i]));
-	}
+	bindablePtrs.push_back(Bind::Codex::Resolve<Bind::PixelConstantBuffer<PSMaterialConstant>>(gfx, pmc, 1u));
 
-	return pNode;
+	return std::make_unique<Mesh>(gfx, std::move(bindablePtrs), mesh.bounds, std::move(pInstanced));
 }
 
 Model::~Model() noexcept = default;
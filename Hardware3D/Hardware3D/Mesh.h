@@ -7,6 +7,12 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include "ConditionalNoExcept.h"
+#include "RenderQueue.h"
+#include "MeshCache.h"
+#include "VertexQuantization.h"
+#include "MeshOptimizer.h"
+#include "SceneGraph.h"
+#include "InstanceBuffer.h"
 
 class ModelException : public D3DException
 {
@@ -22,44 +28,41 @@ private:
 class Mesh : public DrawableBase<Mesh>
 {
 public:
-	Mesh(Graphics& gfx, std::vector<std::unique_ptr<Bind::Bindable>> bindPtrs);
-	void Draw(Graphics& gfx, DirectX::FXMMATRIX accumulatedTransform) const noxnd;
+	Mesh(Graphics& gfx, std::vector<std::shared_ptr<Bind::Bindable>> bindPtrs, const Bounds& bounds,
+		std::shared_ptr<Bind::InstancedBinds> pInstancedBinds);
+	void Draw(Graphics& gfx, DirectX::FXMMATRIX accumulatedTransform) const noxnd override;
+	void Stage(Graphics& gfx, DirectX::FXMMATRIX accumulatedTransform) const override;
 	DirectX::XMMATRIX GetTransformXM() const noexcept override;
+	// in model space of the mesh
+	const Bounds& GetBounds() const noexcept;
 private:
 	mutable DirectX::XMFLOAT4X4 transform;
-};
-
-class Node
-{
-	friend class Model;
-	friend class ModelWindow;
-public:
-	Node(const std::string& name, std::vector<Mesh*> meshPtrs,const DirectX::XMMATRIX& transform ) noxnd;
-	void Draw( Graphics& gfx,DirectX::FXMMATRIX accumulatedTransform ) const noxnd;
-	void SetAppliedTransform(DirectX::FXMMATRIX transform) noexcept;
-private:
-	void AddChild( std::unique_ptr<Node> pChild ) noxnd;
-	void ShowTree(int& nodeIndex, std::optional<int>& selectedIndex, Node*& pSelectedNode) const noexcept;
-private:
-	std::string name;
-	std::vector<std::unique_ptr<Node>> childPtrs;
-	std::vector<Mesh*> meshPtrs;
-	DirectX::XMFLOAT4X4 transform;
-	DirectX::XMFLOAT4X4 appliedTransform;
+	Bounds bounds;
 };
 
 class Model
 {
 public:
-	Model( Graphics& gfx,const std::string fileName );
-	void Draw( Graphics& gfx) const noxnd;
+	// vertex attributes get quantized within the given budget, full precision floats without one
+	// optimizeMeshes reorders triangles and vertices for the vertex cache and overdraw at import
+	Model( Graphics& gfx,const std::string fileName,std::optional<Dvtx::QuantizationBudget> quantization = std::nullopt,
+		bool optimizeMeshes = false );
+	void Submit( RenderQueue& queue ) const noxnd;
+	// one more copy of the whole model at placement, copies of a model are drawn instanced
+	void Submit( RenderQueue& queue,DirectX::FXMMATRIX placement ) const noxnd;
 	void ShowWindow(const char* windowName = nullptr) noexcept;
 	~Model() noexcept;
 private:
-	static std::unique_ptr<Mesh> ParseMesh( Graphics& gfx,const aiMesh& mesh );
-	std::unique_ptr<Node> ParseNode( const aiNode& node ) noexcept;
+	static std::vector<MeshCache::MeshData> ParseMeshes( const aiScene& scene,const std::optional<Dvtx::QuantizationBudget>& quantization,
+		std::optional<MeshOptimizer::Report>& optimizerReport );
+	static MeshCache::MeshData ParseMesh( const aiMesh& mesh,const std::optional<Dvtx::QuantizationBudget>& quantization,
+		std::optional<MeshOptimizer::Report>& optimizerReport );
+	static void ParseNode( const aiNode& node,std::vector<MeshCache::NodeRecord>& records );
+	static std::unique_ptr<Mesh> MakeMesh( Graphics& gfx,const MeshCache::MeshView& mesh );
 private:
-	std::unique_ptr<Node> pRoot;
+	std::unique_ptr<SceneGraph> pGraph;
 	std::vector<std::unique_ptr<Mesh>> meshPtrs;
 	std::unique_ptr<class ModelWindow> pWindow;
+	// summed over all meshes, only there when the optimizer ran (not for cache hits)
+	std::optional<MeshOptimizer::Report> optimizerReport;
 }; 
\ No newline at end of file
@@ -0,0 +1,375 @@
+﻿#include "MeshCache.h"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+	struct FileHeader
+	{
+		char magic[4];
+		std::uint32_t version;
+		std::uint64_t sourceHash;
+		std::uint64_t fileSize;
+		std::uint32_t meshCount;
+		std::uint32_t nodeCount;
+	};
+	// followed by elementCount uint32 element types, the vertex bytes and then the indices
+	struct MeshHeader
+	{
+		std::uint32_t elementCount;
+		std::uint32_t vertexBytes;
+		std::uint32_t indexCount;
+		// indices are stored as narrow as they fit, 2 or 4 bytes
+		std::uint32_t indexSize;
+		Bounds bounds;
+	};
+	// followed by the name and then meshCount uint32 mesh indices
+	struct NodeHeader
+	{
+		DirectX::XMFLOAT4X4 transform;
+		std::uint32_t nameLength;
+		std::uint32_t meshCount;
+		std::uint32_t childCount;
+		std::uint32_t reserved;
+	};
+	constexpr char magic[4] = { 'H','3','D','M' };
+	// every block starts 4 byte aligned so the mapped data can be read in place
+	constexpr size_t alignment = 4u;
+
+	constexpr size_t Align(size_t size) noexcept
+	{
+		return (size + alignment - 1u) & ~(alignment - 1u);
+	}
+
+	// bounds checked walk over the mapped file
+	class Reader
+	{
+	public:
+		Reader(const char* pBegin, size_t size) noexcept
+			:
+			pCur(pBegin),
+			pEnd(pBegin + size)
+		{
+		}
+		// nullptr if the file is too short
+		template<typename T>
+		const T* Take(size_t count = 1u) noexcept
+		{
+			const size_t bytes = Align(sizeof(T) * count);
+			if (size_t(pEnd - pCur) < bytes)
+			{
+				return nullptr;
+			}
+			const auto p = reinterpret_cast<const T*>(pCur);
+			pCur += bytes;
+			return p;
+		}
+		bool AtEnd() const noexcept
+		{
+			return pCur == pEnd;
+		}
+	private:
+		const char* pCur;
+		const char* pEnd;
+	};
+
+	class Writer
+	{
+	public:
+		Writer(std::ofstream& file) noexcept
+			:
+			file(file)
+		{
+		}
+		void Put(const void* pData, size_t size)
+		{
+			static constexpr char zeros[alignment] = {};
+			file.write(static_cast<const char*>(pData), size);
+			file.write(zeros, Align(size) - size);
+			written += Align(size);
+		}
+		size_t GetWritten() const noexcept
+		{
+			return written;
+		}
+	private:
+		std::ofstream& file;
+		size_t written = 0u;
+	};
+}
+
+MeshCache::MeshCache(const std::string& sourcePath, std::uint64_t importKey)
+	:
+	cachePath(sourcePath + ".h3dcache"),
+	sourceHash(HashSource(sourcePath, importKey))
+{
+	if (Map() && !Parse())
+	{
+		meshes.clear();
+		nodes.clear();
+		Unmap();
+	}
+}
+
+MeshCache::~MeshCache()
+{
+	Unmap();
+}
+
+bool MeshCache::IsLoaded() const noexcept
+{
+	return pView != nullptr;
+}
+
+const std::vector<MeshCache::MeshView>& MeshCache::GetMeshes() const noexcept
+{
+	return meshes;
+}
+
+const std::vector<MeshCache::NodeRecord>& MeshCache::GetNodes() const noexcept
+{
+	return nodes;
+}
+
+bool MeshCache::Write(const std::vector<MeshData>& meshes, const std::vector<NodeRecord>& nodes) const
+{
+	std::ofstream file(cachePath, std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		return false;
+	}
+	Writer writer(file);
+
+	// file size gets patched in at the end, a partially written file never validates
+	FileHeader header = {};
+	std::copy(std::begin(magic), std::end(magic), header.magic);
+	header.version = version;
+	header.sourceHash = sourceHash;
+	header.meshCount = (std::uint32_t)meshes.size();
+	header.nodeCount = (std::uint32_t)nodes.size();
+	writer.Put(&header, sizeof(header));
+
+	for (const auto& m : meshes)
+	{
+		const auto& layout = m.vertices.GetLayout();
+		MeshHeader mh = {};
+		mh.elementCount = (std::uint32_t)layout.GetElementCount();
+		mh.vertexBytes = (std::uint32_t)m.vertices.SizeBytes();
+		mh.indexCount = (std::uint32_t)m.indices.size();
+		const auto fitsShort = std::all_of(m.indices.begin(), m.indices.end(), [](unsigned int i)
+		{
+			return i <= 0xFFFFu;
+		});
+		mh.indexSize = fitsShort ? sizeof(unsigned short) : sizeof(unsigned int);
+		mh.bounds = m.bounds;
+		writer.Put(&mh, sizeof(mh));
+
+		std::vector<std::uint32_t> types;
+		types.reserve(mh.elementCount);
+		for (size_t i = 0; i < layout.GetElementCount(); i++)
+		{
+			types.push_back((std::uint32_t)layout.ResolveByIndex(i).GetType());
+		}
+		writer.Put(types.data(), types.size() * sizeof(std::uint32_t));
+		writer.Put(m.vertices.GetData(), m.vertices.SizeBytes());
+		if (fitsShort)
+		{
+			const std::vector<unsigned short> narrowed(m.indices.begin(), m.indices.end());
+			writer.Put(narrowed.data(), narrowed.size() * sizeof(unsigned short));
+		}
+		else
+		{
+			writer.Put(m.indices.data(), m.indices.size() * sizeof(unsigned int));
+		}
+	}
+
+	for (const auto& n : nodes)
+	{
+		NodeHeader nh = {};
+		nh.transform = n.transform;
+		nh.nameLength = (std::uint32_t)n.name.size();
+		nh.meshCount = (std::uint32_t)n.meshIndices.size();
+		nh.childCount = n.childCount;
+		writer.Put(&nh, sizeof(nh));
+		writer.Put(n.name.data(), n.name.size());
+		writer.Put(n.meshIndices.data(), n.meshIndices.size() * sizeof(unsigned int));
+	}
+
+	header.fileSize = writer.GetWritten();
+	file.seekp(0);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	return bool(file);
+}
+
+MeshCache::MeshView MeshCache::MakeView(const MeshData& mesh)
+{
+	return {
+		mesh.vertices.GetLayout(),
+		mesh.vertices.GetData(),
+		mesh.vertices.SizeBytes(),
+		mesh.indices.data(),
+		mesh.indices.size(),
+		sizeof(unsigned int),
+		mesh.bounds
+	};
+}
+
+bool MeshCache::Map() noexcept
+{
+	hFile = CreateFileA(cachePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+	                    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (hFile == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(hFile, &size) || size.QuadPart < (LONGLONG)sizeof(FileHeader))
+	{
+		Unmap();
+		return false;
+	}
+	hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0u, 0u, nullptr);
+	if (hMapping == nullptr)
+	{
+		Unmap();
+		return false;
+	}
+	pView = static_cast<const char*>(MapViewOfFile(hMapping, FILE_MAP_READ, 0u, 0u, 0u));
+	if (pView == nullptr)
+	{
+		Unmap();
+		return false;
+	}
+	viewSize = (size_t)size.QuadPart;
+	return true;
+}
+
+void MeshCache::Unmap() noexcept
+{
+	if (pView != nullptr)
+	{
+		UnmapViewOfFile(pView);
+		pView = nullptr;
+		viewSize = 0u;
+	}
+	if (hMapping != nullptr)
+	{
+		CloseHandle(hMapping);
+		hMapping = nullptr;
+	}
+	if (hFile != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(hFile);
+		hFile = INVALID_HANDLE_VALUE;
+	}
+}
+
+bool MeshCache::Parse()
+{
+	Reader reader(pView, viewSize);
+	const auto pHeader = reader.Take<FileHeader>();
+	if (pHeader == nullptr ||
+		!std::equal(std::begin(magic), std::end(magic), pHeader->magic) ||
+		pHeader->version != version ||
+		pHeader->sourceHash != sourceHash ||
+		pHeader->fileSize != viewSize)
+	{
+		return false;
+	}
+
+	meshes.reserve(pHeader->meshCount);
+	for (std::uint32_t i = 0; i < pHeader->meshCount; i++)
+	{
+		const auto pMesh = reader.Take<MeshHeader>();
+		if (pMesh == nullptr)
+		{
+			return false;
+		}
+		const auto pTypes = reader.Take<std::uint32_t>(pMesh->elementCount);
+		const auto pVertices = reader.Take<char>(pMesh->vertexBytes);
+		if (pMesh->indexSize != sizeof(unsigned short) && pMesh->indexSize != sizeof(unsigned int))
+		{
+			return false;
+		}
+		const auto pIndices = reader.Take<char>(size_t(pMesh->indexCount) * pMesh->indexSize);
+		if (pTypes == nullptr || pVertices == nullptr || pIndices == nullptr)
+		{
+			return false;
+		}
+		Dvtx::VertexLayout layout;
+		for (std::uint32_t e = 0; e < pMesh->elementCount; e++)
+		{
+			if (pTypes[e] >= Dvtx::VertexLayout::Count)
+			{
+				return false;
+			}
+			layout.Append((Dvtx::VertexLayout::ElementType)pTypes[e]);
+		}
+		if (layout.Size() == 0u || pMesh->vertexBytes % layout.Size() != 0u)
+		{
+			return false;
+		}
+		meshes.push_back({ std::move(layout), pVertices, pMesh->vertexBytes, pIndices, pMesh->indexCount, pMesh->indexSize, pMesh->bounds });
+	}
+
+	// nodes still expected to show up, the hierarchy has to close exactly on the last record
+	size_t pending = 1u;
+	nodes.reserve(pHeader->nodeCount);
+	for (std::uint32_t i = 0; i < pHeader->nodeCount; i++)
+	{
+		const auto pNode = reader.Take<NodeHeader>();
+		if (pNode == nullptr || pending == 0u)
+		{
+			return false;
+		}
+		const auto pName = reader.Take<char>(pNode->nameLength);
+		const auto pMeshIndices = reader.Take<std::uint32_t>(pNode->meshCount);
+		if (pName == nullptr || pMeshIndices == nullptr)
+		{
+			return false;
+		}
+		NodeRecord node;
+		node.name.assign(pName, pNode->nameLength);
+		node.transform = pNode->transform;
+		node.meshIndices.assign(pMeshIndices, pMeshIndices + pNode->meshCount);
+		node.childCount = pNode->childCount;
+		for (const auto m : node.meshIndices)
+		{
+			if (m >= meshes.size())
+			{
+				return false;
+			}
+		}
+		pending = pending - 1u + node.childCount;
+		nodes.push_back(std::move(node));
+	}
+	return pending == 0u && reader.AtEnd();
+}
+
+std::uint64_t MeshCache::HashSource(const std::string& sourcePath, std::uint64_t importKey)
+{
+	// fnv-1a over the source bytes, then the import key and format version
+	constexpr std::uint64_t prime = 1099511628211ull;
+	std::uint64_t hash = 14695981039346656037ull;
+	const auto mix = [&hash](unsigned char byte)
+	{
+		hash = (hash ^ byte) * prime;
+	};
+
+	std::ifstream file(sourcePath, std::ios::binary);
+	const std::vector<char> bytes{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+	for (const auto b : bytes)
+	{
+		mix((unsigned char)b);
+	}
+	for (size_t i = 0; i < sizeof(importKey); i++)
+	{
+		mix((unsigned char)(importKey >> (i * 8u)));
+	}
+	for (size_t i = 0; i < sizeof(version); i++)
+	{
+		mix((unsigned char)(version >> (i * 8u)));
+	}
+	return hash;
+}
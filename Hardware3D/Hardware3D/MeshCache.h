@@ -0,0 +1,72 @@
+﻿#pragma once
+#include "Vertex.h"
+#include "Bounds.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// versioned binary snapshot of an imported model that lets startup skip the importer
+// holds interleaved vertex bytes, indices and vertex layouts per mesh, plus the node hierarchy in depth first order
+// the file is memory mapped on load so gpu buffers are created straight out of the mapping
+class MeshCache
+{
+public:
+	// cpu side of a mesh as it comes out of the importer
+	struct MeshData
+	{
+		Dvtx::VertexBuffer vertices;
+		std::vector<unsigned int> indices;
+		// of the full precision positions
+		Bounds bounds;
+	};
+	// points either into MeshData or into the mapped cache file
+	struct MeshView
+	{
+		Dvtx::VertexLayout layout;
+		const char* pVertices;
+		size_t vertexBytes;
+		// 16 or 32 bit depending on indexSize
+		const void* pIndices;
+		size_t indexCount;
+		size_t indexSize;
+		Bounds bounds;
+	};
+	// children directly follow their parent (depth first)
+	struct NodeRecord
+	{
+		std::string name;
+		DirectX::XMFLOAT4X4 transform;
+		std::vector<unsigned int> meshIndices;
+		unsigned int childCount;
+	};
+public:
+	// hashes the source and maps the matching cache file if there is one
+	// importKey has to change with anything that changes the imported data (post process flags, quantization...)
+	MeshCache(const std::string& sourcePath, std::uint64_t importKey);
+	MeshCache(const MeshCache&) = delete;
+	MeshCache& operator=(const MeshCache&) = delete;
+	~MeshCache();
+	bool IsLoaded() const noexcept;
+	// only valid while the cache object is alive
+	const std::vector<MeshView>& GetMeshes() const noexcept;
+	const std::vector<NodeRecord>& GetNodes() const noexcept;
+	// failing to write isn't an error, the next launch just imports again
+	bool Write(const std::vector<MeshData>& meshes, const std::vector<NodeRecord>& nodes) const;
+	static MeshView MakeView(const MeshData& mesh);
+private:
+	bool Map() noexcept;
+	void Unmap() noexcept;
+	bool Parse();
+	static std::uint64_t HashSource(const std::string& sourcePath, std::uint64_t importKey);
+private:
+	// bump whenever the file layout or the imported vertex data changes
+	static constexpr std::uint32_t version = 4u;
+	std::string cachePath;
+	std::uint64_t sourceHash;
+	HANDLE hFile = INVALID_HANDLE_VALUE;
+	HANDLE hMapping = nullptr;
+	const char* pView = nullptr;
+	size_t viewSize = 0u;
+	std::vector<MeshView> meshes;
+	std::vector<NodeRecord> nodes;
+};
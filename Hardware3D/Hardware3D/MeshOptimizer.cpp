@@ -0,0 +1,348 @@
+﻿#include "MeshOptimizer.h"
+#include "Vertex.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+namespace
+{
+	// clusters are cut further wherever their running cache miss ratio drops below this,
+	// more and smaller clusters give the overdraw sort more to work with
+	constexpr float clusterSplitAcmr = 0.75f;
+
+	struct Float3
+	{
+		float x, y, z;
+	};
+
+	Float3 ReadPosition(const char* pPositions, size_t stride, unsigned int vertex) noexcept
+	{
+		Float3 p;
+		std::memcpy(&p, pPositions + stride * vertex, sizeof(p));
+		return p;
+	}
+}
+
+float MeshOptimizer::CacheStats::GetACMR() const noexcept
+{
+	return triangles == 0u ? 0.0f : float(transformed) / float(triangles);
+}
+
+float MeshOptimizer::CacheStats::GetATVR() const noexcept
+{
+	return vertices == 0u ? 0.0f : float(transformed) / float(vertices);
+}
+
+MeshOptimizer::CacheStats& MeshOptimizer::CacheStats::operator+=(const CacheStats& rhs) noexcept
+{
+	transformed += rhs.transformed;
+	triangles += rhs.triangles;
+	vertices += rhs.vertices;
+	return *this;
+}
+
+MeshOptimizer::Report MeshOptimizer::Optimize(Dvtx::VertexBuffer& vertices, std::vector<unsigned int>& indices,
+                                              unsigned int cacheSize)
+{
+	const size_t vertexCount = vertices.Size();
+	Report report;
+	report.before = SimulateFifoCache(indices, vertexCount, cacheSize);
+
+	std::vector<unsigned int> clusterStarts;
+	indices = Tipsify(indices, vertexCount, cacheSize, clusterStarts);
+	SplitClusters(indices, vertexCount, cacheSize, clusterStarts);
+
+	const auto& layout = vertices.GetLayout();
+	for (size_t i = 0; i < layout.GetElementCount(); i++)
+	{
+		const auto& e = layout.ResolveByIndex(i);
+		if (e.GetType() == Dvtx::VertexLayout::Position3D)
+		{
+			SortClustersForOverdraw(indices, clusterStarts, vertices.GetData() + e.GetOffset(), layout.Size(), vertexCount);
+			break;
+		}
+	}
+
+	vertices.Remap(OptimizeVertexFetch(indices, vertexCount));
+	report.after = SimulateFifoCache(indices, vertices.Size(), cacheSize);
+	return report;
+}
+
+MeshOptimizer::CacheStats MeshOptimizer::SimulateFifoCache(const std::vector<unsigned int>& indices, size_t vertexCount,
+                                                           unsigned int cacheSize)
+{
+	CacheStats stats;
+	stats.triangles = indices.size() / 3u;
+	// miss count at the time each vertex entered the cache (+1, 0 means never cached)
+	// a fifo of size n still holds a vertex as long as fewer than n misses came after it
+	std::vector<size_t> insertedAt(vertexCount, 0u);
+	for (const auto i : indices)
+	{
+		if (insertedAt[i] == 0u)
+		{
+			stats.vertices++;
+		}
+		if (insertedAt[i] == 0u || stats.transformed - (insertedAt[i] - 1u) > cacheSize)
+		{
+			insertedAt[i] = ++stats.transformed;
+		}
+	}
+	return stats;
+}
+
+std::vector<unsigned int> MeshOptimizer::Tipsify(const std::vector<unsigned int>& indices, size_t vertexCount,
+                                                 unsigned int cacheSize, std::vector<unsigned int>& clusterStarts)
+{
+	const size_t triangleCount = indices.size() / 3u;
+
+	// vertex -> triangle adjacency in compressed rows, liveCount is the number of triangles not emitted yet
+	std::vector<unsigned int> liveCount(vertexCount, 0u);
+	for (const auto i : indices)
+	{
+		liveCount[i]++;
+	}
+	std::vector<unsigned int> adjacencyStart(vertexCount + 1u, 0u);
+	std::partial_sum(liveCount.begin(), liveCount.end(), adjacencyStart.begin() + 1);
+	std::vector<unsigned int> adjacency(indices.size());
+	{
+		auto fill = adjacencyStart;
+		for (unsigned int t = 0; t < triangleCount; t++)
+		{
+			for (unsigned int k = 0; k < 3u; k++)
+			{
+				adjacency[fill[indices[t * 3u + k]]++] = t;
+			}
+		}
+	}
+
+	// timestamps of when each vertex last entered the simulated cache
+	std::vector<unsigned int> cacheTime(vertexCount, 0u);
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<unsigned int> deadEnds;
+	std::vector<unsigned int> candidates;
+	std::vector<unsigned int> output;
+	output.reserve(indices.size());
+	clusterStarts.clear();
+
+	unsigned int time = cacheSize + 1u;
+	// next vertex in input order to resume from once the dead end stack is empty
+	unsigned int cursor = 0u;
+	int fanning = vertexCount > 0u ? 0 : -1;
+	bool jumped = true;
+	while (fanning >= 0)
+	{
+		// emit every remaining triangle around the fanning vertex
+		candidates.clear();
+		for (auto a = adjacencyStart[fanning]; a < adjacencyStart[fanning + 1]; a++)
+		{
+			const auto t = adjacency[a];
+			if (emitted[t])
+			{
+				continue;
+			}
+			if (jumped)
+			{
+				clusterStarts.push_back((unsigned int)(output.size() / 3u));
+				jumped = false;
+			}
+			for (unsigned int k = 0; k < 3u; k++)
+			{
+				const auto v = indices[t * 3u + k];
+				output.push_back(v);
+				deadEnds.push_back(v);
+				candidates.push_back(v);
+				liveCount[v]--;
+				if (time - cacheTime[v] > cacheSize)
+				{
+					cacheTime[v] = time++;
+				}
+			}
+			emitted[t] = true;
+		}
+
+		// prefer the neighbour that is oldest in the cache but will still be in it after fanning all its triangles
+		int next = -1;
+		int bestPriority = -1;
+		for (const auto v : candidates)
+		{
+			if (liveCount[v] == 0u)
+			{
+				continue;
+			}
+			int priority = 0;
+			if (time - cacheTime[v] + 2u * liveCount[v] <= cacheSize)
+			{
+				priority = int(time - cacheTime[v]);
+			}
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				next = int(v);
+			}
+		}
+		if (next < 0)
+		{
+			// dead end, take the most recently referenced vertex that still has triangles
+			jumped = true;
+			while (!deadEnds.empty() && next < 0)
+			{
+				const auto v = deadEnds.back();
+				deadEnds.pop_back();
+				if (liveCount[v] > 0u)
+				{
+					next = int(v);
+				}
+			}
+			for (; next < 0 && cursor < vertexCount; cursor++)
+			{
+				if (liveCount[cursor] > 0u)
+				{
+					next = int(cursor);
+				}
+			}
+		}
+		fanning = next;
+	}
+	return output;
+}
+
+void MeshOptimizer::SplitClusters(const std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize,
+                                  std::vector<unsigned int>& clusterStarts)
+{
+	const auto triangleCount = (unsigned int)(indices.size() / 3u);
+	std::vector<unsigned int> split;
+	split.reserve(clusterStarts.size());
+	std::vector<size_t> insertedAt(vertexCount, 0u);
+	size_t misses = 0u;
+	for (size_t c = 0; c < clusterStarts.size(); c++)
+	{
+		const auto end = c + 1u < clusterStarts.size() ? clusterStarts[c + 1u] : triangleCount;
+		split.push_back(clusterStarts[c]);
+		// every cluster can end up anywhere after sorting, so each one is costed starting from a cold cache
+		size_t clusterBase = misses;
+		unsigned int clusterTriangles = 0u;
+		for (auto t = clusterStarts[c]; t < end; t++)
+		{
+			for (unsigned int k = 0; k < 3u; k++)
+			{
+				const auto v = indices[t * 3u + k];
+				if (insertedAt[v] <= clusterBase || misses - (insertedAt[v] - 1u) > cacheSize)
+				{
+					insertedAt[v] = ++misses;
+				}
+			}
+			clusterTriangles++;
+			if (t + 1u < end && float(misses - clusterBase) < clusterSplitAcmr * float(clusterTriangles))
+			{
+				split.push_back(t + 1u);
+				clusterBase = misses;
+				clusterTriangles = 0u;
+			}
+		}
+	}
+	clusterStarts = std::move(split);
+}
+
+void MeshOptimizer::SortClustersForOverdraw(std::vector<unsigned int>& indices, const std::vector<unsigned int>& clusterStarts,
+                                            const char* pPositions, size_t stride, size_t vertexCount)
+{
+	const auto triangleCount = (unsigned int)(indices.size() / 3u);
+	if (clusterStarts.size() < 2u || vertexCount == 0u)
+	{
+		return;
+	}
+
+	struct Cluster
+	{
+		unsigned int start;
+		unsigned int end;
+		Float3 centroid;
+		Float3 normal;
+		float area;
+		float sortKey;
+	};
+	std::vector<Cluster> clusters;
+	clusters.reserve(clusterStarts.size());
+	// area weighted centroid of the whole mesh
+	Float3 meshCentroid = { 0.0f, 0.0f, 0.0f };
+	float meshArea = 0.0f;
+	for (size_t c = 0; c < clusterStarts.size(); c++)
+	{
+		Cluster cluster = {};
+		cluster.start = clusterStarts[c];
+		cluster.end = c + 1u < clusterStarts.size() ? clusterStarts[c + 1u] : triangleCount;
+		for (auto t = cluster.start; t < cluster.end; t++)
+		{
+			const auto p0 = ReadPosition(pPositions, stride, indices[t * 3u]);
+			const auto p1 = ReadPosition(pPositions, stride, indices[t * 3u + 1u]);
+			const auto p2 = ReadPosition(pPositions, stride, indices[t * 3u + 2u]);
+			const Float3 e0 = { p1.x - p0.x, p1.y - p0.y, p1.z - p0.z };
+			const Float3 e1 = { p2.x - p0.x, p2.y - p0.y, p2.z - p0.z };
+			// cross product length is twice the area, its direction the face normal
+			const Float3 n = {
+				e0.y * e1.z - e0.z * e1.y,
+				e0.z * e1.x - e0.x * e1.z,
+				e0.x * e1.y - e0.y * e1.x
+			};
+			const float area = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+			cluster.normal = { cluster.normal.x + n.x, cluster.normal.y + n.y, cluster.normal.z + n.z };
+			cluster.centroid.x += area * (p0.x + p1.x + p2.x) / 3.0f;
+			cluster.centroid.y += area * (p0.y + p1.y + p2.y) / 3.0f;
+			cluster.centroid.z += area * (p0.z + p1.z + p2.z) / 3.0f;
+			cluster.area += area;
+		}
+		meshCentroid = { meshCentroid.x + cluster.centroid.x, meshCentroid.y + cluster.centroid.y, meshCentroid.z + cluster.centroid.z };
+		meshArea += cluster.area;
+		clusters.push_back(cluster);
+	}
+	if (meshArea > 0.0f)
+	{
+		meshCentroid = { meshCentroid.x / meshArea, meshCentroid.y / meshArea, meshCentroid.z / meshArea };
+	}
+
+	// clusters that sit far out along their own normal are likely to occlude the rest, draw them first
+	for (auto& c : clusters)
+	{
+		if (c.area > 0.0f)
+		{
+			c.centroid = { c.centroid.x / c.area, c.centroid.y / c.area, c.centroid.z / c.area };
+		}
+		const float normalLength = std::sqrt(c.normal.x * c.normal.x + c.normal.y * c.normal.y + c.normal.z * c.normal.z);
+		c.sortKey = normalLength > 0.0f ?
+			((c.centroid.x - meshCentroid.x) * c.normal.x +
+			 (c.centroid.y - meshCentroid.y) * c.normal.y +
+			 (c.centroid.z - meshCentroid.z) * c.normal.z) / normalLength :
+			0.0f;
+	}
+	std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b)
+	{
+		return a.sortKey > b.sortKey;
+	});
+
+	std::vector<unsigned int> sorted;
+	sorted.reserve(indices.size());
+	for (const auto& c : clusters)
+	{
+		sorted.insert(sorted.end(), indices.begin() + c.start * 3u, indices.begin() + c.end * 3u);
+	}
+	indices = std::move(sorted);
+}
+
+std::vector<unsigned int> MeshOptimizer::OptimizeVertexFetch(std::vector<unsigned int>& indices, size_t vertexCount)
+{
+	constexpr auto unused = ~0u;
+	std::vector<unsigned int> remap(vertexCount, unused);
+	std::vector<unsigned int> order;
+	order.reserve(vertexCount);
+	for (auto& i : indices)
+	{
+		if (remap[i] == unused)
+		{
+			remap[i] = (unsigned int)(order.size());
+			order.push_back(i);
+		}
+		i = remap[i];
+	}
+	return order;
+}
@@ -0,0 +1,52 @@
+﻿#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace Dvtx
+{
+	class VertexBuffer;
+}
+
+// import time reordering of indexed triangle lists for the gpu
+// triangles are ordered for the post transform vertex cache (tipsify), the resulting clusters are sorted
+// outside-in to cut overdraw and finally vertices are laid out in first use order for fetch locality
+class MeshOptimizer
+{
+public:
+	// result of running an index list through a simulated fifo post transform cache
+	// kept as counts so stats of several meshes can be summed
+	struct CacheStats
+	{
+		size_t transformed = 0u;
+		size_t triangles = 0u;
+		size_t vertices = 0u;
+		// average cache miss ratio, vertex shader runs per triangle (0.5 is the ideal for regular meshes)
+		float GetACMR() const noexcept;
+		// average transform to vertex ratio, vertex shader runs per referenced vertex (1.0 is the ideal)
+		float GetATVR() const noexcept;
+		CacheStats& operator+=(const CacheStats& rhs) noexcept;
+	};
+	struct Report
+	{
+		CacheStats before;
+		CacheStats after;
+	};
+public:
+	// reorders indices and vertices in place, stats are simulated with a fifo of cacheSize entries
+	static Report Optimize(Dvtx::VertexBuffer& vertices, std::vector<unsigned int>& indices, unsigned int cacheSize = 16u);
+	static CacheStats SimulateFifoCache(const std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize);
+	// tipsify (Sander, Nehab, Barczak 2007), also returns the index of the first triangle of every cluster
+	// a new cluster starts wherever the traversal had to jump and the cache contents are lost
+	static std::vector<unsigned int> Tipsify(const std::vector<unsigned int>& indices, size_t vertexCount,
+		unsigned int cacheSize, std::vector<unsigned int>& clusterStarts);
+	// sorts clusters so the ones facing away from the mesh center, likely occluders, are drawn first
+	// positions points to the first x, consecutive positions are stride bytes apart
+	static void SortClustersForOverdraw(std::vector<unsigned int>& indices, const std::vector<unsigned int>& clusterStarts,
+		const char* pPositions, size_t stride, size_t vertexCount);
+	// renumbers vertices in order of first use, returns the old index of each new vertex (unused vertices are dropped)
+	static std::vector<unsigned int> OptimizeVertexFetch(std::vector<unsigned int>& indices, size_t vertexCount);
+private:
+	// cuts clusters where their local cache miss ratio is already low, gives the overdraw sort finer pieces
+	static void SplitClusters(const std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize,
+		std::vector<unsigned int>& clusterStarts);
+};
@@ -0,0 +1,254 @@
+﻿#include "NullGraphicsContext.h"
+
+// CommandLog
+void CommandLog::Record(Op op, const void* pObject, UINT slot, UINT count)
+{
+	commands.push_back({ op, pObject, slot, count });
+	opCounts[(size_t)op]++;
+	if (op == Op::DrawIndexed || op == Op::DrawIndexedInstanced)
+	{
+		indexCount += count;
+	}
+}
+
+void CommandLog::Clear() noexcept
+{
+	commands.clear();
+	opCounts.fill(0u);
+	indexCount = 0u;
+}
+
+void CommandLog::Append(const CommandLog& other)
+{
+	commands.insert(commands.end(), other.commands.begin(), other.commands.end());
+	for (size_t i = 0; i < opCounts.size(); i++)
+	{
+		opCounts[i] += other.opCounts[i];
+	}
+	indexCount += other.indexCount;
+}
+
+const std::vector<CommandLog::Command>& CommandLog::GetCommands() const noexcept
+{
+	return commands;
+}
+
+size_t CommandLog::GetCount(Op op) const noexcept
+{
+	return opCounts[(size_t)op];
+}
+
+size_t CommandLog::GetBindCount() const noexcept
+{
+	size_t total = 0u;
+	for (size_t i = (size_t)Op::SetVertexBuffers; i <= (size_t)Op::SetPSSamplers; i++)
+	{
+		total += opCounts[i];
+	}
+	return total;
+}
+
+size_t CommandLog::GetIndexCount() const noexcept
+{
+	return indexCount;
+}
+
+const char* CommandLog::GetOpName(Op op) noexcept
+{
+	switch (op)
+	{
+	case Op::SetVertexBuffers:
+		return "IASetVertexBuffers";
+	case Op::SetIndexBuffer:
+		return "IASetIndexBuffer";
+	case Op::SetInputLayout:
+		return "IASetInputLayout";
+	case Op::SetTopology:
+		return "IASetPrimitiveTopology";
+	case Op::SetVertexShader:
+		return "VSSetShader";
+	case Op::SetPixelShader:
+		return "PSSetShader";
+	case Op::SetVSConstantBuffers:
+		return "VSSetConstantBuffers";
+	case Op::SetPSConstantBuffers:
+		return "PSSetConstantBuffers";
+	case Op::SetPSShaderResources:
+		return "PSSetShaderResources";
+	case Op::SetPSSamplers:
+		return "PSSetSamplers";
+	case Op::SetViewports:
+		return "RSSetViewports";
+	case Op::SetRenderTargets:
+		return "OMSetRenderTargets";
+	case Op::SetDepthStencilState:
+		return "OMSetDepthStencilState";
+	case Op::ClearRenderTarget:
+		return "ClearRenderTargetView";
+	case Op::ClearDepthStencil:
+		return "ClearDepthStencilView";
+	case Op::Map:
+		return "Map";
+	case Op::Unmap:
+		return "Unmap";
+	case Op::CopySubresourceRegion:
+		return "CopySubresourceRegion";
+	case Op::DrawIndexed:
+		return "DrawIndexed";
+	case Op::DrawIndexedInstanced:
+		return "DrawIndexedInstanced";
+	default:
+		return "Unknown";
+	}
+}
+
+
+// NullGraphicsContext
+CommandLog& NullGraphicsContext::GetLog() noexcept
+{
+	return log;
+}
+
+const CommandLog& NullGraphicsContext::GetLog() const noexcept
+{
+	return log;
+}
+
+void NullGraphicsContext::IASetVertexBuffers(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers,
+                                             const UINT* pStrides, const UINT* pOffsets) noexcept
+{
+	RecordEach(CommandLog::Op::SetVertexBuffers, startSlot, numBuffers, ppBuffers);
+}
+
+void NullGraphicsContext::IASetIndexBuffer(ID3D11Buffer* pBuffer, DXGI_FORMAT format, UINT offset) noexcept
+{
+	log.Record(CommandLog::Op::SetIndexBuffer, pBuffer);
+}
+
+void NullGraphicsContext::IASetInputLayout(ID3D11InputLayout* pInputLayout) noexcept
+{
+	log.Record(CommandLog::Op::SetInputLayout, pInputLayout);
+}
+
+void NullGraphicsContext::IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology) noexcept
+{
+	log.Record(CommandLog::Op::SetTopology, nullptr, 0u, (UINT)topology);
+}
+
+void NullGraphicsContext::VSSetShader(ID3D11VertexShader* pShader, ID3D11ClassInstance* const* ppClassInstances,
+                                      UINT numClassInstances) noexcept
+{
+	log.Record(CommandLog::Op::SetVertexShader, pShader);
+}
+
+void NullGraphicsContext::PSSetShader(ID3D11PixelShader* pShader, ID3D11ClassInstance* const* ppClassInstances,
+                                      UINT numClassInstances) noexcept
+{
+	log.Record(CommandLog::Op::SetPixelShader, pShader);
+}
+
+void NullGraphicsContext::VSSetConstantBuffers(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers) noexcept
+{
+	RecordEach(CommandLog::Op::SetVSConstantBuffers, startSlot, numBuffers, ppBuffers);
+}
+
+void NullGraphicsContext::PSSetConstantBuffers(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers) noexcept
+{
+	RecordEach(CommandLog::Op::SetPSConstantBuffers, startSlot, numBuffers, ppBuffers);
+}
+
+void NullGraphicsContext::VSSetConstantBuffers1(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers,
+                                                const UINT* pFirstConstant, const UINT* pNumConstants) noexcept
+{
+	RecordEach(CommandLog::Op::SetVSConstantBuffers, startSlot, numBuffers, ppBuffers);
+}
+
+void NullGraphicsContext::PSSetConstantBuffers1(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers,
+                                                const UINT* pFirstConstant, const UINT* pNumConstants) noexcept
+{
+	RecordEach(CommandLog::Op::SetPSConstantBuffers, startSlot, numBuffers, ppBuffers);
+}
+
+void NullGraphicsContext::PSSetShaderResources(UINT startSlot, UINT numViews,
+                                               ID3D11ShaderResourceView* const* ppViews) noexcept
+{
+	RecordEach(CommandLog::Op::SetPSShaderResources, startSlot, numViews, ppViews);
+}
+
+void NullGraphicsContext::PSSetSamplers(UINT startSlot, UINT numSamplers, ID3D11SamplerState* const* ppSamplers) noexcept
+{
+	RecordEach(CommandLog::Op::SetPSSamplers, startSlot, numSamplers, ppSamplers);
+}
+
+void NullGraphicsContext::RSSetViewports(UINT numViewports, const D3D11_VIEWPORT* pViewports) noexcept
+{
+	log.Record(CommandLog::Op::SetViewports, nullptr, 0u, numViewports);
+}
+
+void NullGraphicsContext::OMSetRenderTargets(UINT numViews, ID3D11RenderTargetView* const* ppViews,
+                                             ID3D11DepthStencilView* pDepthStencilView) noexcept
+{
+	RecordEach(CommandLog::Op::SetRenderTargets, 0u, numViews, ppViews);
+	log.Record(CommandLog::Op::SetRenderTargets, pDepthStencilView, D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, 1u);
+}
+
+void NullGraphicsContext::OMSetDepthStencilState(ID3D11DepthStencilState* pState, UINT stencilRef) noexcept
+{
+	log.Record(CommandLog::Op::SetDepthStencilState, pState);
+}
+
+void NullGraphicsContext::ClearRenderTargetView(ID3D11RenderTargetView* pView, const FLOAT color[4]) noexcept
+{
+	log.Record(CommandLog::Op::ClearRenderTarget, pView);
+}
+
+void NullGraphicsContext::ClearDepthStencilView(ID3D11DepthStencilView* pView, UINT clearFlags, FLOAT depth,
+                                                UINT8 stencil) noexcept
+{
+	log.Record(CommandLog::Op::ClearDepthStencil, pView);
+}
+
+HRESULT NullGraphicsContext::Map(ID3D11Resource* pResource, UINT subresource, D3D11_MAP mapType, UINT mapFlags,
+                                 D3D11_MAPPED_SUBRESOURCE* pMappedResource) noexcept
+{
+	// the engine only ever maps buffers (constant buffers), textures are immutable
+	D3D11_RESOURCE_DIMENSION dimension;
+	pResource->GetType(&dimension);
+	if (dimension != D3D11_RESOURCE_DIMENSION_BUFFER)
+	{
+		return E_NOTIMPL;
+	}
+
+	D3D11_BUFFER_DESC bufDesc;
+	static_cast<ID3D11Buffer*>(pResource)->GetDesc(&bufDesc);
+	auto& scratch = mapScratch[pResource];
+	scratch.resize(bufDesc.ByteWidth);
+
+	pMappedResource->pData = scratch.data();
+	pMappedResource->RowPitch = bufDesc.ByteWidth;
+	pMappedResource->DepthPitch = bufDesc.ByteWidth;
+	log.Record(CommandLog::Op::Map, pResource, subresource, bufDesc.ByteWidth);
+	return S_OK;
+}
+
+void NullGraphicsContext::Unmap(ID3D11Resource* pResource, UINT subresource) noexcept
+{
+	log.Record(CommandLog::Op::Unmap, pResource, subresource);
+}
+
+void NullGraphicsContext::CopySubresourceRegion(ID3D11Resource* pDstResource, UINT dstSubresource, UINT dstX, UINT dstY, UINT dstZ,
+                                                ID3D11Resource* pSrcResource, UINT srcSubresource, const D3D11_BOX* pSrcBox) noexcept
+{
+	log.Record(CommandLog::Op::CopySubresourceRegion, pDstResource, dstSubresource);
+}
+
+void NullGraphicsContext::DrawIndexed(UINT indexCount, UINT startIndexLocation, INT baseVertexLocation) noexcept
+{
+	log.Record(CommandLog::Op::DrawIndexed, nullptr, startIndexLocation, indexCount);
+}
+
+void NullGraphicsContext::DrawIndexedInstanced(UINT indexCountPerInstance, UINT instanceCount, UINT startIndexLocation,
+                                               INT baseVertexLocation, UINT startInstanceLocation) noexcept
+{
+	log.Record(CommandLog::Op::DrawIndexedInstanced, nullptr, startIndexLocation, indexCountPerInstance * instanceCount);
+}
@@ -0,0 +1,116 @@
+﻿#pragma once
+#include "GraphicsContext.h"
+#include <array>
+#include <unordered_map>
+#include <vector>
+
+// record of every call made against a NullGraphicsContext during a frame
+class CommandLog
+{
+public:
+	enum class Op
+	{
+		SetVertexBuffers,
+		SetIndexBuffer,
+		SetInputLayout,
+		SetTopology,
+		SetVertexShader,
+		SetPixelShader,
+		SetVSConstantBuffers,
+		SetPSConstantBuffers,
+		SetPSShaderResources,
+		SetPSSamplers,
+		SetViewports,
+		SetRenderTargets,
+		SetDepthStencilState,
+		ClearRenderTarget,
+		ClearDepthStencil,
+		Map,
+		Unmap,
+		CopySubresourceRegion,
+		DrawIndexed,
+		DrawIndexedInstanced,
+		Count,
+	};
+	struct Command
+	{
+		Op op;
+		// object bound/mapped, nullptr for state-less calls
+		// array binds are logged one command per slot, so every object bound shows up
+		const void* pObject;
+		// slot, subresource or start index depending on op (render targets put the depth view in the slot
+		// after the last color target)
+		UINT slot;
+		// 1 per bound object, viewports set, bytes mapped or indices drawn (over all instances) depending on op
+		UINT count;
+	};
+public:
+	void Record(Op op, const void* pObject = nullptr, UINT slot = 0u, UINT count = 0u);
+	void Clear() noexcept;
+	// plays another log back at the end of this one
+	void Append(const CommandLog& other);
+	const std::vector<Command>& GetCommands() const noexcept;
+	size_t GetCount(Op op) const noexcept;
+	size_t GetBindCount() const noexcept;
+	size_t GetIndexCount() const noexcept;
+	static const char* GetOpName(Op op) noexcept;
+private:
+	std::vector<Command> commands;
+	std::array<size_t, (size_t)Op::Count> opCounts = {};
+	size_t indexCount = 0u;
+};
+
+// context that never touches a gpu, calls are only appended to a CommandLog
+class NullGraphicsContext : public GraphicsContext
+{
+public:
+	CommandLog& GetLog() noexcept;
+	const CommandLog& GetLog() const noexcept;
+
+	void IASetVertexBuffers(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers,
+		const UINT* pStrides, const UINT* pOffsets) noexcept override;
+	void IASetIndexBuffer(ID3D11Buffer* pBuffer, DXGI_FORMAT format, UINT offset) noexcept override;
+	void IASetInputLayout(ID3D11InputLayout* pInputLayout) noexcept override;
+	void IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology) noexcept override;
+	void VSSetShader(ID3D11VertexShader* pShader, ID3D11ClassInstance* const* ppClassInstances,
+		UINT numClassInstances) noexcept override;
+	void PSSetShader(ID3D11PixelShader* pShader, ID3D11ClassInstance* const* ppClassInstances,
+		UINT numClassInstances) noexcept override;
+	void VSSetConstantBuffers(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers) noexcept override;
+	void PSSetConstantBuffers(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers) noexcept override;
+	void VSSetConstantBuffers1(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers,
+		const UINT* pFirstConstant, const UINT* pNumConstants) noexcept override;
+	void PSSetConstantBuffers1(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* ppBuffers,
+		const UINT* pFirstConstant, const UINT* pNumConstants) noexcept override;
+	void PSSetShaderResources(UINT startSlot, UINT numViews,
+		ID3D11ShaderResourceView* const* ppViews) noexcept override;
+	void PSSetSamplers(UINT startSlot, UINT numSamplers, ID3D11SamplerState* const* ppSamplers) noexcept override;
+	void RSSetViewports(UINT numViewports, const D3D11_VIEWPORT* pViewports) noexcept override;
+	void OMSetRenderTargets(UINT numViews, ID3D11RenderTargetView* const* ppViews,
+		ID3D11DepthStencilView* pDepthStencilView) noexcept override;
+	void OMSetDepthStencilState(ID3D11DepthStencilState* pState, UINT stencilRef) noexcept override;
+	void ClearRenderTargetView(ID3D11RenderTargetView* pView, const FLOAT color[4]) noexcept override;
+	void ClearDepthStencilView(ID3D11DepthStencilView* pView, UINT clearFlags, FLOAT depth,
+		UINT8 stencil) noexcept override;
+	HRESULT Map(ID3D11Resource* pResource, UINT subresource, D3D11_MAP mapType, UINT mapFlags,
+		D3D11_MAPPED_SUBRESOURCE* pMappedResource) noexcept override;
+	void Unmap(ID3D11Resource* pResource, UINT subresource) noexcept override;
+	void CopySubresourceRegion(ID3D11Resource* pDstResource, UINT dstSubresource, UINT dstX, UINT dstY, UINT dstZ,
+		ID3D11Resource* pSrcResource, UINT srcSubresource, const D3D11_BOX* pSrcBox) noexcept override;
+	void DrawIndexed(UINT indexCount, UINT startIndexLocation, INT baseVertexLocation) noexcept override;
+	void DrawIndexedInstanced(UINT indexCountPerInstance, UINT instanceCount, UINT startIndexLocation,
+		INT baseVertexLocation, UINT startInstanceLocation) noexcept override;
+private:
+	template<typename T>
+	void RecordEach(CommandLog::Op op, UINT startSlot, UINT num, T* const* ppObjects)
+	{
+		for (UINT i = 0; i < num; i++)
+		{
+			log.Record(op, ppObjects[i], startSlot + i, 1u);
+		}
+	}
+private:
+	CommandLog log;
+	// cpu memory handed out by Map so callers can write their data somewhere
+	std::unordered_map<const ID3D11Resource*, std::vector<char>> mapScratch;
+};
@@ -0,0 +1,36 @@
+cbuffer ViewCBuf
+{
+	matrix view;
+	matrix projection;
+};
+
+struct VSOut
+{
+	float3 worldPos : Position;
+	float3 normal : Normal;
+	float4 pos : SV_Position;
+};
+
+// normals come in octahedron encoded (Dvtx::VertexLayout::NormalOct16)
+float3 DecodeOctNormal(float2 e)
+{
+	float3 n = float3(e, 1.0f - abs(e.x) - abs(e.y));
+	const float t = saturate(-n.z);
+	n.xy += n.xy >= 0.0f ? -t : t;
+	return normalize(n);
+}
+
+// model transform arrives per instance, one row per element (Bind::InstanceBuffer)
+VSOut main( float3 pos : Position, float2 octNormal : Normal,
+	float4 row0 : InstanceTransform0, float4 row1 : InstanceTransform1,
+	float4 row2 : InstanceTransform2, float4 row3 : InstanceTransform3 )
+{
+	const matrix modelView = mul(float4x4(row0, row1, row2, row3), view);
+
+	VSOut vso;
+	vso.worldPos = (float3)mul(float4(pos, 1.0f), modelView);
+	vso.normal = mul(DecodeOctNormal(octNormal), (float3x3)modelView);
+	vso.pos = mul(float4(vso.worldPos, 1.0f), projection);
+
+	return vso;
+}
\ No newline at end of file
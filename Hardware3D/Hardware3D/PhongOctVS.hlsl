@@ -0,0 +1,31 @@
+cbuffer CBuf
+{
+	matrix modelView;
+	matrix modelViewProjection;
+};
+
+struct VSOut
+{
+	float3 worldPos : Position;
+	float3 normal : Normal;
+	float4 pos : SV_Position;
+};
+
+// normals come in octahedron encoded (Dvtx::VertexLayout::NormalOct16)
+float3 DecodeOctNormal(float2 e)
+{
+	float3 n = float3(e, 1.0f - abs(e.x) - abs(e.y));
+	const float t = saturate(-n.z);
+	n.xy += n.xy >= 0.0f ? -t : t;
+	return normalize(n);
+}
+
+VSOut main( float3 pos : Position, float2 octNormal : Normal )
+{
+	VSOut vso;
+	vso.worldPos = (float3)mul(float4(pos, 1.0f), modelView);
+	vso.normal = mul(DecodeOctNormal(octNormal), (float3x3)modelView);
+	vso.pos = mul(float4(pos, 1.0f), modelViewProjection);
+
+	return vso;
+}
\ No newline at end of file
@@ -1,5 +1,6 @@
 ﻿#include "PixelShader.h"
 #include "GraphicsErrorMacros.h"
+#include "BindableCodex.h"
 
 namespace Bind
 {
@@ -16,5 +17,12 @@ namespace Bind
 	{
 		GetContext(gfx)->PSSetShader(pPixelShader.Get(), nullptr, 0u);
 	}
+
+	std::string PixelShader::GenerateUID(const std::wstring& path)
+	{
+		auto uid = Codex::MakeUID(typeid(PixelShader).name());
+		Codex::AppendUID(uid, path);
+		return uid;
+	}
 	
 }
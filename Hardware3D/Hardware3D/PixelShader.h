@@ -8,6 +8,7 @@ namespace Bind
 	public:
 		PixelShader(Graphics& gfx, const std::wstring& path);
 		void Bind(Graphics& gfx) noexcept override;
+		static std::string GenerateUID(const std::wstring& path);
 	protected:
 		Microsoft::WRL::ComPtr<ID3D11PixelShader> pPixelShader;
 	};
@@ -50,17 +50,45 @@ void PointLight::Reset() noexcept
 	};
 }
 
-void PointLight::Draw(Graphics& gfx) const noxnd
+void PointLight::Submit(RenderQueue& queue) const noxnd
 {
-	mesh.SetPos(cbData.pos);
-	mesh.Draw(gfx);
+	mesh.SetPos(GetPosition());
+	mesh.Submit(queue);
+	queue.AddFrameBind(cBuf);
 }
 
 void PointLight::Bind(Graphics& gfx, DirectX::FXMMATRIX view) const noexcept
 {
 	auto dataCopy = cbData;
-	const auto pos = DirectX::XMLoadFloat3(&cbData.pos);
+	dataCopy.pos = GetPosition();
+	const auto pos = DirectX::XMLoadFloat3(&dataCopy.pos);
 	DirectX::XMStoreFloat3(&dataCopy.pos, DirectX::XMVector3Transform(pos, view));
 	cBuf.Update(gfx, dataCopy);
 	cBuf.Bind(gfx);
 }
+
+void PointLight::SetOffset(const DirectX::XMFLOAT3& offset) noexcept
+{
+	this->offset = offset;
+}
+
+DirectX::XMFLOAT3 PointLight::GetPosition() const noexcept
+{
+	return { cbData.pos.x + offset.x, cbData.pos.y + offset.y, cbData.pos.z + offset.z };
+}
+
+SoftwareRasterizer::PhongLight PointLight::GetPhongLight(DirectX::FXMMATRIX view) const noexcept
+{
+	SoftwareRasterizer::PhongLight phongLight = {
+		{},
+		cbData.ambient,
+		cbData.diffuseColor,
+		cbData.diffuseIntensity,
+		cbData.attConst,
+		cbData.attLin,
+		cbData.attQuad,
+	};
+	const auto pos = GetPosition();
+	DirectX::XMStoreFloat3(&phongLight.pos, DirectX::XMVector3Transform(DirectX::XMLoadFloat3(&pos), view));
+	return phongLight;
+}
@@ -3,6 +3,8 @@
 #include "SolidSphere.h"
 #include "ConstantBuffers.h"
 #include "ConditionalNoExcept.h"
+#include "RenderQueue.h"
+#include "SoftwareRasterizer.h"
 
 class PointLight
 {
@@ -10,8 +12,15 @@ public:
 	PointLight(Graphics& gfx, float radius = 0.5f);
 	void SpawnControlWindow() noexcept;
 	void Reset() noexcept;
-	void Draw(Graphics& gfx) const noxnd;
+	// the light constants are registered as a frame bind of the queue, Bind has to run before it executes
+	void Submit(RenderQueue& queue) const noxnd;
 	void Bind(Graphics& gfx, DirectX::FXMMATRIX view) const noexcept;
+	// moves the light away from the position set in its window, for animating it
+	void SetOffset(const DirectX::XMFLOAT3& offset) noexcept;
+	// where the light is drawn, offset included
+	DirectX::XMFLOAT3 GetPosition() const noexcept;
+	// the constants Bind uploads, for drawing with the software rasterizer
+	SoftwareRasterizer::PhongLight GetPhongLight(DirectX::FXMMATRIX view) const noexcept;
 private:
 	struct PointLightCBuf
 	{
@@ -25,6 +34,7 @@ private:
 	};
 private:
 	PointLightCBuf cbData;
+	DirectX::XMFLOAT3 offset = {};
 	mutable SolidSphere mesh;
 	mutable Bind::PixelConstantBuffer<PointLightCBuf> cBuf;
 };
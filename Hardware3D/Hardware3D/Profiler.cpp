@@ -0,0 +1,271 @@
+﻿#include "Profiler.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <string_view>
+#include <unordered_map>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define PROFILER_RDTSC
+#endif
+
+using namespace std::chrono;
+
+namespace
+{
+	// ticks spent in the zones opened inside each open zone of this thread, for self times
+	constexpr size_t maxDepth = 64u;
+	thread_local std::uint64_t childTicks[maxDepth];
+	thread_local size_t depth = 0u;
+
+	void WriteJsonString(std::ostream& out, const char* s)
+	{
+		out << '"';
+		for (; *s; s++)
+		{
+			if (*s == '"' || *s == '\\')
+			{
+				out << '\\';
+			}
+			out << *s;
+		}
+		out << '"';
+	}
+}
+
+thread_local Profiler::ThreadBuffer* Profiler::pThreadBuffer = nullptr;
+
+Profiler::Zone::Zone(const char* name) noexcept
+	:
+	name(name)
+{
+	if (depth < maxDepth)
+	{
+		childTicks[depth] = 0u;
+	}
+	depth++;
+	start = Now();
+}
+
+Profiler::Zone::~Zone()
+{
+	const auto end = Now();
+	depth--;
+	const auto ticks = end - start;
+	const auto self = ticks - (depth < maxDepth ? childTicks[depth] : 0u);
+	if (depth > 0u && depth - 1u < maxDepth)
+	{
+		childTicks[depth - 1u] += ticks;
+	}
+	Get().Record(name, start, end, self);
+}
+
+Profiler::Profiler()
+	:
+	startTicks(Now()),
+	startTime(steady_clock::now()),
+	frameStart(startTicks)
+{
+}
+
+Profiler& Profiler::Get()
+{
+	static Profiler profiler;
+	return profiler;
+}
+
+std::uint64_t Profiler::Now() noexcept
+{
+#ifdef PROFILER_RDTSC
+	return __rdtsc();
+#else
+	return (std::uint64_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void Profiler::SetThreadName(std::string name)
+{
+	auto& buffer = GetThreadBuffer();
+	std::lock_guard<std::mutex> lock(buffersMutex);
+	buffer.name = std::move(name);
+}
+
+void Profiler::EndFrame()
+{
+	const auto now = Now();
+	constexpr auto capacity = ThreadBuffer::capacity;
+
+	events.clear();
+	{
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		for (auto& pBuffer : buffers)
+		{
+			auto& buffer = *pBuffer;
+			const auto head = buffer.head.load(std::memory_order_acquire);
+			const auto first = std::max(buffer.tail, head > capacity ? head - capacity : 0u);
+			const size_t eventsBefore = events.size();
+			for (auto i = first; i < head; i++)
+			{
+				const auto& slot = buffer.slots[i & (capacity - 1u)];
+				events.push_back({
+					slot.name.load(std::memory_order_relaxed),
+					slot.start.load(std::memory_order_relaxed),
+					slot.end.load(std::memory_order_relaxed),
+					slot.self.load(std::memory_order_relaxed),
+					buffer.threadIndex
+				});
+			}
+			// slots the thread started overwriting while they were copied are not to be trusted
+			std::atomic_thread_fence(std::memory_order_acquire);
+			const auto claimed = buffer.claimed.load(std::memory_order_relaxed);
+			const auto valid = std::clamp(claimed > capacity ? claimed - capacity : 0u, first, head);
+			events.erase(events.begin() + eventsBefore, events.begin() + eventsBefore + size_t(valid - first));
+			droppedZones += size_t(valid - buffer.tail);
+			buffer.tail = head;
+		}
+	}
+
+	// totals by name, the same literal can have different addresses in different translation units
+	const double msPerTick = 1000.0 / GetTicksPerSecond();
+	std::unordered_map<std::string_view, size_t> indices;
+	frameStats.clear();
+	for (const auto& e : events)
+	{
+		const auto [it, inserted] = indices.try_emplace(e.name, frameStats.size());
+		if (inserted)
+		{
+			frameStats.push_back({ e.name, 0u, 0.0f, 0.0f, 0.0f });
+		}
+		auto& stats = frameStats[it->second];
+		const float ms = float(double(e.end - e.start) * msPerTick);
+		stats.calls++;
+		stats.totalMs += ms;
+		stats.selfMs += float(double(e.self) * msPerTick);
+		stats.maxMs = std::max(stats.maxMs, ms);
+	}
+	std::sort(frameStats.begin(), frameStats.end(), [](const ZoneStats& a, const ZoneStats& b)
+	{
+		return a.totalMs > b.totalMs;
+	});
+	frameMs = float(double(now - frameStart) * msPerTick);
+	frameStart = now;
+
+	if (captureFramesLeft > 0u)
+	{
+		capture.insert(capture.end(), events.begin(), events.end());
+		captureFramesLeft--;
+	}
+}
+
+const std::vector<Profiler::ZoneStats>& Profiler::GetFrameStats() const noexcept
+{
+	return frameStats;
+}
+
+float Profiler::GetFrameMs() const noexcept
+{
+	return frameMs;
+}
+
+size_t Profiler::GetDroppedZones() const noexcept
+{
+	return droppedZones;
+}
+
+void Profiler::BeginCapture(size_t frames)
+{
+	capture.clear();
+	captureFramesLeft = frames;
+}
+
+bool Profiler::IsCapturing() const noexcept
+{
+	return captureFramesLeft > 0u;
+}
+
+size_t Profiler::GetCapturedZones() const noexcept
+{
+	return capture.size();
+}
+
+bool Profiler::SaveChromeTrace(const std::string& path) const
+{
+	std::ofstream file(path, std::ios::trunc);
+	if (!file)
+	{
+		return false;
+	}
+
+	// complete events ("X") with times in microseconds, chrome works out the nesting from them
+	const double usPerTick = 1000000.0 / GetTicksPerSecond();
+	std::uint64_t origin = 0u;
+	if (!capture.empty())
+	{
+		origin = std::min_element(capture.begin(), capture.end(), [](const Event& a, const Event& b)
+		{
+			return a.start < b.start;
+		})->start;
+	}
+	file << std::fixed << std::setprecision(3) << "{\"traceEvents\":[\n";
+	{
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		for (const auto& pBuffer : buffers)
+		{
+			file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << pBuffer->threadIndex
+				<< ",\"args\":{\"name\":";
+			WriteJsonString(file, pBuffer->name.c_str());
+			file << "}},\n";
+		}
+	}
+	for (size_t i = 0; i < capture.size(); i++)
+	{
+		const auto& e = capture[i];
+		file << "{\"name\":";
+		WriteJsonString(file, e.name);
+		file << ",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":0,\"tid\":" << e.threadIndex
+			<< ",\"ts\":" << double(e.start - origin) * usPerTick
+			<< ",\"dur\":" << double(e.end - e.start) * usPerTick << "}"
+			<< (i + 1u < capture.size() ? ",\n" : "\n");
+	}
+	file << "],\"displayTimeUnit\":\"ms\"}\n";
+	return bool(file);
+}
+
+Profiler::ThreadBuffer& Profiler::GetThreadBuffer()
+{
+	if (!pThreadBuffer)
+	{
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		auto pBuffer = std::make_unique<ThreadBuffer>();
+		pBuffer->threadIndex = (unsigned int)buffers.size();
+		pBuffer->name = "Thread " + std::to_string(pBuffer->threadIndex);
+		pThreadBuffer = pBuffer.get();
+		buffers.push_back(std::move(pBuffer));
+	}
+	return *pThreadBuffer;
+}
+
+void Profiler::Record(const char* name, std::uint64_t start, std::uint64_t end, std::uint64_t self)
+{
+	auto& buffer = GetThreadBuffer();
+	const auto index = buffer.head.load(std::memory_order_relaxed);
+	// announce the overwrite before touching the slot, see EndFrame
+	buffer.claimed.store(index + 1u, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	auto& slot = buffer.slots[index & (ThreadBuffer::capacity - 1u)];
+	slot.name.store(name, std::memory_order_relaxed);
+	slot.start.store(start, std::memory_order_relaxed);
+	slot.end.store(end, std::memory_order_relaxed);
+	slot.self.store(self, std::memory_order_relaxed);
+	buffer.head.store(index + 1u, std::memory_order_release);
+}
+
+double Profiler::GetTicksPerSecond() const noexcept
+{
+	const double seconds = duration<double>(steady_clock::now() - startTime).count();
+	if (seconds <= 0.0)
+	{
+		return 1e9;
+	}
+	return double(Now() - startTicks) / seconds;
+}
@@ -0,0 +1,113 @@
+﻿#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// cpu zone profiler. PROFILE_ZONE marks the rest of a scope, zones nest and can be opened on any thread
+// every thread writes its finished zones into a ring of its own without locking, EndFrame collects them once a
+// frame into per zone totals and, while a capture runs, into a timeline that can be saved as a chrome trace
+// (chrome://tracing, ui.perfetto.dev). a ring that isn't collected in time loses its oldest zones
+#define PROFILER_CONCAT_IMPL(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_IMPL(a, b)
+// name has to outlive the profiler, string literals do
+#define PROFILE_ZONE(name) Profiler::Zone PROFILER_CONCAT(profilerZone, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_ZONE(__FUNCTION__)
+
+class Profiler
+{
+public:
+	class Zone
+	{
+	public:
+		Zone(const char* name) noexcept;
+		Zone(const Zone&) = delete;
+		Zone& operator=(const Zone&) = delete;
+		~Zone();
+	private:
+		const char* name;
+		std::uint64_t start;
+	};
+	// one zone name over the last frame, sorted by total time
+	struct ZoneStats
+	{
+		const char* name;
+		size_t calls;
+		// including / excluding the zones opened inside
+		float totalMs;
+		float selfMs;
+		float maxMs;
+	};
+private:
+	// fields are atomic so a collect racing an overwrite reads stale values instead of a data race,
+	// it finds out from claimed and throws them away
+	struct Slot
+	{
+		std::atomic<const char*> name;
+		std::atomic<std::uint64_t> start;
+		std::atomic<std::uint64_t> end;
+		std::atomic<std::uint64_t> self;
+	};
+	struct ThreadBuffer
+	{
+		static constexpr size_t capacity = 1u << 14u;
+		std::unique_ptr<Slot[]> slots = std::make_unique<Slot[]>(capacity);
+		// zones ever started being written / finished being written, only the owning thread stores
+		std::atomic<std::uint64_t> claimed{ 0u };
+		std::atomic<std::uint64_t> head{ 0u };
+		// zones collected, only EndFrame touches it
+		std::uint64_t tail = 0u;
+		unsigned int threadIndex;
+		std::string name;
+	};
+	struct Event
+	{
+		const char* name;
+		std::uint64_t start;
+		std::uint64_t end;
+		std::uint64_t self;
+		unsigned int threadIndex;
+	};
+public:
+	Profiler();
+	Profiler(const Profiler&) = delete;
+	Profiler& operator=(const Profiler&) = delete;
+	static Profiler& Get();
+	// timestamp in ticks, rdtsc where available and steady_clock nanoseconds elsewhere
+	static std::uint64_t Now() noexcept;
+	// shown for the calling thread in traces
+	void SetThreadName(std::string name);
+	// collects the zones every thread finished since the last call, once a frame on the render thread
+	void EndFrame();
+	const std::vector<ZoneStats>& GetFrameStats() const noexcept;
+	float GetFrameMs() const noexcept;
+	// zones lost to rings that wrapped around before they were collected, since the profiler started
+	size_t GetDroppedZones() const noexcept;
+	// records the timeline of the next frames (dropping what an earlier capture recorded)
+	void BeginCapture(size_t frames);
+	bool IsCapturing() const noexcept;
+	size_t GetCapturedZones() const noexcept;
+	// the captured timeline in chrome's trace event format, false if the file couldn't be written
+	bool SaveChromeTrace(const std::string& path) const;
+private:
+	ThreadBuffer& GetThreadBuffer();
+	void Record(const char* name, std::uint64_t start, std::uint64_t end, std::uint64_t self);
+	// ticks per second of Now(), measured against steady_clock since the profiler started
+	double GetTicksPerSecond() const noexcept;
+private:
+	static thread_local ThreadBuffer* pThreadBuffer;
+	mutable std::mutex buffersMutex;
+	std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+	const std::uint64_t startTicks;
+	const std::chrono::steady_clock::time_point startTime;
+	std::uint64_t frameStart;
+	float frameMs = 0.0f;
+	size_t droppedZones = 0u;
+	std::vector<ZoneStats> frameStats;
+	std::vector<Event> events;
+	size_t captureFramesLeft = 0u;
+	std::vector<Event> capture;
+};
@@ -0,0 +1,312 @@
+﻿#include "RenderQueue.h"
+#include "Drawable.h"
+#include "Bindable.h"
+#include "FrameConstantRing.h"
+#include "DeferredContext.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <utility>
+
+namespace dx = DirectX;
+
+RenderQueue::RenderQueue() = default;
+
+RenderQueue::~RenderQueue() = default;
+
+std::uint64_t RenderQueue::MakeStateKey(unsigned int vertexShader, unsigned int pixelShader,
+                                        unsigned int material, unsigned int vertexBuffer) noexcept
+{
+	constexpr std::uint64_t mask = 0xFFFu;
+	return ((vertexShader & mask) << 52u) |
+		((pixelShader & mask) << 40u) |
+		((material & mask) << 28u) |
+		((vertexBuffer & mask) << 16u);
+}
+
+void RenderQueue::BeginFrame(const Graphics& gfx) noexcept
+{
+	frustum.emplace(gfx.GetCamera() * gfx.GetProjection());
+	cullStats = {};
+	frameBinds.clear();
+}
+
+void RenderQueue::AddFrameBind(Bind::Bindable& bind)
+{
+	frameBinds.push_back(&bind);
+}
+
+const Frustum* RenderQueue::GetFrustum() const noexcept
+{
+	return frustum ? &*frustum : nullptr;
+}
+
+RenderQueue::CullStats& RenderQueue::GetCullStats() noexcept
+{
+	return cullStats;
+}
+
+const RenderQueue::CullStats& RenderQueue::GetCullStats() const noexcept
+{
+	return cullStats;
+}
+
+void RenderQueue::Submit(const Drawable& drawable, std::uint64_t stateKey, DirectX::FXMMATRIX transform)
+{
+	packets.push_back({ &drawable, stateKey });
+	dx::XMStoreFloat4x4(&packets.back().transform, transform);
+}
+
+void RenderQueue::Execute(Graphics& gfx) noxnd
+{
+	PROFILE_ZONE("RenderQueue::Execute");
+	// finish the keys off with view depth so draws sharing state go front to back
+	const auto view = gfx.GetCamera();
+	entries.clear();
+	entries.reserve(packets.size());
+	for (unsigned int i = 0; i < (unsigned int)packets.size(); i++)
+	{
+		const auto& t = packets[i].transform;
+		const auto viewPos = dx::XMVector3Transform(dx::XMVectorSet(t._41, t._42, t._43, 1.0f), view);
+		entries.push_back({ packets[i].key | QuantizeDepth(dx::XMVectorGetZ(viewPos)), i });
+	}
+
+	RadixSort(entries, scratch);
+
+	// packets of one drawable share the state part of the key, but the ids in it are cut to 12 bits, so
+	// another drawable whose ids collide can sort in between by depth. only adjacent packets of a drawable
+	// get merged into an instanced draw, a drawable split up like that just takes more than one
+	drawStats = {};
+	draws.clear();
+	instanceTransforms.clear();
+	for (size_t i = 0; i < entries.size();)
+	{
+		const auto packetIndex = entries[i].packetIndex;
+		const auto pDrawable = packets[packetIndex].pDrawable;
+		size_t run = 1u;
+		if (pDrawable->SupportsInstancing())
+		{
+			while (i + run < entries.size() && packets[entries[i + run].packetIndex].pDrawable == pDrawable)
+			{
+				run++;
+			}
+		}
+		if (run > 1u)
+		{
+			draws.push_back({ pDrawable, packetIndex, (unsigned int)run, instanceTransforms.size() });
+			for (size_t j = i; j < i + run; j++)
+			{
+				instanceTransforms.push_back(packets[entries[j].packetIndex].transform);
+			}
+			drawStats.instances += run;
+		}
+		else
+		{
+			draws.push_back({ pDrawable, packetIndex, 0u, 0u });
+		}
+		i += run;
+	}
+	drawStats.drawCalls = draws.size();
+
+	// single draws stage their constants first so the whole frame goes up to the gpu in one map,
+	// instanced ones size their instance streams so recording the draws only writes into them
+	const auto pRing = gfx.GetFrameConstants();
+	for (const auto& draw : draws)
+	{
+		if (draw.instanceCount > 0u)
+		{
+			draw.pDrawable->StageInstanced(gfx, draw.instanceCount);
+		}
+		else if (pRing)
+		{
+			draw.pDrawable->Stage(gfx, dx::XMLoadFloat4x4(&packets[draw.packetIndex].transform));
+		}
+	}
+	if (pRing)
+	{
+		pRing->Flush(gfx);
+	}
+
+	const size_t sliceCount = parallelRecording ? MakeSlices(JobSystem::Get().GetStats().workers + 1u) : 1u;
+	if (sliceCount < 2u)
+	{
+		RecordDraws(gfx, 0u, draws.size());
+	}
+	else
+	{
+		while (deferredContexts.size() < sliceCount)
+		{
+			deferredContexts.push_back(std::make_unique<DeferredContext>(gfx));
+		}
+		const auto recordSlices = [this, &gfx](size_t begin, size_t end)
+		{
+			for (size_t slice = begin; slice < end; slice++)
+			{
+				PROFILE_ZONE("RenderQueue::RecordSlice");
+				auto& context = *deferredContexts[slice];
+				context.Begin(gfx);
+				for (const auto pBind : frameBinds)
+				{
+					pBind->Bind(gfx);
+				}
+				RecordDraws(gfx, sliceStarts[slice], sliceStarts[slice + 1u]);
+				context.Finish(gfx);
+			}
+		};
+#ifdef NDEBUG
+		JobSystem::Get().ParallelFor(sliceCount, 1u, recordSlices);
+#else
+		// all threads share the dxgi info queue, messages of draws recorded side by side would end up
+		// in each other's exceptions
+		recordSlices(0u, sliceCount);
+#endif
+		for (size_t slice = 0; slice < sliceCount; slice++)
+		{
+			deferredContexts[slice]->Execute(gfx);
+		}
+		// playing back left the immediate context in default state, whatever draws after the queue needs them too
+		for (const auto pBind : frameBinds)
+		{
+			pBind->Bind(gfx);
+		}
+		drawStats.recordingSlices = sliceCount;
+	}
+	packets.clear();
+}
+
+size_t RenderQueue::GetPacketCount() const noexcept
+{
+	return packets.size();
+}
+
+const RenderQueue::DrawStats& RenderQueue::GetDrawStats() const noexcept
+{
+	return drawStats;
+}
+
+void RenderQueue::SetParallelRecording(bool enabled, size_t minSliceDraws) noexcept
+{
+	parallelRecording = enabled;
+	this->minSliceDraws = std::max(minSliceDraws, size_t(1u));
+}
+
+bool RenderQueue::IsParallelRecording() const noexcept
+{
+	return parallelRecording;
+}
+
+void RenderQueue::RecordDraws(Graphics& gfx, size_t begin, size_t end) const noxnd
+{
+	for (size_t i = begin; i < end; i++)
+	{
+		const auto& draw = draws[i];
+		if (draw.instanceCount > 0u)
+		{
+			draw.pDrawable->DrawInstanced(gfx, &instanceTransforms[draw.firstInstance], draw.instanceCount);
+		}
+		else
+		{
+			draw.pDrawable->Draw(gfx, dx::XMLoadFloat4x4(&packets[draw.packetIndex].transform));
+		}
+	}
+}
+
+size_t RenderQueue::MakeSlices(size_t maxSlices)
+{
+	const size_t drawCount = draws.size();
+	sliceStarts.assign(1u, 0u);
+	if (maxSlices > 1u && drawCount >= 2u * minSliceDraws)
+	{
+		// drawables carry state from one of their draws to the next (staged constants, the transform of a mesh),
+		// so every draw of a drawable has to be recorded on the same thread, in order. no slice may start
+		// between the first and the last draw of a drawable
+		lastDraws.clear();
+		spanned.assign(drawCount + 1u, 0);
+		for (size_t i = 0; i < drawCount; i++)
+		{
+			const auto [it, first] = lastDraws.try_emplace(draws[i].pDrawable, i);
+			if (!first)
+			{
+				spanned[it->second + 1u]++;
+				spanned[i + 1u]--;
+				it->second = i;
+			}
+		}
+
+		const size_t sliceDraws = std::max(minSliceDraws, (drawCount + maxSlices - 1u) / maxSlices);
+		int open = 0;
+		for (size_t i = 1; i < drawCount && sliceStarts.size() < maxSlices; i++)
+		{
+			open += spanned[i];
+			if (open == 0 && i - sliceStarts.back() >= sliceDraws && drawCount - i >= minSliceDraws)
+			{
+				sliceStarts.push_back(i);
+			}
+		}
+	}
+	sliceStarts.push_back(drawCount);
+	return sliceStarts.size() - 1u;
+}
+
+std::uint16_t RenderQueue::QuantizeDepth(float viewDepth) noexcept
+{
+	// bit patterns of non-negative floats sort the same as their values, the top 16 bits
+	// keep the exponent and 7 bits of mantissa which is plenty for coarse ordering
+	viewDepth = viewDepth > 0.0f ? viewDepth : 0.0f;
+	std::uint32_t bits;
+	std::memcpy(&bits, &viewDepth, sizeof(bits));
+	return std::uint16_t(bits >> 16u);
+}
+
+void RenderQueue::RadixSort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch) noexcept
+{
+	constexpr size_t digitCount = sizeof(std::uint64_t);
+	const size_t n = entries.size();
+	if (n < 2u)
+	{
+		return;
+	}
+	scratch.resize(n);
+
+	// histogram every digit in one pass
+	std::array<std::array<unsigned int, 256>, digitCount> histograms = {};
+	for (const auto& e : entries)
+	{
+		for (size_t d = 0; d < digitCount; d++)
+		{
+			histograms[d][(e.key >> (d * 8u)) & 0xFFu]++;
+		}
+	}
+
+	auto* pSrc = &entries;
+	auto* pDst = &scratch;
+	for (size_t d = 0; d < digitCount; d++)
+	{
+		auto& histogram = histograms[d];
+		// all keys share this digit, the pass wouldn't move anything
+		if (histogram[(entries.front().key >> (d * 8u)) & 0xFFu] == n)
+		{
+			continue;
+		}
+		// exclusive prefix sum gives the start of each bucket
+		unsigned int offset = 0u;
+		for (auto& count : histogram)
+		{
+			const auto c = count;
+			count = offset;
+			offset += c;
+		}
+		for (const auto& e : *pSrc)
+		{
+			(*pDst)[histogram[(e.key >> (d * 8u)) & 0xFFu]++] = e;
+		}
+		std::swap(pSrc, pDst);
+	}
+
+	if (pSrc != &entries)
+	{
+		entries.swap(scratch);
+	}
+}
@@ -0,0 +1,117 @@
+﻿#pragma once
+#include <DirectXMath.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <optional>
+#include <unordered_map>
+#include "ConditionalNoExcept.h"
+#include "Frustum.h"
+
+class Graphics;
+class Drawable;
+class DeferredContext;
+
+namespace Bind
+{
+	class Bindable;
+}
+
+// collects draws during scene traversal and submits them ordered by pipeline state
+// key layout (msb -> lsb): vertex shader 12 | pixel shader 12 | material 12 | vertex buffer 12 | depth 16
+// adjacent packets for the same instancing capable drawable are merged into a single instanced draw,
+// the constants of the remaining draws are staged and uploaded together before any of them is drawn
+// large frames are recorded in slices on the job system, each into its own DeferredContext, and played back in order
+class RenderQueue
+{
+public:
+	// mesh counts of the frame since the last BeginFrame, for benchmarking the culling
+	struct CullStats
+	{
+		size_t visible = 0u;
+		size_t culled = 0u;
+		// subtrees rejected with a single test
+		size_t culledNodes = 0u;
+	};
+	// what the last Execute sent to the gpu
+	struct DrawStats
+	{
+		size_t drawCalls = 0u;
+		// packets that were merged into instanced draws
+		size_t instances = 0u;
+		// deferred contexts the draws were recorded into, 0 when they went to the immediate context
+		size_t recordingSlices = 0u;
+	};
+	struct DrawPacket
+	{
+		const Drawable* pDrawable;
+		// state part of the key, depth is filled in when the queue is executed
+		std::uint64_t key;
+		DirectX::XMFLOAT4X4 transform;
+	};
+private:
+	// what actually gets sorted, keeps the shuffled data small
+	struct SortEntry
+	{
+		std::uint64_t key;
+		unsigned int packetIndex;
+	};
+	// what one draw call of the sorted frame is made of
+	struct DrawCall
+	{
+		const Drawable* pDrawable;
+		// the packet of a single draw
+		unsigned int packetIndex;
+		// 0 for a single draw
+		unsigned int instanceCount;
+		// where the transforms of an instanced draw start in instanceTransforms
+		size_t firstInstance;
+	};
+public:
+	RenderQueue();
+	~RenderQueue();
+	static std::uint64_t MakeStateKey(unsigned int vertexShader, unsigned int pixelShader,
+		unsigned int material, unsigned int vertexBuffer) noexcept;
+	// takes the view frustum from the camera and projection of gfx, resets the cull stats and the frame binds
+	void BeginFrame(const Graphics& gfx) noexcept;
+	// state the draws depend on that no drawable binds itself (the light constants). recording slices start
+	// from default state, so these are bound again at the start of every slice and after playing them back
+	void AddFrameBind(Bind::Bindable& bind);
+	// nullptr before the first BeginFrame, nothing gets culled then
+	const Frustum* GetFrustum() const noexcept;
+	CullStats& GetCullStats() noexcept;
+	const CullStats& GetCullStats() const noexcept;
+	void Submit(const Drawable& drawable, std::uint64_t stateKey, DirectX::FXMMATRIX transform);
+	// sorts everything submitted since the last execute, draws it and empties the queue
+	void Execute(Graphics& gfx) noxnd;
+	size_t GetPacketCount() const noexcept;
+	const DrawStats& GetDrawStats() const noexcept;
+	// frames with at least two slices of minSliceDraws draw calls get recorded in parallel
+	void SetParallelRecording(bool enabled, size_t minSliceDraws = 64u) noexcept;
+	bool IsParallelRecording() const noexcept;
+private:
+	void RecordDraws(Graphics& gfx, size_t begin, size_t end) const noxnd;
+	// splits the draw calls into at most maxSlices ranges in sliceStarts, returns how many it made
+	size_t MakeSlices(size_t maxSlices);
+	static std::uint16_t QuantizeDepth(float viewDepth) noexcept;
+	// lsd radix sort over 8 bit digits, digits that are the same for every key are skipped
+	static void RadixSort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch) noexcept;
+private:
+	std::optional<Frustum> frustum;
+	CullStats cullStats;
+	DrawStats drawStats;
+	std::vector<DrawPacket> packets;
+	std::vector<SortEntry> entries;
+	std::vector<SortEntry> scratch;
+	std::vector<DirectX::XMFLOAT4X4> instanceTransforms;
+	std::vector<DrawCall> draws;
+	std::vector<Bind::Bindable*> frameBinds;
+	bool parallelRecording = true;
+	size_t minSliceDraws = 64u;
+	// first draw call of every slice, followed by the number of draw calls
+	std::vector<size_t> sliceStarts;
+	std::vector<std::unique_ptr<DeferredContext>> deferredContexts;
+	// MakeSlices scratch
+	std::unordered_map<const Drawable*, size_t> lastDraws;
+	std::vector<int> spanned;
+};
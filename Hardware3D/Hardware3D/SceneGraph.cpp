@@ -0,0 +1,265 @@
+﻿#include "SceneGraph.h"
+#include "Mesh.h"
+#include "RenderQueue.h"
+#include "Profiler.h"
+#include "imgui/imgui.h"
+#include <algorithm>
+#include <cassert>
+#include <unordered_map>
+#include <utility>
+
+namespace dx = DirectX;
+
+SceneGraph::SceneGraph(const std::vector<MeshCache::NodeRecord>& records,
+                       const std::vector<std::unique_ptr<Mesh>>& meshPtrs) noxnd
+{
+	const auto count = (unsigned int)records.size();
+	parents.resize(count);
+	subtreeEnds.resize(count);
+	nameIndices.reserve(count);
+	localTransforms.reserve(count);
+	appliedTransforms.resize(count);
+	worldTransforms.resize(count);
+	subtreeBounds.resize(count);
+	worldBounds.resize(count);
+	subtreeMeshCounts.resize(count);
+	meshOffsets.reserve(count + 1u);
+	worldDirty.assign(count, 1u);
+
+	std::unordered_map<std::string, unsigned int> nameLookup;
+	// nodes whose children are still coming up, with the number of children left
+	std::vector<std::pair<unsigned int, unsigned int>> open;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		const auto& record = records[i];
+		while (!open.empty() && open.back().second == 0u)
+		{
+			subtreeEnds[open.back().first] = i;
+			open.pop_back();
+		}
+		if (open.empty())
+		{
+			parents[i] = noParent;
+		}
+		else
+		{
+			parents[i] = open.back().first;
+			open.back().second--;
+		}
+		open.push_back({ i, record.childCount });
+
+		const auto name = nameLookup.emplace(record.name, (unsigned int)names.size());
+		if (name.second)
+		{
+			names.push_back(record.name);
+		}
+		nameIndices.push_back(name.first->second);
+
+		localTransforms.push_back(record.transform);
+		dx::XMStoreFloat4x4(&appliedTransforms[i], dx::XMMatrixIdentity());
+
+		meshOffsets.push_back((unsigned int)meshes.size());
+		for (const auto m : record.meshIndices)
+		{
+			assert(m < meshPtrs.size());
+			meshes.push_back(meshPtrs[m].get());
+		}
+	}
+	for (const auto& o : open)
+	{
+		subtreeEnds[o.first] = count;
+	}
+	meshOffsets.push_back((unsigned int)meshes.size());
+
+	// mesh counts never change, children sit after their parent so a backwards pass sees them first
+	for (unsigned int i = count; i-- > 0u;)
+	{
+		subtreeMeshCounts[i] += meshOffsets[i + 1u] - meshOffsets[i];
+		if (parents[i] != noParent)
+		{
+			subtreeMeshCounts[parents[i]] += subtreeMeshCounts[i];
+		}
+	}
+	Update();
+}
+
+size_t SceneGraph::GetNodeCount() const noexcept
+{
+	return parents.size();
+}
+
+const std::string& SceneGraph::GetName(size_t node) const noxnd
+{
+	return names[nameIndices[node]];
+}
+
+unsigned int SceneGraph::GetParent(size_t node) const noxnd
+{
+	return parents[node];
+}
+
+size_t SceneGraph::GetSubtreeEnd(size_t node) const noxnd
+{
+	return subtreeEnds[node];
+}
+
+void SceneGraph::SetAppliedTransform(size_t node, DirectX::FXMMATRIX transform) noxnd
+{
+	assert(node < parents.size());
+	dx::XMStoreFloat4x4(&appliedTransforms[node], transform);
+	worldDirty[node] = 1u;
+	anyWorldDirty = true;
+	// a node's own subtree bounds sit after its transforms, only the ancestors are affected
+	boundsDirty = boundsDirty || parents[node] != noParent;
+}
+
+void SceneGraph::Update() noexcept
+{
+	if (!anyWorldDirty && !boundsDirty)
+	{
+		return;
+	}
+	const bool allBounds = boundsDirty;
+	if (boundsDirty)
+	{
+		UpdateBounds();
+	}
+
+	// parents come first, so a moved parent has already flagged itself by the time its children are reached
+	for (size_t i = 0; i < parents.size(); i++)
+	{
+		const auto parent = parents[i];
+		if (parent != noParent)
+		{
+			worldDirty[i] |= worldDirty[parent];
+		}
+		if (worldDirty[i])
+		{
+			const auto parentWorld = parent != noParent ?
+				dx::XMLoadFloat4x4(&worldTransforms[parent]) :
+				dx::XMMatrixIdentity();
+			dx::XMStoreFloat4x4(&worldTransforms[i],
+				dx::XMLoadFloat4x4(&appliedTransforms[i]) *
+				dx::XMLoadFloat4x4(&localTransforms[i]) *
+				parentWorld
+			);
+		}
+		if (worldDirty[i] || allBounds)
+		{
+			worldBounds[i] = subtreeBounds[i].Transformed(dx::XMLoadFloat4x4(&worldTransforms[i]));
+		}
+	}
+	std::fill(worldDirty.begin(), worldDirty.end(), (unsigned char)0u);
+	anyWorldDirty = false;
+}
+
+void SceneGraph::UpdateBounds() noexcept
+{
+	for (size_t i = 0; i < parents.size(); i++)
+	{
+		subtreeBounds[i] = {};
+		for (auto m = meshOffsets[i]; m < meshOffsets[i + 1u]; m++)
+		{
+			subtreeBounds[i] = Bounds::Merge(subtreeBounds[i], meshes[m]->GetBounds());
+		}
+	}
+	// backwards, every child is complete before it gets merged into its parent
+	for (size_t i = parents.size(); i-- > 0u;)
+	{
+		const auto parent = parents[i];
+		if (parent != noParent)
+		{
+			const auto toParent = dx::XMLoadFloat4x4(&appliedTransforms[i]) * dx::XMLoadFloat4x4(&localTransforms[i]);
+			subtreeBounds[parent] = Bounds::Merge(subtreeBounds[parent], subtreeBounds[i].Transformed(toParent));
+		}
+	}
+	boundsDirty = false;
+}
+
+void SceneGraph::Submit(RenderQueue& queue) const
+{
+	Submit(queue, nullptr);
+}
+
+void SceneGraph::Submit(RenderQueue& queue, DirectX::FXMMATRIX placement) const
+{
+	const dx::XMMATRIX p = placement;
+	Submit(queue, &p);
+}
+
+void SceneGraph::Submit(RenderQueue& queue, const DirectX::XMMATRIX* pPlacement) const
+{
+	PROFILE_ZONE("SceneGraph::Submit");
+	auto& stats = queue.GetCullStats();
+	const auto pFrustum = queue.GetFrustum();
+	// nodes before this index are inside a subtree that was found fully inside the frustum
+	size_t insideEnd = pFrustum != nullptr ? 0u : parents.size();
+
+	for (size_t i = 0; i < parents.size();)
+	{
+		// nothing to draw or cull below
+		if (subtreeMeshCounts[i] == 0u)
+		{
+			i = subtreeEnds[i];
+			continue;
+		}
+		const bool testBounds = i >= insideEnd;
+		if (testBounds)
+		{
+			switch (pFrustum->Test(pPlacement ? worldBounds[i].Transformed(*pPlacement) : worldBounds[i]))
+			{
+			case Frustum::Result::Outside:
+				stats.culledNodes++;
+				stats.culled += subtreeMeshCounts[i];
+				i = subtreeEnds[i];
+				continue;
+			case Frustum::Result::Inside:
+				insideEnd = subtreeEnds[i];
+				break;
+			case Frustum::Result::Intersects:
+				break;
+			}
+		}
+
+		const auto world = pPlacement ?
+			dx::XMLoadFloat4x4(&worldTransforms[i]) * *pPlacement :
+			dx::XMLoadFloat4x4(&worldTransforms[i]);
+		const bool testMeshes = testBounds && insideEnd <= i && subtreeMeshCounts[i] > 1u;
+		for (auto m = meshOffsets[i]; m < meshOffsets[i + 1u]; m++)
+		{
+			// a lone mesh was just tested as the whole subtree
+			if (testMeshes && pFrustum->Test(meshes[m]->GetBounds().Transformed(world)) == Frustum::Result::Outside)
+			{
+				stats.culled++;
+				continue;
+			}
+			stats.visible++;
+			meshes[m]->Submit(queue, world);
+		}
+		i++;
+	}
+}
+
+void SceneGraph::ShowTree(size_t node, std::optional<int>& selectedIndex) const noexcept
+{
+	const auto end = subtreeEnds[node];
+	// build up flags for current node
+	const auto node_flags = ImGuiTreeNodeFlags_OpenOnArrow
+		| (((int)node == selectedIndex.value_or( -1 )) ? ImGuiTreeNodeFlags_Selected : 0)
+		| ((end == node + 1u) ? ImGuiTreeNodeFlags_Leaf : 0);
+	// node index doubles as the uid of the gui tree node
+	const auto expanded = ImGui::TreeNodeEx( (void*)(intptr_t)node,node_flags,GetName( node ).c_str() );
+	if( ImGui::IsItemClicked() )
+	{
+		selectedIndex = (int)node;
+	}
+	// direct children, each one jumps over its own subtree
+	if( expanded )
+	{
+		for( size_t child = node + 1u; child < end; child = subtreeEnds[child] )
+		{
+			ShowTree( child,selectedIndex );
+		}
+		ImGui::TreePop();
+	}
+}
@@ -0,0 +1,64 @@
+﻿#pragma once
+#include <DirectXMath.h>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "ConditionalNoExcept.h"
+#include "Bounds.h"
+#include "MeshCache.h"
+
+class Mesh;
+class RenderQueue;
+
+// node hierarchy of a model as parallel arrays in depth first order
+// a parent always comes before its children and every subtree is one contiguous index range,
+// so world transforms are a single forward pass and a culled subtree is skipped by jumping past it
+class SceneGraph
+{
+public:
+	static constexpr unsigned int noParent = ~0u;
+public:
+	// records in the depth first order the importer and the mesh cache produce, mesh indices refer to meshPtrs
+	SceneGraph(const std::vector<MeshCache::NodeRecord>& records, const std::vector<std::unique_ptr<Mesh>>& meshPtrs) noxnd;
+	size_t GetNodeCount() const noexcept;
+	const std::string& GetName(size_t node) const noxnd;
+	unsigned int GetParent(size_t node) const noxnd;
+	// one past the last node below node
+	size_t GetSubtreeEnd(size_t node) const noxnd;
+	// dirties the world transforms from node down and the bounds of its ancestors
+	void SetAppliedTransform(size_t node, DirectX::FXMMATRIX transform) noxnd;
+	// rebuilds whatever was dirtied since the last call, an untouched graph costs nothing
+	void Update() noexcept;
+	// world transforms have to be up to date, subtrees are culled against the queue's frustum if it has one
+	void Submit(RenderQueue& queue) const;
+	// the whole graph once more with placement applied on top of the world transforms
+	void Submit(RenderQueue& queue, DirectX::FXMMATRIX placement) const;
+	// gui tree of node and its subtree, selectedIndex is the node index
+	void ShowTree(size_t node, std::optional<int>& selectedIndex) const noexcept;
+private:
+	void UpdateBounds() noexcept;
+	void Submit(RenderQueue& queue, const DirectX::XMMATRIX* pPlacement) const;
+private:
+	// per node
+	std::vector<unsigned int> parents;
+	std::vector<unsigned int> subtreeEnds;
+	std::vector<unsigned int> nameIndices;
+	std::vector<DirectX::XMFLOAT4X4> localTransforms;
+	std::vector<DirectX::XMFLOAT4X4> appliedTransforms;
+	// appliedTransform * localTransform * parent world
+	std::vector<DirectX::XMFLOAT4X4> worldTransforms;
+	// in the space the node's meshes are drawn in
+	std::vector<Bounds> subtreeBounds;
+	std::vector<Bounds> worldBounds;
+	std::vector<unsigned int> subtreeMeshCounts;
+	// meshes of node i are meshes[meshOffsets[i]] up to meshes[meshOffsets[i + 1]]
+	std::vector<unsigned int> meshOffsets;
+	std::vector<const Mesh*> meshes;
+	// chars rather than vector<bool>, flags are read and written per node in the update pass
+	std::vector<unsigned char> worldDirty;
+	bool anyWorldDirty = true;
+	bool boundsDirty = true;
+	// interned, exporters tend to repeat the same few names
+	std::vector<std::string> names;
+};
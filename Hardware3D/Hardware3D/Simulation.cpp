@@ -0,0 +1,186 @@
+﻿#include "Simulation.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace dx = DirectX;
+using namespace std::chrono;
+
+namespace
+{
+	// everything random about a walker comes from its index
+	std::uint32_t HashWalker(size_t index) noexcept
+	{
+		return std::uint32_t(index + 1u) * 2654435761u;
+	}
+}
+
+Simulation::Simulation(float stepSeconds)
+	:
+	stepSeconds(stepSeconds),
+	currentTime(steady_clock::now())
+{
+	thread = std::thread([this]() { Run(); });
+}
+
+Simulation::~Simulation()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	thread.join();
+}
+
+void Simulation::SetParameters(const Parameters& parameters)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		this->parameters = parameters;
+	}
+	// pausing and resuming take effect right away
+	wake.notify_all();
+}
+
+void Simulation::Sample(Frame& frame) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	frame.step = current.step;
+	frame.alpha = 1.0f;
+	if (parameters.speedFactor > 0.0f)
+	{
+		const float stepReal = stepSeconds / parameters.speedFactor;
+		const float elapsed = duration<float>(steady_clock::now() - currentTime).count();
+		frame.alpha = std::clamp(elapsed / stepReal, 0.0f, 1.0f);
+	}
+
+	const auto prevOffset = dx::XMLoadFloat3(&previous.lightOffset);
+	const auto curOffset = dx::XMLoadFloat3(&current.lightOffset);
+	dx::XMStoreFloat3(&frame.lightOffset, dx::XMVectorLerp(prevOffset, curOffset, frame.alpha));
+
+	frame.crowd.resize(current.crowd.size());
+	for (size_t i = 0; i < current.crowd.size(); i++)
+	{
+		const auto& cur = current.crowd[i];
+		auto pos = dx::XMLoadFloat3(&cur.pos);
+		float heading = cur.heading;
+		// walkers that joined in the current step have nothing to come from
+		if (i < previous.crowd.size())
+		{
+			const auto& prev = previous.crowd[i];
+			pos = dx::XMVectorLerp(dx::XMLoadFloat3(&prev.pos), pos, frame.alpha);
+			heading = prev.heading + dx::XMScalarModAngle(cur.heading - prev.heading) * frame.alpha;
+		}
+		dx::XMStoreFloat4x4(&frame.crowd[i], dx::XMMatrixRotationY(heading) * dx::XMMatrixTranslationFromVector(pos));
+	}
+}
+
+float Simulation::GetStepSeconds() const noexcept
+{
+	return stepSeconds;
+}
+
+Simulation::Stats Simulation::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stats;
+}
+
+void Simulation::Run()
+{
+	Profiler::Get().SetThreadName("Simulation");
+	std::unique_lock<std::mutex> lock(mutex);
+	auto stepTime = steady_clock::now();
+	while (true)
+	{
+		if (parameters.speedFactor <= 0.0f)
+		{
+			wake.wait(lock, [this]() { return stopping || parameters.speedFactor > 0.0f; });
+			// time spent paused is not caught up on
+			stepTime = currentTime = steady_clock::now();
+		}
+		const auto stepReal = duration_cast<steady_clock::duration>(
+			duration<float>(stepSeconds / parameters.speedFactor));
+		stepTime += stepReal;
+		if (wake.wait_until(lock, stepTime, [this]() { return stopping || parameters.speedFactor <= 0.0f; }))
+		{
+			if (stopping)
+			{
+				return;
+			}
+			// paused while waiting, the step starts over once it resumes
+			continue;
+		}
+		const auto now = steady_clock::now();
+		if (now - stepTime > stepReal * maxLagSteps)
+		{
+			stats.stepsSkipped += size_t((now - stepTime) / stepReal);
+			stepTime = now;
+		}
+
+		// previous and current stay readable while the step runs, only this thread ever writes them
+		const Parameters stepParameters = parameters;
+		lock.unlock();
+		const auto start = steady_clock::now();
+		next = current;
+		Advance(next, stepParameters);
+		const float stepMs = duration<float, std::milli>(steady_clock::now() - start).count();
+		lock.lock();
+
+		std::swap(previous, current);
+		std::swap(current, next);
+		currentTime = stepTime;
+		stats.steps++;
+		stats.lastStepMs = stepMs;
+	}
+}
+
+void Simulation::Advance(State& state, const Parameters& parameters) const noexcept
+{
+	PROFILE_ZONE("Simulation::Advance");
+	state.step++;
+
+	state.lightAngle = dx::XMScalarModAngle(state.lightAngle + parameters.lightOrbitSpeed * stepSeconds);
+	state.lightOffset = {
+		parameters.lightOrbitRadius * std::cos(state.lightAngle),
+		0.0f,
+		parameters.lightOrbitRadius * std::sin(state.lightAngle)
+	};
+
+	const size_t crowdSize = (size_t)std::max(parameters.crowdSize, 0);
+	state.crowd.reserve(crowdSize);
+	while (state.crowd.size() < crowdSize)
+	{
+		state.crowd.push_back(SpawnWalker(state.crowd.size()));
+	}
+	state.crowd.resize(crowdSize);
+
+	for (size_t i = 0; i < state.crowd.size(); i++)
+	{
+		auto& walker = state.crowd[i];
+		// circle radius and turn rate are fixed per walker, stepping along the heading traces the circle
+		const std::uint32_t hash = HashWalker(i);
+		const float radius = 1.0f + float(hash & 0xFFu) / 255.0f * 3.0f;
+		const float turnRate = (0.3f + float((hash >> 8u) & 0xFFu) / 255.0f * 0.7f) * ((hash & 0x10000u) ? -1.0f : 1.0f);
+		walker.heading = dx::XMScalarModAngle(walker.heading + turnRate * stepSeconds);
+		const float distance = std::abs(turnRate) * radius * stepSeconds;
+		walker.pos.x += std::sin(walker.heading) * distance;
+		walker.pos.z += std::cos(walker.heading) * distance;
+	}
+}
+
+Simulation::Walker Simulation::SpawnWalker(size_t index) noexcept
+{
+	// the grid the crowd used to stand on
+	constexpr int columns = 8;
+	constexpr float spacing = 12.0f;
+	const int i = int(index);
+	const std::uint32_t hash = HashWalker(index);
+	return {
+		{ float(i % columns - columns / 2) * spacing, 0.0f, float(i / columns + 1) * spacing },
+		float((hash >> 17u) & 0xFFu) / 255.0f * 2.0f * dx::XM_PI - dx::XM_PI
+	};
+}
@@ -0,0 +1,88 @@
+﻿#pragma once
+#include <DirectXMath.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// scene update at a fixed timestep on a thread of its own, so frames can be rendered as fast (or as slow) as they
+// go without changing what gets simulated. the two latest steps are kept and the render thread draws in between
+// them, one step behind the simulation. parameters set from the ui are picked up at the start of the next step,
+// so the same parameter changes at the same steps always play out the same
+class Simulation
+{
+public:
+	struct Parameters
+	{
+		// extra copies of the model, walking circles around their spots on a grid
+		int crowdSize = 0;
+		// simulated seconds per real second, steps stay the same length so it only changes how often they run
+		float speedFactor = 1.0f;
+		// the light circles the position set in its window, a radius of 0 keeps it in place
+		float lightOrbitRadius = 0.0f;
+		float lightOrbitSpeed = 1.0f;
+	};
+	// the scene somewhere between two steps, ready to draw
+	struct Frame
+	{
+		// latest step that went into the frame
+		size_t step = 0u;
+		// how far the frame is from the previous step to that one
+		float alpha = 0.0f;
+		DirectX::XMFLOAT3 lightOffset = {};
+		std::vector<DirectX::XMFLOAT4X4> crowd;
+	};
+	struct Stats
+	{
+		// totals since the simulation started
+		size_t steps;
+		// steps skipped after the thread fell too far behind real time (a debugger break, a stalled machine)
+		size_t stepsSkipped;
+		float lastStepMs;
+	};
+private:
+	struct Walker
+	{
+		DirectX::XMFLOAT3 pos;
+		float heading;
+	};
+	struct State
+	{
+		size_t step = 0u;
+		float lightAngle = 0.0f;
+		DirectX::XMFLOAT3 lightOffset = {};
+		std::vector<Walker> crowd;
+	};
+public:
+	Simulation(float stepSeconds = 1.0f / 60.0f);
+	Simulation(const Simulation&) = delete;
+	Simulation& operator=(const Simulation&) = delete;
+	~Simulation();
+	void SetParameters(const Parameters& parameters);
+	// interpolates the two latest steps by how far real time has got into the current one
+	void Sample(Frame& frame) const;
+	float GetStepSeconds() const noexcept;
+	Stats GetStats() const;
+private:
+	void Run();
+	// the whole simulation, only ever given the same step length
+	void Advance(State& state, const Parameters& parameters) const noexcept;
+	static Walker SpawnWalker(size_t index) noexcept;
+private:
+	// steps the thread may fall behind real time before it stops trying to catch up
+	static constexpr int maxLagSteps = 8;
+	const float stepSeconds;
+	mutable std::mutex mutex;
+	std::condition_variable wake;
+	bool stopping = false;
+	Parameters parameters;
+	Stats stats = {};
+	// previous and current are read by the render thread, next is what the simulation thread writes into
+	State previous;
+	State current;
+	State next;
+	// when current is meant to be reached on the render thread's clock
+	std::chrono::steady_clock::time_point currentTime;
+	std::thread thread;
+};
@@ -0,0 +1,535 @@
+﻿#include "SoftwareRasterizer.h"
+#include "VertexQuantization.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace dx = DirectX;
+
+SoftwareRasterizer::SoftwareRasterizer(unsigned int width, unsigned int height)
+	:
+	width(width),
+	height(height),
+	depthPitch((width + blockSize - 1u) / blockSize * blockSize),
+	tilesX((width + tileSize - 1u) / tileSize),
+	tilesY((height + tileSize - 1u) / tileSize),
+	blocksX(depthPitch / blockSize),
+	target(width, height),
+	depth(size_t(depthPitch) * ((height + blockSize - 1u) / blockSize * blockSize)),
+	blockMaxDepth(size_t(blocksX) * ((height + blockSize - 1u) / blockSize)),
+	bins(size_t(tilesX) * tilesY)
+{
+	BeginFrame({ 255u,0u,0u,0u });
+}
+
+void SoftwareRasterizer::BeginFrame(Surface::Color clearColor) noexcept
+{
+	target.Clear(clearColor);
+	// padding past the right and bottom edge is never drawn, at 0 it can't hold up the block maxima
+	std::fill(depth.begin(), depth.end(), 0.0f);
+	for (unsigned int y = 0; y < height; y++)
+	{
+		std::fill_n(depth.begin() + size_t(y) * depthPitch, width, 1.0f);
+	}
+	std::fill(blockMaxDepth.begin(), blockMaxDepth.end(), 1.0f);
+	draws.clear();
+	triangles.clear();
+	for (auto& b : bins)
+	{
+		b.clear();
+	}
+	stats = {};
+}
+
+void SoftwareRasterizer::DrawSolid(const MeshCache::MeshView& mesh, const Transforms& transforms, DirectX::XMFLOAT4 color)
+{
+	DrawState state = {};
+	state.shader = Shader::Solid;
+	state.color = color;
+	Draw(mesh, transforms, state);
+}
+
+void SoftwareRasterizer::DrawPhong(const MeshCache::MeshView& mesh, const Transforms& transforms, const PhongLight& light,
+	const PhongMaterial& material)
+{
+	DrawState state = {};
+	state.shader = Shader::Phong;
+	state.light = light;
+	state.material = material;
+	Draw(mesh, transforms, state);
+}
+
+void SoftwareRasterizer::Resolve()
+{
+	// a tile is only ever worked on by one thread, so its pixels see triangles in submission order whatever the thread count
+	std::vector<TileStats> tileStats(bins.size());
+	JobSystem::Get().ParallelFor(bins.size(), 1u, [this, &tileStats](size_t begin, size_t end)
+	{
+		for (auto tile = begin; tile < end; tile++)
+		{
+			RasterizeTile((unsigned int)tile, tileStats[tile]);
+		}
+	});
+	for (const auto& s : tileStats)
+	{
+		stats.blocksRasterized += s.blocksRasterized;
+		stats.blocksOccluded += s.blocksOccluded;
+		stats.pixelsShaded += s.pixelsShaded;
+	}
+	draws.clear();
+	triangles.clear();
+	for (auto& b : bins)
+	{
+		b.clear();
+	}
+}
+
+const Surface& SoftwareRasterizer::GetTarget() const noexcept
+{
+	return target;
+}
+
+const SoftwareRasterizer::Stats& SoftwareRasterizer::GetStats() const noexcept
+{
+	return stats;
+}
+
+SoftwareRasterizer::Transforms SoftwareRasterizer::MakeTransforms(DirectX::FXMMATRIX model, DirectX::CXMMATRIX camera,
+	DirectX::CXMMATRIX projection) noexcept
+{
+	const auto modelView = model * camera;
+	return { modelView, modelView * projection };
+}
+
+void SoftwareRasterizer::Draw(const MeshCache::MeshView& mesh, const Transforms& transforms, const DrawState& state)
+{
+	using Dvtx::VertexLayout;
+	namespace dxpv = DirectX::PackedVector;
+
+	// the elements the shader inputs would bind to
+	const VertexLayout::Element* pPosition = nullptr;
+	const VertexLayout::Element* pNormal = nullptr;
+	for (size_t i = 0; i < mesh.layout.GetElementCount(); i++)
+	{
+		const auto& e = mesh.layout.ResolveByIndex(i);
+		switch (e.GetType())
+		{
+		case VertexLayout::Position3D:
+		case VertexLayout::Position3DHalf:
+			pPosition = &e;
+			break;
+		case VertexLayout::Normal:
+		case VertexLayout::NormalOct16:
+			pNormal = &e;
+			break;
+		default:
+			break;
+		}
+	}
+	assert(pPosition && "Mesh has no 3D position element");
+	assert((state.shader != Shader::Phong || pNormal) && "Phong shading needs a normal element");
+
+	// vertex shader
+	const size_t stride = mesh.layout.Size();
+	std::vector<ShadedVertex> vertices(mesh.vertexBytes / stride);
+	JobSystem::Get().ParallelFor(vertices.size(), 4096u, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			const char* pVertex = mesh.pVertices + i * stride;
+			auto pos = pPosition->GetType() == VertexLayout::Position3D ?
+				dx::XMLoadFloat3(reinterpret_cast<const dx::XMFLOAT3*>(pVertex + pPosition->GetOffset())) :
+				dxpv::XMLoadHalf4(reinterpret_cast<const dxpv::XMHALF4*>(pVertex + pPosition->GetOffset()));
+			pos = dx::XMVectorSetW(pos, 1.0f);
+			auto& v = vertices[i];
+			dx::XMStoreFloat4(&v.clip, dx::XMVector4Transform(pos, transforms.modelViewProjection));
+			if (state.shader == Shader::Phong)
+			{
+				const auto normal = pNormal->GetType() == VertexLayout::Normal ?
+					dx::XMLoadFloat3(reinterpret_cast<const dx::XMFLOAT3*>(pVertex + pNormal->GetOffset())) :
+					Dvtx::DecodeOctNormal(*reinterpret_cast<const dxpv::XMSHORTN2*>(pVertex + pNormal->GetOffset()));
+				dx::XMStoreFloat3(&v.varyings[0], dx::XMVector4Transform(pos, transforms.modelView));
+				dx::XMStoreFloat3(&v.varyings[1], dx::XMVector3TransformNormal(normal, transforms.modelView));
+			}
+			else
+			{
+				v.varyings[0] = v.varyings[1] = { 0.0f,0.0f,0.0f };
+			}
+		}
+	});
+
+	// clipping and setup in chunks of triangles
+	const auto draw = (unsigned int)draws.size();
+	draws.push_back(state);
+	const auto index = [&mesh](size_t i) -> size_t
+	{
+		return mesh.indexSize == 2u ? static_cast<const std::uint16_t*>(mesh.pIndices)[i] :
+			static_cast<const std::uint32_t*>(mesh.pIndices)[i];
+	};
+	constexpr size_t trianglesPerChunk = 1024u;
+	const size_t triangleCount = mesh.indexCount / 3u;
+	std::vector<std::vector<Triangle>> chunkTriangles((triangleCount + trianglesPerChunk - 1u) / trianglesPerChunk);
+	std::vector<Stats> chunkStats(chunkTriangles.size());
+	JobSystem::Get().ParallelFor(triangleCount, trianglesPerChunk, [&](size_t begin, size_t end)
+	{
+		const auto chunk = begin / trianglesPerChunk;
+		for (size_t i = begin; i < end; i++)
+		{
+			assert(index(i * 3u) < vertices.size() && index(i * 3u + 1u) < vertices.size() && index(i * 3u + 2u) < vertices.size());
+			SetupTriangle(vertices[index(i * 3u)], vertices[index(i * 3u + 1u)], vertices[index(i * 3u + 2u)], draw,
+				chunkTriangles[chunk], chunkStats[chunk]);
+		}
+	});
+
+	// binning stays serial so every bin lists its triangles in submission order
+	for (size_t c = 0; c < chunkTriangles.size(); c++)
+	{
+		stats.triangles += chunkStats[c].triangles;
+		stats.trianglesCulled += chunkStats[c].trianglesCulled;
+		stats.trianglesClipped += chunkStats[c].trianglesClipped;
+		for (const auto& t : chunkTriangles[c])
+		{
+			const auto triangle = (unsigned int)triangles.size();
+			for (int ty = t.minY / tileSize; ty <= t.maxY / tileSize; ty++)
+			{
+				for (int tx = t.minX / tileSize; tx <= t.maxX / tileSize; tx++)
+				{
+					bins[size_t(ty) * tilesX + tx].push_back(triangle);
+					stats.binnedTriangles++;
+				}
+			}
+			triangles.push_back(t);
+		}
+	}
+}
+
+void SoftwareRasterizer::SetupTriangle(const ShadedVertex& v0, const ShadedVertex& v1, const ShadedVertex& v2, unsigned int draw,
+	std::vector<Triangle>& out, Stats& counts) const noexcept
+{
+	counts.triangles++;
+	// trivially outside when all three vertices are beyond the same frustum plane
+	const auto outside = [&v0, &v1, &v2](auto beyond)
+	{
+		return beyond(v0.clip) && beyond(v1.clip) && beyond(v2.clip);
+	};
+	if (outside([](const dx::XMFLOAT4& c) { return c.x > c.w; }) || outside([](const dx::XMFLOAT4& c) { return c.x < -c.w; }) ||
+		outside([](const dx::XMFLOAT4& c) { return c.y > c.w; }) || outside([](const dx::XMFLOAT4& c) { return c.y < -c.w; }) ||
+		outside([](const dx::XMFLOAT4& c) { return c.z > c.w; }) || outside([](const dx::XMFLOAT4& c) { return c.z < 0.0f; }))
+	{
+		counts.trianglesCulled++;
+		return;
+	}
+	if (v0.clip.z >= 0.0f && v1.clip.z >= 0.0f && v2.clip.z >= 0.0f)
+	{
+		if (!EmitTriangle(v0, v1, v2, draw, out))
+		{
+			counts.trianglesCulled++;
+		}
+		return;
+	}
+
+	// clip against z = 0, everything is linear in clip space so varyings are lerped along with the position
+	const auto lerp = [](const ShadedVertex& a, const ShadedVertex& b, float t)
+	{
+		ShadedVertex v;
+		dx::XMStoreFloat4(&v.clip, dx::XMVectorLerp(dx::XMLoadFloat4(&a.clip), dx::XMLoadFloat4(&b.clip), t));
+		for (int i = 0; i < 2; i++)
+		{
+			dx::XMStoreFloat3(&v.varyings[i], dx::XMVectorLerp(dx::XMLoadFloat3(&a.varyings[i]), dx::XMLoadFloat3(&b.varyings[i]), t));
+		}
+		return v;
+	};
+	const ShadedVertex* pIn[3] = { &v0,&v1,&v2 };
+	ShadedVertex polygon[4];
+	int count = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		const auto& a = *pIn[i];
+		const auto& b = *pIn[(i + 1) % 3];
+		if (a.clip.z >= 0.0f)
+		{
+			polygon[count++] = a;
+		}
+		if ((a.clip.z >= 0.0f) != (b.clip.z >= 0.0f))
+		{
+			polygon[count++] = lerp(a, b, a.clip.z / (a.clip.z - b.clip.z));
+		}
+	}
+	counts.trianglesClipped++;
+	bool emitted = false;
+	for (int i = 1; i + 1 < count; i++)
+	{
+		emitted |= EmitTriangle(polygon[0], polygon[i], polygon[i + 1], draw, out);
+	}
+	if (!emitted)
+	{
+		counts.trianglesCulled++;
+	}
+}
+
+bool SoftwareRasterizer::EmitTriangle(const ShadedVertex& v0, const ShadedVertex& v1, const ShadedVertex& v2, unsigned int draw,
+	std::vector<Triangle>& out) const noexcept
+{
+	const ShadedVertex* pV[3] = { &v0,&v1,&v2 };
+	float x[3];
+	float y[3];
+	float z[3];
+	float invW[3];
+	for (int i = 0; i < 3; i++)
+	{
+		const auto& c = pV[i]->clip;
+		invW[i] = 1.0f / c.w;
+		// viewport transform, snapped to 1/256 of a pixel like d3d does
+		x[i] = std::round((c.x * invW[i] * 0.5f + 0.5f) * float(width) * 256.0f) / 256.0f;
+		y[i] = std::round((-c.y * invW[i] * 0.5f + 0.5f) * float(height) * 256.0f) / 256.0f;
+		z[i] = c.z * invW[i];
+	}
+	// y points down, so positive area is clockwise on screen: the front faces
+	const float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+	if (!(area > 0.0f))
+	{
+		return false;
+	}
+
+	Triangle t;
+	// pixels whose centers lie inside the bounds, clamped to the target
+	const auto minOf = [](const float (&v)[3]) { return std::min(std::min(v[0], v[1]), v[2]); };
+	const auto maxOf = [](const float (&v)[3]) { return std::max(std::max(v[0], v[1]), v[2]); };
+	t.minX = int(std::min(std::max(std::ceil(minOf(x) - 0.5f), 0.0f), float(width)));
+	t.minY = int(std::min(std::max(std::ceil(minOf(y) - 0.5f), 0.0f), float(height)));
+	t.maxX = int(std::max(std::min(std::floor(maxOf(x) - 0.5f), float(width - 1u)), -1.0f));
+	t.maxY = int(std::max(std::min(std::floor(maxOf(y) - 0.5f), float(height - 1u)), -1.0f));
+	if (t.minX > t.maxX || t.minY > t.maxY)
+	{
+		return false;
+	}
+
+	for (int i = 0; i < 3; i++)
+	{
+		const int j = (i + 1) % 3;
+		const int k = (i + 2) % 3;
+		const float a = y[j] - y[k];
+		const float b = x[k] - x[j];
+		// anchored at the upper of the two vertices, so the neighbour sharing the edge gets exactly the negated function
+		const int o = (y[j] < y[k] || (y[j] == y[k] && x[j] < x[k])) ? j : k;
+		t.edgeA[i] = a;
+		t.edgeB[i] = b;
+		t.edgeC[i] = -(a * x[o] + b * y[o]);
+		// left edges run up, top edges run right along a horizontal
+		t.edgeInclusive[i] = (a > 0.0f || (a == 0.0f && b > 0.0f)) ? ~0u : 0u;
+	}
+
+	// gradients from the edge functions (their sum is the area), anchored at the first vertex
+	const float invArea = 1.0f / area;
+	const auto makePlane = [&t, &x, &y, invArea](const float (&v)[3], float (&plane)[3])
+	{
+		plane[0] = (t.edgeA[0] * v[0] + t.edgeA[1] * v[1] + t.edgeA[2] * v[2]) * invArea;
+		plane[1] = (t.edgeB[0] * v[0] + t.edgeB[1] * v[1] + t.edgeB[2] * v[2]) * invArea;
+		plane[2] = v[0] - plane[0] * x[0] - plane[1] * y[0];
+	};
+	makePlane(z, t.zPlane);
+	t.zMin = minOf(z);
+	makePlane(invW, t.invWPlane);
+	for (int i = 0; i < 2; i++)
+	{
+		float plane[3][3];
+		for (int c = 0; c < 3; c++)
+		{
+			const float v[3] = {
+				(&v0.varyings[i].x)[c] * invW[0],
+				(&v1.varyings[i].x)[c] * invW[1],
+				(&v2.varyings[i].x)[c] * invW[2],
+			};
+			makePlane(v, plane[c]);
+		}
+		for (int p = 0; p < 3; p++)
+		{
+			t.varyingPlanes[i][p] = { plane[0][p],plane[1][p],plane[2][p] };
+		}
+	}
+	t.draw = draw;
+	out.push_back(t);
+	return true;
+}
+
+void SoftwareRasterizer::RasterizeTile(unsigned int tile, TileStats& tileStats) noexcept
+{
+	const int tileX = int(tile % tilesX) * tileSize;
+	const int tileY = int(tile / tilesX) * tileSize;
+	for (const auto index : bins[tile])
+	{
+		const auto& t = triangles[index];
+		const int blockX0 = std::max(t.minX, tileX) / blockSize;
+		const int blockX1 = std::min(t.maxX, tileX + tileSize - 1) / blockSize;
+		const int blockY0 = std::max(t.minY, tileY) / blockSize;
+		const int blockY1 = std::min(t.maxY, tileY + tileSize - 1) / blockSize;
+		for (int by = blockY0; by <= blockY1; by++)
+		{
+			for (int bx = blockX0; bx <= blockX1; bx++)
+			{
+				RasterizeBlock(t, bx, by, tileStats);
+			}
+		}
+	}
+}
+
+void SoftwareRasterizer::RasterizeBlock(const Triangle& t, int blockX, int blockY, TileStats& tileStats) noexcept
+{
+	const int x0 = blockX * blockSize;
+	const int y0 = blockY * blockSize;
+	// the block is empty if it lies entirely outside one edge, tested at the corner farthest inside
+	for (int i = 0; i < 3; i++)
+	{
+		const float cx = float(t.edgeA[i] >= 0.0f ? x0 + blockSize : x0);
+		const float cy = float(t.edgeB[i] >= 0.0f ? y0 + blockSize : y0);
+		if (t.edgeA[i] * cx + t.edgeB[i] * cy + t.edgeC[i] < 0.0f)
+		{
+			return;
+		}
+	}
+	// hierarchical depth: the nearest the triangle gets inside the block against the farthest already there
+	float& blockMax = blockMaxDepth[size_t(blockY) * blocksX + blockX];
+	{
+		const float cx = float(t.zPlane[0] >= 0.0f ? x0 : x0 + blockSize);
+		const float cy = float(t.zPlane[1] >= 0.0f ? y0 : y0 + blockSize);
+		const float zNear = std::max(t.zPlane[0] * cx + t.zPlane[1] * cy + t.zPlane[2], t.zMin);
+		if (zNear >= blockMax)
+		{
+			tileStats.blocksOccluded++;
+			return;
+		}
+	}
+	tileStats.blocksRasterized++;
+
+	const auto& state = draws[t.draw];
+	const auto zero = dx::XMVectorZero();
+	const auto laneCenters = dx::XMVectorSet(0.5f, 1.5f, 2.5f, 3.5f);
+	const auto right = dx::XMVectorReplicate(float(width));
+	dx::XMVECTOR edgeA[3];
+	dx::XMVECTOR inclusive[3];
+	for (int i = 0; i < 3; i++)
+	{
+		edgeA[i] = dx::XMVectorReplicate(t.edgeA[i]);
+		inclusive[i] = dx::XMVectorReplicateInt(t.edgeInclusive[i]);
+	}
+	const auto zA = dx::XMVectorReplicate(t.zPlane[0]);
+	Surface::Color* const pColor = target.GetBufferPtr();
+	bool wrote = false;
+
+	// 4 pixels at a time
+	const int rowEnd = std::min(y0 + blockSize - 1, t.maxY);
+	for (int y = std::max(y0, t.minY); y <= rowEnd; y++)
+	{
+		const float py = float(y) + 0.5f;
+		float* const pDepthRow = depth.data() + size_t(y) * depthPitch;
+		for (int qx = x0; qx < x0 + blockSize; qx += 4)
+		{
+			if (qx > t.maxX || qx + 3 < t.minX)
+			{
+				continue;
+			}
+			const auto px = dx::XMVectorAdd(dx::XMVectorReplicate(float(qx)), laneCenters);
+			auto mask = dx::XMVectorLess(px, right);
+			for (int i = 0; i < 3; i++)
+			{
+				const auto e = dx::XMVectorMultiplyAdd(edgeA[i], px, dx::XMVectorReplicate(t.edgeB[i] * py + t.edgeC[i]));
+				// inside, or exactly on an edge that owns its pixels
+				mask = dx::XMVectorAndInt(mask, dx::XMVectorOrInt(dx::XMVectorGreater(e, zero),
+					dx::XMVectorAndInt(dx::XMVectorEqual(e, zero), inclusive[i])));
+			}
+			if (dx::XMVector4EqualInt(mask, zero))
+			{
+				continue;
+			}
+			const auto z = dx::XMVectorMultiplyAdd(zA, px, dx::XMVectorReplicate(t.zPlane[1] * py + t.zPlane[2]));
+			const auto pDepth = reinterpret_cast<dx::XMFLOAT4*>(pDepthRow + qx);
+			const auto stored = dx::XMLoadFloat4(pDepth);
+			// depth test less, which also drops anything past the far plane since depth starts at 1
+			mask = dx::XMVectorAndInt(mask, dx::XMVectorLess(z, stored));
+			if (dx::XMVector4EqualInt(mask, zero))
+			{
+				continue;
+			}
+			dx::XMStoreFloat4(pDepth, dx::XMVectorSelect(stored, z, mask));
+			wrote = true;
+
+			std::uint32_t lanes[4];
+			dx::XMStoreInt4(lanes, mask);
+			for (int lane = 0; lane < 4; lane++)
+			{
+				if (lanes[lane])
+				{
+					Shade(t, state, qx + lane, y, pColor[size_t(y) * width + qx + lane]);
+					tileStats.pixelsShaded++;
+				}
+			}
+		}
+	}
+
+	if (wrote)
+	{
+		auto farthest = zero;
+		for (int y = y0; y < y0 + blockSize; y++)
+		{
+			const float* pRow = depth.data() + size_t(y) * depthPitch + x0;
+			for (int x = 0; x < blockSize; x += 4)
+			{
+				farthest = dx::XMVectorMax(farthest, dx::XMLoadFloat4(reinterpret_cast<const dx::XMFLOAT4*>(pRow + x)));
+			}
+		}
+		dx::XMFLOAT4 f;
+		dx::XMStoreFloat4(&f, farthest);
+		blockMax = std::max(std::max(f.x, f.y), std::max(f.z, f.w));
+	}
+}
+
+void SoftwareRasterizer::Shade(const Triangle& t, const DrawState& state, int x, int y, Surface::Color& out) const noexcept
+{
+	dx::XMVECTOR color;
+	if (state.shader == Shader::Solid)
+	{
+		// SolidPS.hlsl
+		color = dx::XMLoadFloat4(&state.color);
+	}
+	else
+	{
+		// perspective correct varyings: varying / w and 1 / w are linear on screen
+		const auto px = dx::XMVectorReplicate(float(x) + 0.5f);
+		const auto py = dx::XMVectorReplicate(float(y) + 0.5f);
+		const float w = 1.0f / (t.invWPlane[0] * (float(x) + 0.5f) + t.invWPlane[1] * (float(y) + 0.5f) + t.invWPlane[2]);
+		const auto varying = [&t, px, py, w](int i)
+		{
+			const auto& plane = t.varyingPlanes[i];
+			return dx::XMVectorScale(dx::XMVectorMultiplyAdd(dx::XMLoadFloat3(&plane[0]), px,
+				dx::XMVectorMultiplyAdd(dx::XMLoadFloat3(&plane[1]), py, dx::XMLoadFloat3(&plane[2]))), w);
+		};
+		const auto worldPos = varying(0);
+		const auto n = varying(1);
+
+		// PhongPS.hlsl
+		const auto& light = state.light;
+		const auto& material = state.material;
+		const auto vecToLight = dx::XMVectorSubtract(dx::XMLoadFloat3(&light.pos), worldPos);
+		const float distToLight = dx::XMVectorGetX(dx::XMVector3Length(vecToLight));
+		const auto dirToLight = dx::XMVectorScale(vecToLight, 1.0f / distToLight);
+		const float atten = 1.0f / (light.attConst + light.attLin + light.attQuad * (distToLight * distToLight));
+		const auto lightColor = dx::XMVectorScale(dx::XMLoadFloat3(&light.diffuseColor), light.diffuseIntensity);
+		const auto diffuse = dx::XMVectorScale(lightColor,
+			atten * std::max(0.0f, dx::XMVectorGetX(dx::XMVector3Dot(dirToLight, n))));
+		const auto projected = dx::XMVectorScale(n, dx::XMVectorGetX(dx::XMVector3Dot(vecToLight, n)));
+		const auto r = dx::XMVectorSubtract(dx::XMVectorScale(projected, 2.0f), vecToLight);
+		const float specularAngle = std::max(0.0f, dx::XMVectorGetX(
+			dx::XMVector3Dot(dx::XMVector3Normalize(dx::XMVectorNegate(r)), dx::XMVector3Normalize(worldPos))));
+		const auto specular = dx::XMVectorScale(lightColor,
+			atten * material.specularIntensity * std::pow(specularAngle, material.specularPower));
+		color = dx::XMVectorMultiply(
+			dx::XMVectorSaturate(dx::XMVectorAdd(dx::XMVectorAdd(diffuse, dx::XMLoadFloat3(&light.ambient)), specular)),
+			dx::XMLoadFloat3(&material.color));
+		color = dx::XMVectorSetW(color, 1.0f);
+	}
+	// unorm conversion, rounded to nearest
+	dx::XMFLOAT4 c;
+	dx::XMStoreFloat4(&c, dx::XMVectorMultiplyAdd(dx::XMVectorSaturate(color), dx::XMVectorReplicate(255.0f), dx::XMVectorReplicate(0.5f)));
+	out = { (unsigned char)c.w,(unsigned char)c.x,(unsigned char)c.y,(unsigned char)c.z };
+}
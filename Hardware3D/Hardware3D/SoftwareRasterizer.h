@@ -0,0 +1,145 @@
+﻿#pragma once
+#include "Surface.h"
+#include "MeshCache.h"
+#include <DirectXMath.h>
+#include <vector>
+
+// draws meshes on the cpu into a Surface, for reference images without a gpu and as a cpu throughput benchmark
+// takes the same data the gpu path gets: vertex / index data of a mesh, the matrices TransformCbuf uploads and the
+// constants of the Phong and Solid shaders, whose math is ported one to one
+// Draw runs the vertex shader, clips, sets up and bins triangles into screen tiles, Resolve rasterizes the tiles
+// in parallel. fixed function state matches Graphics: back faces culled (clockwise is front), depth test less
+class SoftwareRasterizer
+{
+public:
+	// what TransformCbuf uploads, untransposed
+	struct Transforms
+	{
+		DirectX::XMMATRIX modelView;
+		DirectX::XMMATRIX modelViewProjection;
+	};
+	// PhongPS light constants, position in view space (what PointLight::Bind uploads)
+	struct PhongLight
+	{
+		DirectX::XMFLOAT3 pos;
+		DirectX::XMFLOAT3 ambient;
+		DirectX::XMFLOAT3 diffuseColor;
+		float diffuseIntensity;
+		float attConst;
+		float attLin;
+		float attQuad;
+	};
+	// PhongPS material constants
+	struct PhongMaterial
+	{
+		DirectX::XMFLOAT3 color;
+		float specularIntensity;
+		float specularPower;
+	};
+	struct Stats
+	{
+		size_t triangles = 0u;
+		// back facing, degenerate or outside the view
+		size_t trianglesCulled = 0u;
+		// crossing the near plane, each one comes out as one or two triangles
+		size_t trianglesClipped = 0u;
+		// triangle / tile pairs
+		size_t binnedTriangles = 0u;
+		// 8x8 pixel blocks whose pixels got tested
+		size_t blocksRasterized = 0u;
+		// blocks skipped because the hierarchical depth showed the triangle behind everything there
+		size_t blocksOccluded = 0u;
+		// passed the depth test, overdraw counts every time
+		size_t pixelsShaded = 0u;
+	};
+public:
+	SoftwareRasterizer(unsigned int width, unsigned int height);
+	// clears the target and depth (to 1) and forgets anything not resolved yet
+	void BeginFrame(Surface::Color clearColor) noexcept;
+	// SolidVS / SolidPS, only the position element of the mesh is read
+	void DrawSolid(const MeshCache::MeshView& mesh, const Transforms& transforms, DirectX::XMFLOAT4 color);
+	// PhongVS / PhongOctVS (picked by the normal element like the gpu path does) with PhongPS
+	void DrawPhong(const MeshCache::MeshView& mesh, const Transforms& transforms, const PhongLight& light,
+		const PhongMaterial& material);
+	// rasterizes everything drawn since the last resolve in submission order, tiles are spread over threads
+	void Resolve();
+	const Surface& GetTarget() const noexcept;
+	const Stats& GetStats() const noexcept;
+	// the same products TransformCbuf makes
+	static Transforms MakeTransforms(DirectX::FXMMATRIX model, DirectX::CXMMATRIX camera, DirectX::CXMMATRIX projection) noexcept;
+private:
+	enum class Shader
+	{
+		Solid,
+		Phong,
+	};
+	struct DrawState
+	{
+		Shader shader;
+		DirectX::XMFLOAT4 color;
+		PhongLight light;
+		PhongMaterial material;
+	};
+	// vertex shader output, varyings are the phong view space position and normal
+	struct ShadedVertex
+	{
+		DirectX::XMFLOAT4 clip;
+		DirectX::XMFLOAT3 varyings[2];
+	};
+	// everything in pixel space, planes are value = a * x + b * y + c at pixel centers
+	struct Triangle
+	{
+		// edge functions, positive inside
+		float edgeA[3];
+		float edgeB[3];
+		float edgeC[3];
+		// all bits set for top and left edges, which own the pixels exactly on them
+		unsigned int edgeInclusive[3];
+		float zPlane[3];
+		float zMin;
+		float invWPlane[3];
+		// varyings over w
+		DirectX::XMFLOAT3 varyingPlanes[2][3];
+		int minX;
+		int minY;
+		int maxX;
+		int maxY;
+		unsigned int draw;
+	};
+	struct TileStats
+	{
+		size_t blocksRasterized = 0u;
+		size_t blocksOccluded = 0u;
+		size_t pixelsShaded = 0u;
+	};
+private:
+	void Draw(const MeshCache::MeshView& mesh, const Transforms& transforms, const DrawState& state);
+	// culling and near plane clipping of one triangle, appends zero to two triangles and counts into counts
+	void SetupTriangle(const ShadedVertex& v0, const ShadedVertex& v1, const ShadedVertex& v2, unsigned int draw,
+		std::vector<Triangle>& out, Stats& counts) const noexcept;
+	// viewport transform and plane setup, false for back facing triangles and those between pixel centers
+	bool EmitTriangle(const ShadedVertex& v0, const ShadedVertex& v1, const ShadedVertex& v2, unsigned int draw,
+		std::vector<Triangle>& out) const noexcept;
+	void RasterizeTile(unsigned int tile, TileStats& stats) noexcept;
+	void RasterizeBlock(const Triangle& t, int blockX, int blockY, TileStats& stats) noexcept;
+	void Shade(const Triangle& t, const DrawState& state, int x, int y, Surface::Color& out) const noexcept;
+private:
+	static constexpr int tileSize = 64;
+	static constexpr int blockSize = 8;
+	unsigned int width;
+	unsigned int height;
+	// depth rows are padded out to whole blocks
+	unsigned int depthPitch;
+	unsigned int tilesX;
+	unsigned int tilesY;
+	unsigned int blocksX;
+	Surface target;
+	std::vector<float> depth;
+	// farthest depth in each 8x8 block
+	std::vector<float> blockMaxDepth;
+	std::vector<DrawState> draws;
+	std::vector<Triangle> triangles;
+	// triangle indices per tile in submission order
+	std::vector<std::vector<unsigned int>> bins;
+	Stats stats;
+};
@@ -0,0 +1,14 @@
+cbuffer ViewCBuf
+{
+	matrix view;
+	matrix projection;
+}
+
+// model transform arrives per instance, one row per element (Bind::InstanceBuffer)
+float4 main( float3 pos : Position,
+	float4 row0 : InstanceTransform0, float4 row1 : InstanceTransform1,
+	float4 row2 : InstanceTransform2, float4 row3 : InstanceTransform3 ) : SV_POSITION
+{
+	const float4 viewPos = mul(mul(float4(pos, 1.0f), float4x4(row0, row1, row2, row3)), view);
+	return mul(viewPos, projection);
+}
\ No newline at end of file
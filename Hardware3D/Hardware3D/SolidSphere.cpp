@@ -2,6 +2,7 @@
 #include "BindableCommon.h"
 #include "GraphicsErrorMacros.h"
 #include "Sphere.h"
+#include "InstanceBuffer.h"
 
 SolidSphere::SolidSphere(Graphics& gfx, float radius)
 {
@@ -10,10 +11,12 @@ SolidSphere::SolidSphere(Graphics& gfx, float radius)
 
 	if (!IsStaticInitialized())
 	{
+		using Layout = Dvtx::StaticLayout<Dvtx::VertexLayout::Position3D>;
 		struct Vertex
 		{
 			dx::XMFLOAT3 pos;
 		};
+		static_assert(sizeof(Vertex) == Layout::stride, "Vertex struct doesn't match its layout");
 
 		auto model = Sphere::Make<Vertex>();
 		model.Transform(dx::XMMatrixScaling(radius, radius, radius));
@@ -32,13 +35,13 @@ SolidSphere::SolidSphere(Graphics& gfx, float radius)
 			float padding;
 		} colorConst;
 
-		AddStaticBind(std::make_unique<PixelConstantBuffer<PSColorConstant>>(gfx, colorConst));
+		// slot 0 belongs to the point light, which has to stay bound whatever order the queue draws in
+		AddStaticBind(std::make_unique<PixelConstantBuffer<PSColorConstant>>(gfx, colorConst, 1u));
 
-		const std::vector<D3D11_INPUT_ELEMENT_DESC> inElemDesc =
-		{
-			{"Position", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
-		};
-		AddStaticBind(std::make_unique<InputLayout>(gfx, inElemDesc, pvsbc));
+		AddStaticBind(std::make_unique<InputLayout>(gfx, Layout::desc.data(), Layout::desc.size(), pvsbc));
+
+		SetStaticInstancedBinds(std::make_shared<InstancedBinds>(gfx, L"SolidInstancedVS.cso",
+			Layout::desc.data(), Layout::desc.size()));
 
 		AddStaticBind(std::make_unique<Topology>(gfx, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST));
 	}
@@ -47,7 +50,9 @@ SolidSphere::SolidSphere(Graphics& gfx, float radius)
 		SetIndexFromStatic();
 	}
 
+	SetInstancedFromStatic();
 	AddBind(std::make_unique<TransformCbuf>(gfx, *this));
+	SetPos({ 1.0f, 1.0f, 1.0f });
 }
 
 void SolidSphere::Update(float dt) noexcept
@@ -56,10 +61,22 @@ void SolidSphere::Update(float dt) noexcept
 
 void SolidSphere::SetPos(DirectX::XMFLOAT3 pos) noexcept
 {
-	this->pos = pos;
+	DirectX::XMStoreFloat4x4(&transform, DirectX::XMMatrixTranslation(pos.x, pos.y, pos.z));
+}
+
+void SolidSphere::Draw(Graphics& gfx, DirectX::FXMMATRIX transform) const noxnd
+{
+	DirectX::XMStoreFloat4x4(&this->transform, transform);
+	Drawable::Draw(gfx);
+}
+
+void SolidSphere::Stage(Graphics& gfx, DirectX::FXMMATRIX transform) const
+{
+	DirectX::XMStoreFloat4x4(&this->transform, transform);
+	Drawable::Stage(gfx);
 }
 
 DirectX::XMMATRIX SolidSphere::GetTransformXM() const noexcept
 {
-	return DirectX::XMMatrixTranslation(pos.x, pos.y, pos.z);
+	return DirectX::XMLoadFloat4x4(&transform);
 }
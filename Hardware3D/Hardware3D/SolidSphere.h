@@ -7,7 +7,10 @@ public:
 	SolidSphere(Graphics& gfx, float radius);
 	void Update(float dt) noexcept override;
 	void SetPos(DirectX::XMFLOAT3 pos) noexcept;
+	// the sphere can be queued several times per frame, each draw uses the transform of its packet
+	void Draw(Graphics& gfx, DirectX::FXMMATRIX transform) const noxnd override;
+	void Stage(Graphics& gfx, DirectX::FXMMATRIX transform) const override;
 	DirectX::XMMATRIX GetTransformXM() const noexcept override;
 private:
-	DirectX::XMFLOAT3 pos = { 1.0f, 1.0f, 1.0f };
+	mutable DirectX::XMFLOAT4X4 transform;
 };
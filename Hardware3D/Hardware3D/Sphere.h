@@ -41,19 +41,19 @@ public:
 		}
 
 		// add the cap vertices
-		const auto iNorthPole = (unsigned short)vertices.size();
+		const auto iNorthPole = (unsigned int)vertices.size();
 		vertices.emplace_back();
 		dx::XMStoreFloat3(&vertices.back().pos, base);
-		const auto iSouthPole = (unsigned short)vertices.size();
+		const auto iSouthPole = (unsigned int)vertices.size();
 		vertices.emplace_back();
 		dx::XMStoreFloat3(&vertices.back().pos, dx::XMVectorNegate(base));
 
-		const auto calcIdx = [latDiv, longDiv](unsigned short iLat, unsigned short iLong)
-		{ return iLat * longDiv + iLong; };
-		std::vector<unsigned short> indices;
-		for (unsigned short iLat = 0; iLat < latDiv - 2; iLat++)
+		const auto calcIdx = [latDiv, longDiv](int iLat, int iLong)
+		{ return (unsigned int)(iLat * longDiv + iLong); };
+		std::vector<unsigned int> indices;
+		for (int iLat = 0; iLat < latDiv - 2; iLat++)
 		{
-			for (unsigned short iLong = 0; iLong < longDiv - 1; iLong++)
+			for (int iLong = 0; iLong < longDiv - 1; iLong++)
 			{
 				indices.push_back(calcIdx(iLat, iLong));
 				indices.push_back(calcIdx(iLat + 1, iLong));
@@ -72,7 +72,7 @@ public:
 		}
 
 		// cap fans
-		for (unsigned short iLong = 0; iLong < longDiv - 1; iLong++)
+		for (int iLong = 0; iLong < longDiv - 1; iLong++)
 		{
 			// north
 			indices.push_back(iNorthPole);
@@ -0,0 +1,140 @@
+﻿#include "StreamedTexture.h"
+#include "Surface.h"
+#include "GraphicsErrorMacros.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Bind
+{
+	namespace wrl = Microsoft::WRL;
+
+	StreamedTexture::StreamedTexture(Source source, UINT slot) noexcept
+		:
+		source(std::move(source)),
+		slot(slot)
+	{
+	}
+
+	void StreamedTexture::Bind(Graphics& gfx) noexcept
+	{
+		GetContext(gfx)->PSSetShaderResources(slot, 1u, pTextureView.GetAddressOf());
+	}
+
+	void StreamedTexture::RequestScreenSize(float pixels) noexcept
+	{
+		requestedPixels = std::max(requestedPixels, pixels);
+	}
+
+	unsigned int StreamedTexture::GetWidth() const noexcept
+	{
+		return width;
+	}
+
+	unsigned int StreamedTexture::GetHeight() const noexcept
+	{
+		return height;
+	}
+
+	unsigned int StreamedTexture::GetLevelCount() const noexcept
+	{
+		return levelCount;
+	}
+
+	unsigned int StreamedTexture::GetResidentLevel() const noexcept
+	{
+		return residentLevel;
+	}
+
+	size_t StreamedTexture::GetResidentBytes() const noexcept
+	{
+		return GetBytes(residentLevel, levelCount);
+	}
+
+	ID3D11ShaderResourceView* StreamedTexture::GetView() const noexcept
+	{
+		return pTextureView.Get();
+	}
+
+	unsigned int StreamedTexture::GetLevelForSize(float pixels) const noexcept
+	{
+		const float texels = float(std::max(width, height));
+		if (pixels >= texels)
+		{
+			return 0u;
+		}
+		const auto level = (unsigned int)std::floor(std::log2(texels / std::max(pixels, 1.0f)));
+		return std::min(level, levelCount - 1u);
+	}
+
+	unsigned int StreamedTexture::GetTailLevel(unsigned int width, unsigned int height) noexcept
+	{
+		unsigned int level = 0u;
+		while (std::max(width >> level, height >> level) > tailSize)
+		{
+			level++;
+		}
+		return level;
+	}
+
+	size_t StreamedTexture::GetBytes(unsigned int first, unsigned int last) const noexcept
+	{
+		size_t bytes = 0u;
+		for (unsigned int i = first; i < last; i++)
+		{
+			bytes += size_t(std::max(width >> i, 1u)) * std::max(height >> i, 1u) * sizeof(Surface::Color);
+		}
+		return bytes;
+	}
+
+	void StreamedTexture::Upload(Graphics& gfx, unsigned int top, const std::vector<Surface>& levels)
+	{
+		std::vector<D3D11_SUBRESOURCE_DATA> subData(levels.size());
+		for (size_t i = 0; i < levels.size(); i++)
+		{
+			subData[i].pSysMem = levels[i].GetBufferPtrConst();
+			subData[i].SysMemPitch = levels[i].GetWidth() * sizeof(Surface::Color);
+		}
+		pTexture = CreateChain(gfx, top, subData.data());
+		residentLevel = top;
+	}
+
+	void StreamedTexture::Evict(Graphics& gfx, unsigned int top)
+	{
+		auto pChain = CreateChain(gfx, top, nullptr);
+		for (unsigned int i = top; i < levelCount; i++)
+		{
+			GetContext(gfx)->CopySubresourceRegion(pChain.Get(), i - top, 0u, 0u, 0u, pTexture.Get(), i - residentLevel, nullptr);
+		}
+		pTexture = std::move(pChain);
+		residentLevel = top;
+	}
+
+	wrl::ComPtr<ID3D11Texture2D> StreamedTexture::CreateChain(Graphics& gfx, unsigned int top, const D3D11_SUBRESOURCE_DATA* pInitialData)
+	{
+		INFOMAN(gfx);
+
+		D3D11_TEXTURE2D_DESC textureDesc = {};
+		textureDesc.Width = std::max(width >> top, 1u);
+		textureDesc.Height = std::max(height >> top, 1u);
+		textureDesc.MipLevels = levelCount - top;
+		textureDesc.ArraySize = 1;
+		textureDesc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+		textureDesc.SampleDesc.Count = 1;
+		textureDesc.SampleDesc.Quality = 0;
+		textureDesc.Usage = D3D11_USAGE_DEFAULT;
+		textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		textureDesc.CPUAccessFlags = 0;
+		textureDesc.MiscFlags = 0;
+		wrl::ComPtr<ID3D11Texture2D> pChain;
+		GFX_THROW_INFO(GetDevice(gfx)->CreateTexture2D(&textureDesc, pInitialData, &pChain));
+
+		// the view is swapped along with the texture, whatever was bound before stays alive until it's rebound
+		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+		srvDesc.Format = textureDesc.Format;
+		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+		srvDesc.Texture2D.MostDetailedMip = 0;
+		srvDesc.Texture2D.MipLevels = textureDesc.MipLevels;
+		GFX_THROW_INFO(GetDevice(gfx)->CreateShaderResourceView(pChain.Get(), &srvDesc, &pTextureView));
+		return pChain;
+	}
+}
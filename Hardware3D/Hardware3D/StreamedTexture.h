@@ -0,0 +1,63 @@
+﻿#pragma once
+#include "Bindable.h"
+#include <functional>
+#include <vector>
+
+class Surface;
+class TextureStreamer;
+
+namespace Bind
+{
+	// texture whose mip levels are brought in and dropped by a TextureStreamer
+	// the resident levels always run from some top level down to the smallest one, so the gpu texture is just
+	// the chain of the top resident level. until the first levels arrive a null view is bound (samples as zero)
+	class StreamedTexture : public Bindable
+	{
+		friend class ::TextureStreamer;
+	public:
+		// produces the full resolution image, runs on a streamer worker every time levels have to be loaded
+		using Source = std::function<Surface()>;
+	public:
+		StreamedTexture(Source source, UINT slot = 0u) noexcept;
+		void Bind(Graphics& gfx) noexcept override;
+		// demand for the coming streamer update: the largest extent in pixels the texture covers on screen
+		// the streamer aims for the level that maps about one texel onto each of those pixels
+		void RequestScreenSize(float pixels) noexcept;
+		// 0 until the first levels are in
+		unsigned int GetWidth() const noexcept;
+		unsigned int GetHeight() const noexcept;
+		unsigned int GetLevelCount() const noexcept;
+		// most detailed level on the gpu, equal to the level count while nothing is resident
+		unsigned int GetResidentLevel() const noexcept;
+		size_t GetResidentBytes() const noexcept;
+		// for debug views (imgui), nullptr until the first levels are in
+		ID3D11ShaderResourceView* GetView() const noexcept;
+	private:
+		unsigned int GetLevelForSize(float pixels) const noexcept;
+		// first level no bigger than the tail size, it and everything below is loaded first and never evicted
+		static unsigned int GetTailLevel(unsigned int width, unsigned int height) noexcept;
+		// size of the levels from first up to (not including) last
+		size_t GetBytes(unsigned int first, unsigned int last) const noexcept;
+		// replaces the resident chain with levels [top, level count) from the cpu
+		void Upload(Graphics& gfx, unsigned int top, const std::vector<Surface>& levels);
+		// drops the levels above top, the ones that stay are copied over on the gpu
+		void Evict(Graphics& gfx, unsigned int top);
+		Microsoft::WRL::ComPtr<ID3D11Texture2D> CreateChain(Graphics& gfx, unsigned int top, const D3D11_SUBRESOURCE_DATA* pInitialData);
+	private:
+		static constexpr unsigned int tailSize = 64u;
+		Source source;
+		UINT slot;
+		unsigned int width = 0u;
+		unsigned int height = 0u;
+		unsigned int levelCount = 0u;
+		unsigned int residentLevel = 0u;
+		// streamer bookkeeping, only touched on the render thread
+		float requestedPixels = 0.0f;
+		unsigned int wantedLevel = 0u;
+		unsigned int loadingLevel = 0u;
+		bool loading = false;
+		size_t lastNeededFrame = 0u;
+		Microsoft::WRL::ComPtr<ID3D11Texture2D> pTexture;
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> pTextureView;
+	};
+}
@@ -1,5 +1,7 @@
 ﻿#define FULL_WIN
 #include "Surface.h"
+#include "ImageDecoder.h"
+#include "JobSystem.h"
 #include <algorithm>
 
 namespace Gdiplus
@@ -9,11 +11,236 @@ namespace Gdiplus
 }
 
 #include <gdiplus.h>
+#include <array>
+#include <cmath>
+#include <fstream>
 #include <sstream>
 #include <string>
+#include <vector>
+#include <DirectXMath.h>
 
 #pragma comment(lib, "gdiplus.lib")
 
+namespace dx = DirectX;
+
+namespace
+{
+	// 8 bit srgb to linear and 12 bit linear back to 8 bit srgb
+	class SrgbTables
+	{
+	public:
+		static constexpr unsigned int linearSteps = 4096u;
+	public:
+		SrgbTables() noexcept
+		{
+			for (unsigned int i = 0; i < 256u; i++)
+			{
+				const float c = i / 255.0f;
+				toLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+			}
+			for (unsigned int i = 0; i < linearSteps; i++)
+			{
+				const float l = i / float(linearSteps - 1u);
+				const float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+				toSrgb[i] = (unsigned char)(c * 255.0f + 0.5f);
+			}
+		}
+		static const SrgbTables& Get() noexcept
+		{
+			static const SrgbTables tables;
+			return tables;
+		}
+		dx::XMVECTOR Decode(Surface::Color c) const noexcept
+		{
+			return dx::XMVectorSet(toLinear[c.GetR()], toLinear[c.GetG()], toLinear[c.GetB()], c.GetA() / 255.0f);
+		}
+		Surface::Color Encode(dx::FXMVECTOR linear) const noexcept
+		{
+			// negative lobes of the kaiser filter can push values out of range
+			dx::XMFLOAT4 v;
+			dx::XMStoreFloat4(&v, dx::XMVectorSaturate(linear));
+			constexpr float scale = float(linearSteps - 1u);
+			return {
+				(unsigned char)(v.w * 255.0f + 0.5f),
+				toSrgb[(unsigned int)(v.x * scale + 0.5f)],
+				toSrgb[(unsigned int)(v.y * scale + 0.5f)],
+				toSrgb[(unsigned int)(v.z * scale + 0.5f)]
+			};
+		}
+	private:
+		std::array<float, 256> toLinear;
+		std::array<unsigned char, linearSteps> toSrgb;
+	};
+
+	// calls f(row) for every row, runs of 16 rows are spread over the job system
+	template<typename F>
+	void ForEachRow(unsigned int rows, const F& f)
+	{
+		JobSystem::Get().ParallelFor(rows, 16u, [&f](size_t begin, size_t end)
+		{
+			for (auto y = begin; y < end; y++)
+			{
+				f((unsigned int)y);
+			}
+		});
+	}
+
+	// weights of a 2:1 kaiser windowed sinc, taps sit at -2.75 .. 2.75 destination pixels from the center
+	class KaiserKernel
+	{
+	public:
+		static constexpr int taps = 12;
+	public:
+		KaiserKernel() noexcept
+		{
+			constexpr float alpha = 4.0f;
+			constexpr float radius = 3.0f;
+			float sum = 0.0f;
+			for (int i = 0; i < taps; i++)
+			{
+				const float t = (i - taps / 2 + 0.5f) * 0.5f;
+				const float u = t / radius;
+				const float sinc = std::sin(dx::XM_PI * t) / (dx::XM_PI * t);
+				const float window = BesselI0(alpha * std::sqrt(1.0f - u * u)) / BesselI0(alpha);
+				weights[i] = sinc * window;
+				sum += weights[i];
+			}
+			for (auto& w : weights)
+			{
+				w /= sum;
+			}
+		}
+		static const KaiserKernel& Get() noexcept
+		{
+			static const KaiserKernel kernel;
+			return kernel;
+		}
+		// source index of the first tap for destination pixel x
+		static int GetFirstTap(unsigned int x) noexcept
+		{
+			return int(x) * 2 - (taps / 2 - 1);
+		}
+		float operator[](int i) const noexcept
+		{
+			return weights[i];
+		}
+	private:
+		static float BesselI0(float x) noexcept
+		{
+			// power series, converges quickly over the small range used here
+			float sum = 1.0f;
+			float term = 1.0f;
+			for (int k = 1; k < 16; k++)
+			{
+				term *= (x * 0.5f / k) * (x * 0.5f / k);
+				sum += term;
+			}
+			return sum;
+		}
+	private:
+		std::array<float, taps> weights;
+	};
+
+	// source texels one destination pixel averages along one axis (dst size is half the source, rounded down)
+	struct BoxTaps
+	{
+		unsigned int first;
+		unsigned int count;
+		float weights[3];
+	};
+	// even sizes average pairs. odd sizes take three texels weighted so that every source texel adds up to the
+	// same total weight over the level, which is the box over the exact area the pixel covers
+	BoxTaps GetBoxTaps(unsigned int x, unsigned int srcSize, unsigned int dstSize) noexcept
+	{
+		if (srcSize == 1u)
+		{
+			return { 0u, 1u, { 1.0f, 0.0f, 0.0f } };
+		}
+		if (srcSize % 2u == 0u)
+		{
+			return { x * 2u, 2u, { 0.5f, 0.5f, 0.0f } };
+		}
+		const float n = float(srcSize);
+		return { x * 2u, 3u, { float(dstSize - x) / n, float(dstSize) / n, float(x + 1u) / n } };
+	}
+
+	// one level down, linear in and linear out, dst is dstWidth * dstHeight
+	void DownsampleBox(const dx::XMVECTOR* pSrc, unsigned int srcWidth, unsigned int srcHeight,
+		dx::XMVECTOR* pDst, unsigned int dstWidth, unsigned int dstHeight)
+	{
+		std::vector<BoxTaps> columns(dstWidth);
+		for (unsigned int x = 0; x < dstWidth; x++)
+		{
+			columns[x] = GetBoxTaps(x, srcWidth, dstWidth);
+		}
+		ForEachRow(dstHeight, [=, &columns](unsigned int y)
+		{
+			const auto rows = GetBoxTaps(y, srcHeight, dstHeight);
+			const auto pOut = pDst + size_t(y) * dstWidth;
+			for (unsigned int x = 0; x < dstWidth; x++)
+			{
+				const auto& cols = columns[x];
+				auto sum = dx::XMVectorZero();
+				for (unsigned int r = 0; r < rows.count; r++)
+				{
+					const auto pRow = pSrc + size_t(rows.first + r) * srcWidth + cols.first;
+					auto rowSum = dx::XMVectorZero();
+					for (unsigned int c = 0; c < cols.count; c++)
+					{
+						rowSum = dx::XMVectorMultiplyAdd(pRow[c], dx::XMVectorReplicate(cols.weights[c]), rowSum);
+					}
+					sum = dx::XMVectorMultiplyAdd(rowSum, dx::XMVectorReplicate(rows.weights[r]), sum);
+				}
+				pOut[x] = sum;
+			}
+		});
+	}
+
+	void DownsampleKaiser(const dx::XMVECTOR* pSrc, unsigned int srcWidth, unsigned int srcHeight,
+		dx::XMVECTOR* pDst, unsigned int dstWidth, unsigned int dstHeight, std::vector<dx::XMVECTOR>& scratch)
+	{
+		const auto& kernel = KaiserKernel::Get();
+		// separable, horizontal into scratch (dstWidth * srcHeight) then vertical into dst, edges clamp
+		scratch.resize(size_t(dstWidth) * srcHeight);
+		const auto pTemp = scratch.data();
+		ForEachRow(srcHeight, [=, &kernel](unsigned int y)
+		{
+			const auto pRow = pSrc + size_t(y) * srcWidth;
+			const auto pOut = pTemp + size_t(y) * dstWidth;
+			for (unsigned int x = 0; x < dstWidth; x++)
+			{
+				const int first = KaiserKernel::GetFirstTap(x);
+				auto sum = dx::XMVectorZero();
+				for (int i = 0; i < KaiserKernel::taps; i++)
+				{
+					const int sx = std::clamp(first + i, 0, int(srcWidth) - 1);
+					sum = dx::XMVectorMultiplyAdd(pRow[sx], dx::XMVectorReplicate(kernel[i]), sum);
+				}
+				pOut[x] = sum;
+			}
+		});
+		ForEachRow(dstHeight, [=, &kernel](unsigned int y)
+		{
+			const int first = KaiserKernel::GetFirstTap(y);
+			const auto pOut = pDst + size_t(y) * dstWidth;
+			for (unsigned int x = 0; x < dstWidth; x++)
+			{
+				pOut[x] = dx::XMVectorZero();
+			}
+			for (int i = 0; i < KaiserKernel::taps; i++)
+			{
+				const int sy = std::clamp(first + i, 0, int(srcHeight) - 1);
+				const auto pRow = pTemp + size_t(sy) * dstWidth;
+				const auto weight = dx::XMVectorReplicate(kernel[i]);
+				for (unsigned int x = 0; x < dstWidth; x++)
+				{
+					pOut[x] = dx::XMVectorMultiplyAdd(pRow[x], weight, pOut[x]);
+				}
+			}
+		});
+	}
+}
+
 Surface::Surface(unsigned width, unsigned height) noexcept
 	:
 pBuffer(std::make_unique<Color[]>(width * height)),
@@ -88,6 +315,44 @@ const Surface::Color* Surface::GetBufferPtrConst() const noexcept
 }
 
 Surface Surface::FromFile(const std::string& name)
+{
+	static_assert(sizeof(Color) == sizeof(std::uint32_t), "decoder writes Color as 32 bit bgra");
+
+	std::vector<unsigned char> data;
+	{
+		std::ifstream file(name, std::ios::binary | std::ios::ate);
+		if (!file)
+		{
+			std::stringstream ss;
+			ss << "Loading Image [" << name << "]: failed to open.";
+			throw Exception(__LINE__, __FILE__, ss.str());
+		}
+		data.resize((size_t)file.tellg());
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(data.data()), data.size());
+	}
+
+	const auto info = ImageDecoder::ReadInfo(data.data(), data.size());
+	if (!info)
+	{
+		return FromFileGdiPlus(name);
+	}
+
+	auto pBuffer = std::make_unique<Color[]>(size_t(info->width) * info->height);
+	try
+	{
+		ImageDecoder::Decode(data.data(), data.size(), *info, reinterpret_cast<std::uint32_t*>(pBuffer.get()));
+	}
+	catch (const ImageDecoder::Exception& e)
+	{
+		std::stringstream ss;
+		ss << "Loading Image [" << name << "]: " << e.GetNote();
+		throw Exception(__LINE__, __FILE__, ss.str());
+	}
+	return Surface(info->width, info->height, std::move(pBuffer));
+}
+
+Surface Surface::FromFileGdiPlus(const std::string& name)
 {
 	unsigned int width = 0;
 	unsigned int height = 0;
@@ -110,15 +375,22 @@ Surface Surface::FromFile(const std::string& name)
 		height = bitmap.GetHeight();
 		pBuffer = std::make_unique<Color[]>(width * height);
 
-		for (unsigned int y = 0; y < height; ++y)
+		// gdi+ converts into our buffer in one go, 32bpp argb has the same layout as Color
+		Gdiplus::Rect rect(0, 0, (INT)width, (INT)height);
+		Gdiplus::BitmapData bitmapData = {};
+		bitmapData.Width = width;
+		bitmapData.Height = height;
+		bitmapData.Stride = (INT)(width * sizeof(Color));
+		bitmapData.PixelFormat = PixelFormat32bppARGB;
+		bitmapData.Scan0 = pBuffer.get();
+		if (bitmap.LockBits(&rect, Gdiplus::ImageLockModeRead | Gdiplus::ImageLockModeUserInputBuf,
+			PixelFormat32bppARGB, &bitmapData) != Gdiplus::Status::Ok)
 		{
-			for (unsigned int x = 0; x < width; ++x)
-			{
-				Gdiplus::Color c;
-				bitmap.GetPixel(x, y, &c);
-				pBuffer[y * width + x] = c.GetValue();
-			}
+			std::stringstream ss;
+			ss << "Loading Image [" << name << "]: failed to read pixels.";
+			throw Exception(__LINE__, __FILE__, ss.str());
 		}
+		bitmap.UnlockBits(&bitmapData);
 	}
 
 	return Surface(width, height, std::move(pBuffer));
@@ -190,6 +462,67 @@ void Surface::Copy(const Surface& src) noxnd
 	memcpy(pBuffer.get(), src.pBuffer.get(), width * height * sizeof(Color));
 }
 
+std::vector<Surface> Surface::MakeMipChain(MipFilter filter) const
+{
+	const auto& srgb = SrgbTables::Get();
+	std::vector<Surface> chain;
+	chain.reserve(GetMipCount(width, height) - 1u);
+
+	// each level is filtered from the linear values of the one above, not its 8 bit encoding
+	std::vector<dx::XMVECTOR> src(size_t(width) * height);
+	ForEachRow(height, [&](unsigned int y)
+	{
+		for (unsigned int x = 0; x < width; x++)
+		{
+			src[size_t(y) * width + x] = srgb.Decode(pBuffer[size_t(y) * width + x]);
+		}
+	});
+	std::vector<dx::XMVECTOR> dst;
+	std::vector<dx::XMVECTOR> scratch;
+
+	unsigned int srcWidth = width;
+	unsigned int srcHeight = height;
+	while (srcWidth > 1u || srcHeight > 1u)
+	{
+		const unsigned int dstWidth = std::max(srcWidth / 2u, 1u);
+		const unsigned int dstHeight = std::max(srcHeight / 2u, 1u);
+		dst.resize(size_t(dstWidth) * dstHeight);
+		if (filter == MipFilter::Kaiser)
+		{
+			DownsampleKaiser(src.data(), srcWidth, srcHeight, dst.data(), dstWidth, dstHeight, scratch);
+		}
+		else
+		{
+			DownsampleBox(src.data(), srcWidth, srcHeight, dst.data(), dstWidth, dstHeight);
+		}
+
+		Surface level(dstWidth, dstHeight);
+		ForEachRow(dstHeight, [&](unsigned int y)
+		{
+			for (unsigned int x = 0; x < dstWidth; x++)
+			{
+				level.pBuffer[size_t(y) * dstWidth + x] = srgb.Encode(dst[size_t(y) * dstWidth + x]);
+			}
+		});
+		chain.push_back(std::move(level));
+
+		std::swap(src, dst);
+		srcWidth = dstWidth;
+		srcHeight = dstHeight;
+	}
+	return chain;
+}
+
+unsigned int Surface::GetMipCount(unsigned int width, unsigned int height) noexcept
+{
+	unsigned int count = 1u;
+	for (auto size = std::max(width, height); size > 1u; size /= 2u)
+	{
+		count++;
+	}
+	return count;
+}
+
 Surface::Surface(unsigned width, unsigned height, std::unique_ptr<Color[]> pBufferParam) noexcept
 	:
 pBuffer(std::move(pBufferParam)),
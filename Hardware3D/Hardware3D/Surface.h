@@ -8,6 +8,7 @@
 #include <string>
 #include <cassert>
 #include <memory>
+#include <vector>
 #include "ConditionalNoExcept.h"
 
 
@@ -98,6 +99,13 @@ public:
 	private:
 		std::string note;
 	};
+	enum class MipFilter
+	{
+		// 2x2 average
+		Box,
+		// kaiser windowed sinc, sharper than box at the cost of 12 taps per axis
+		Kaiser,
+	};
 public:
 	Surface(unsigned int width, unsigned int height) noexcept;
 	Surface(Surface&& source) noexcept;
@@ -113,9 +121,16 @@ public:
 	Color* GetBufferPtr() noexcept;
 	const Color* GetBufferPtr() const noexcept;
 	const Color* GetBufferPtrConst() const noexcept;
+	// png, tga and bmp go through ImageDecoder, anything it doesn't handle falls back to gdi+
 	static Surface FromFile(const std::string& name);
+	static Surface FromFileGdiPlus(const std::string& name);
 	void Save(const std::string& filename) const;
 	void Copy(const Surface& src) noxnd;
+	// every level below this one down to 1x1, each half the size (rounded down) of the one before
+	// filtering happens in linear light, color is treated as srgb and alpha as linear, rows are split over threads
+	std::vector<Surface> MakeMipChain(MipFilter filter = MipFilter::Box) const;
+	// levels of a full chain including the top one
+	static unsigned int GetMipCount(unsigned int width, unsigned int height) noexcept;
 private:
 	Surface(unsigned int width, unsigned int height, std::unique_ptr<Color[]> pBufferParam) noexcept;
 private:
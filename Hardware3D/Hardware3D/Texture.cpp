@@ -1,12 +1,33 @@
 ﻿#include "Texture.h"
 #include "Surface.h"
+#include "TextureCache.h"
 #include "GraphicsErrorMacros.h"
+#include <algorithm>
+#include <vector>
 
 namespace Bind
 {
 	namespace wrl = Microsoft::WRL;
 
-	Texture::Texture(Graphics& gfx, const Surface& s)
+	namespace
+	{
+		DXGI_FORMAT GetDxgiFormat(BlockCompressor::Format format) noexcept
+		{
+			switch (format)
+			{
+			case BlockCompressor::Format::BC1:
+				return DXGI_FORMAT_BC1_UNORM;
+			case BlockCompressor::Format::BC3:
+				return DXGI_FORMAT_BC3_UNORM;
+			case BlockCompressor::Format::BC5:
+				return DXGI_FORMAT_BC5_UNORM;
+			default:
+				return DXGI_FORMAT_BC7_UNORM;
+			}
+		}
+	}
+
+	Texture::Texture(Graphics& gfx, const Surface& s, std::optional<BlockCompressor::Format> compression)
 	{
 		INFOMAN(gfx);
 
@@ -14,7 +35,8 @@ namespace Bind
 		D3D11_TEXTURE2D_DESC textureDesc = {};
 		textureDesc.Width = s.GetWidth();
 		textureDesc.Height = s.GetHeight();
-		textureDesc.MipLevels = 1;
+		// the full chain is generated on the cpu so it can be uploaded in the same call as the top level
+		textureDesc.MipLevels = Surface::GetMipCount(s.GetWidth(), s.GetHeight());
 		textureDesc.ArraySize = 1;
 		textureDesc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
 		textureDesc.SampleDesc.Count = 1;
@@ -24,18 +46,48 @@ namespace Bind
 		textureDesc.CPUAccessFlags = 0;
 		textureDesc.MiscFlags = 0;
 
-		D3D11_SUBRESOURCE_DATA subData = {};
-		subData.pSysMem = s.GetBufferPtr();
-		subData.SysMemPitch = s.GetWidth() * sizeof(Surface::Color);
+		std::vector<D3D11_SUBRESOURCE_DATA> subData(textureDesc.MipLevels);
+		// whichever of these ends up used has to outlive the create call
+		std::vector<Surface> mips;
+		std::optional<TextureCache> cache;
+		TextureCache::Levels encoded;
+		// block formats want the top level in whole blocks, the runtime pads the smaller levels itself
+		if (compression && s.GetWidth() % 4u == 0u && s.GetHeight() % 4u == 0u)
+		{
+			textureDesc.Format = GetDxgiFormat(*compression);
+			cache.emplace(s, *compression);
+			if (!cache->IsLoaded())
+			{
+				encoded = TextureCache::EncodeChain(s, *compression);
+				cache->Write(encoded);
+			}
+			const auto& levels = cache->IsLoaded() ? cache->GetLevels() : encoded;
+			for (size_t i = 0; i < levels.size(); i++)
+			{
+				subData[i].pSysMem = levels[i].data();
+				subData[i].SysMemPitch = (UINT)BlockCompressor::GetRowPitch(*compression, std::max(s.GetWidth() >> i, 1u));
+			}
+		}
+		else
+		{
+			mips = s.MakeMipChain();
+			subData[0].pSysMem = s.GetBufferPtr();
+			subData[0].SysMemPitch = s.GetWidth() * sizeof(Surface::Color);
+			for (size_t i = 0; i < mips.size(); i++)
+			{
+				subData[i + 1].pSysMem = mips[i].GetBufferPtr();
+				subData[i + 1].SysMemPitch = mips[i].GetWidth() * sizeof(Surface::Color);
+			}
+		}
 		wrl::ComPtr<ID3D11Texture2D> pTexture;
-		GFX_THROW_INFO(GetDevice(gfx)->CreateTexture2D(&textureDesc, &subData, &pTexture));
+		GFX_THROW_INFO(GetDevice(gfx)->CreateTexture2D(&textureDesc, subData.data(), &pTexture));
 
 		// create the resource view on the texture
 		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
 		srvDesc.Format = textureDesc.Format;
 		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
 		srvDesc.Texture2D.MostDetailedMip = 0;
-		srvDesc.Texture2D.MipLevels = 1;
+		srvDesc.Texture2D.MipLevels = textureDesc.MipLevels;
 		GFX_THROW_INFO(GetDevice(gfx)->CreateShaderResourceView(pTexture.Get(), &srvDesc, &pTextureView));
 	}
 
@@ -1,5 +1,7 @@
 ﻿#pragma once
 #include "Bindable.h"
+#include "BlockCompressor.h"
+#include <optional>
 
 class Surface;
 
@@ -8,7 +10,10 @@ namespace Bind
 	class Texture : public Bindable
 	{
 	public:
-		Texture(Graphics& gfx, const class Surface& s);
+		// with a compression format the encoded chain comes from (or goes into) the texture cache
+		// bc5 only keeps red and green, shaders sampling it have to rebuild the rest
+		// surfaces that aren't a whole number of 4x4 blocks are uploaded uncompressed
+		Texture(Graphics& gfx, const class Surface& s, std::optional<BlockCompressor::Format> compression = std::nullopt);
 		void Bind(Graphics& gfx) noexcept override;
 	protected:
 		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> pTextureView;
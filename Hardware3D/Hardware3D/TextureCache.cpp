@@ -0,0 +1,161 @@
+﻿#include "TextureCache.h"
+#include "Surface.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+
+namespace
+{
+	// followed by the blocks of every level back to back, top level first
+	struct FileHeader
+	{
+		char magic[4];
+		std::uint32_t version;
+		std::uint64_t sourceHash;
+		std::uint64_t fileSize;
+		std::uint32_t width;
+		std::uint32_t height;
+		std::uint32_t format;
+		std::uint32_t levelCount;
+	};
+	constexpr char magic[4] = { 'H','3','D','T' };
+	constexpr const char* directory = "TextureCache";
+
+	unsigned int GetLevelSize(unsigned int size, size_t level) noexcept
+	{
+		return std::max(size >> level, 1u);
+	}
+}
+
+TextureCache::TextureCache(const Surface& s, BlockCompressor::Format format)
+	:
+	sourceHash(HashSurface(s, format)),
+	width(s.GetWidth()),
+	height(s.GetHeight()),
+	format(format)
+{
+	std::stringstream ss;
+	ss << directory << "\\" << std::hex << std::setw(16) << std::setfill('0') << sourceHash << ".h3dtex";
+	cachePath = ss.str();
+	if (!Load())
+	{
+		levels.clear();
+	}
+}
+
+bool TextureCache::IsLoaded() const noexcept
+{
+	return !levels.empty();
+}
+
+const TextureCache::Levels& TextureCache::GetLevels() const noexcept
+{
+	return levels;
+}
+
+bool TextureCache::Write(const Levels& levels) const
+{
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+	std::ofstream file(cachePath, std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		return false;
+	}
+
+	// file size gets patched in at the end, a partially written file never validates
+	FileHeader header = {};
+	std::copy(std::begin(magic), std::end(magic), header.magic);
+	header.version = version;
+	header.sourceHash = sourceHash;
+	header.width = width;
+	header.height = height;
+	header.format = (std::uint32_t)format;
+	header.levelCount = (std::uint32_t)levels.size();
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	header.fileSize = sizeof(header);
+	for (const auto& l : levels)
+	{
+		file.write(reinterpret_cast<const char*>(l.data()), l.size());
+		header.fileSize += l.size();
+	}
+
+	file.seekp(0);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	return bool(file);
+}
+
+TextureCache::Levels TextureCache::EncodeChain(const Surface& s, BlockCompressor::Format format)
+{
+	static_assert(sizeof(Surface::Color) == sizeof(std::uint32_t), "encoder reads Color as 32 bit bgra");
+	const auto encode = [format](const Surface& level)
+	{
+		return BlockCompressor::Encode(reinterpret_cast<const std::uint32_t*>(level.GetBufferPtrConst()),
+			level.GetWidth(), level.GetHeight(), format);
+	};
+
+	Levels levels;
+	levels.push_back(encode(s));
+	for (const auto& m : s.MakeMipChain())
+	{
+		levels.push_back(encode(m));
+	}
+	return levels;
+}
+
+bool TextureCache::Load()
+{
+	std::ifstream file(cachePath, std::ios::binary);
+	FileHeader header;
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+		!std::equal(std::begin(magic), std::end(magic), header.magic) ||
+		header.version != version ||
+		header.sourceHash != sourceHash ||
+		header.width != width ||
+		header.height != height ||
+		header.format != (std::uint32_t)format ||
+		header.levelCount != Surface::GetMipCount(width, height))
+	{
+		return false;
+	}
+
+	size_t fileSize = sizeof(header);
+	levels.resize(header.levelCount);
+	for (size_t i = 0; i < levels.size(); i++)
+	{
+		levels[i].resize(BlockCompressor::GetEncodedSize(format, GetLevelSize(width, i), GetLevelSize(height, i)));
+		if (!file.read(reinterpret_cast<char*>(levels[i].data()), levels[i].size()))
+		{
+			return false;
+		}
+		fileSize += levels[i].size();
+	}
+	// anything left over means the file doesn't belong to this layout
+	return header.fileSize == fileSize && file.peek() == std::ifstream::traits_type::eof();
+}
+
+std::uint64_t TextureCache::HashSurface(const Surface& s, BlockCompressor::Format format) noexcept
+{
+	// fnv-1a over whole pixels rather than bytes, the surface can be tens of megabytes
+	constexpr std::uint64_t prime = 1099511628211ull;
+	std::uint64_t hash = 14695981039346656037ull;
+	const auto mix = [&hash](std::uint64_t value)
+	{
+		hash = (hash ^ value) * prime;
+	};
+
+	const auto pPixels = s.GetBufferPtrConst();
+	const size_t count = size_t(s.GetWidth()) * s.GetHeight();
+	for (size_t i = 0; i < count; i++)
+	{
+		mix(pPixels[i].dword);
+	}
+	mix(s.GetWidth());
+	mix(s.GetHeight());
+	mix((std::uint64_t)format);
+	mix(version);
+	return hash;
+}
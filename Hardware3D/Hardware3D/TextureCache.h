@@ -0,0 +1,37 @@
+﻿#pragma once
+#include "BlockCompressor.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Surface;
+
+// block compressed mip chains kept on disk between runs, keyed on the source pixels and the format
+// encoding (bc7 especially) costs far more than reading the blocks back, so each texture is only encoded once
+class TextureCache
+{
+public:
+	// one entry per mip level, top level first
+	using Levels = std::vector<std::vector<unsigned char>>;
+public:
+	// hashes the surface and loads the matching cache file if there is one
+	TextureCache(const Surface& s, BlockCompressor::Format format);
+	bool IsLoaded() const noexcept;
+	const Levels& GetLevels() const noexcept;
+	// failing to write isn't an error, the texture just gets encoded again next run
+	bool Write(const Levels& levels) const;
+	// encodes the surface and every level of the mip chain generated from it
+	static Levels EncodeChain(const Surface& s, BlockCompressor::Format format);
+private:
+	bool Load();
+	static std::uint64_t HashSurface(const Surface& s, BlockCompressor::Format format) noexcept;
+private:
+	// bump whenever the file layout or the encoder output changes
+	static constexpr std::uint32_t version = 2u;
+	std::string cachePath;
+	std::uint64_t sourceHash;
+	unsigned int width;
+	unsigned int height;
+	BlockCompressor::Format format;
+	Levels levels;
+};
@@ -0,0 +1,269 @@
+﻿#include "TextureStreamer.h"
+#include <algorithm>
+
+TextureStreamer::TextureStreamer(size_t budgetBytes, unsigned int workerCount)
+	:
+	budgetBytes(budgetBytes)
+{
+	for (unsigned int i = 0; i < std::max(workerCount, 1u); i++)
+	{
+		workers.emplace_back([this]() { RunWorker(); });
+	}
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	jobAdded.notify_all();
+	for (auto& w : workers)
+	{
+		w.join();
+	}
+}
+
+std::shared_ptr<Bind::StreamedTexture> TextureStreamer::Load(Bind::StreamedTexture::Source source, UINT slot)
+{
+	auto pTexture = std::make_shared<Bind::StreamedTexture>(std::move(source), slot);
+	pTexture->loading = true;
+	Enqueue({ pTexture, pTexture->source, std::nullopt });
+	textures.push_back(pTexture);
+	return pTexture;
+}
+
+void TextureStreamer::Update(Graphics& gfx)
+{
+	frame++;
+	std::vector<Result> finished;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		finished.swap(results);
+	}
+
+	// errors are held back until the bookkeeping below is done, the streamer stays usable after a failed load
+	std::exception_ptr pError;
+	for (auto& r : finished)
+	{
+		const auto pTexture = r.pTexture.lock();
+		if (!pTexture)
+		{
+			continue;
+		}
+		pTexture->loading = false;
+		if (r.pError)
+		{
+			pError = r.pError;
+			continue;
+		}
+		if (pTexture->levelCount == 0u)
+		{
+			pTexture->width = r.width;
+			pTexture->height = r.height;
+			pTexture->levelCount = Surface::GetMipCount(r.width, r.height);
+			pTexture->residentLevel = pTexture->levelCount;
+		}
+		// levels may have been evicted while the load was running, the result always carries the whole chain
+		if (r.top < pTexture->residentLevel)
+		{
+			stats.levelsLoaded += pTexture->residentLevel - r.top;
+			pTexture->Upload(gfx, r.top, r.levels);
+		}
+	}
+
+	// demand since the last update, bytes already resident or on their way, and bytes still asked for
+	std::vector<std::shared_ptr<Bind::StreamedTexture>> live;
+	live.reserve(textures.size());
+	size_t committed = 0u;
+	size_t demanded = 0u;
+	for (const auto& w : textures)
+	{
+		auto pTexture = w.lock();
+		if (!pTexture)
+		{
+			continue;
+		}
+		const auto& t = *pTexture;
+		if (t.levelCount != 0u)
+		{
+			committed += t.GetBytes(t.loading ? std::min(t.loadingLevel, t.residentLevel) : t.residentLevel, t.levelCount);
+			if (t.requestedPixels > 0.0f)
+			{
+				pTexture->lastNeededFrame = frame;
+				pTexture->wantedLevel = t.GetLevelForSize(t.requestedPixels);
+				if (!t.loading && t.wantedLevel < t.residentLevel)
+				{
+					demanded += t.GetBytes(t.wantedLevel, t.residentLevel);
+				}
+			}
+		}
+		live.push_back(std::move(pTexture));
+	}
+	textures.assign(live.begin(), live.end());
+
+	// make room by dropping the top levels of the least recently needed textures. the first pass makes room
+	// for the new demand, where textures asked for this frame only give up what's more detailed than they
+	// asked for. the second only runs when what's already there is over budget, and spares nothing but tails
+	std::stable_sort(live.begin(), live.end(), [](const auto& a, const auto& b)
+	{
+		return a->lastNeededFrame < b->lastNeededFrame;
+	});
+	const auto evict = [&](size_t target, bool spareNeeded)
+	{
+		for (const auto& pTexture : live)
+		{
+			auto& t = *pTexture;
+			if (committed <= target)
+			{
+				break;
+			}
+			if (t.levelCount == 0u)
+			{
+				continue;
+			}
+			const auto tail = Bind::StreamedTexture::GetTailLevel(t.width, t.height);
+			const auto keep = spareNeeded && t.lastNeededFrame == frame ? std::min(t.wantedLevel, tail) : tail;
+			auto top = t.residentLevel;
+			for (; top < keep && committed > target; top++)
+			{
+				committed -= t.GetBytes(top, top + 1u);
+			}
+			if (top != t.residentLevel)
+			{
+				stats.levelsEvicted += top - t.residentLevel;
+				t.Evict(gfx, top);
+			}
+		}
+	};
+	evict(budgetBytes - std::min(demanded, budgetBytes), true);
+	evict(budgetBytes, false);
+
+	// start loads for whatever demand fits, most recently needed first, stepping back to coarser levels
+	// rather than going over budget
+	for (auto i = live.rbegin(); i != live.rend(); ++i)
+	{
+		auto& t = **i;
+		if (t.lastNeededFrame != frame || t.loading || t.wantedLevel >= t.residentLevel)
+		{
+			continue;
+		}
+		auto top = t.wantedLevel;
+		while (top < t.residentLevel && committed + t.GetBytes(top, t.residentLevel) > budgetBytes)
+		{
+			top++;
+		}
+		if (top < t.residentLevel)
+		{
+			committed += t.GetBytes(top, t.residentLevel);
+			t.loading = true;
+			t.loadingLevel = top;
+			Enqueue({ *i, t.source, top });
+		}
+	}
+
+	stats.textures = live.size();
+	stats.residentBytes = 0u;
+	stats.pendingLoads = 0u;
+	for (const auto& pTexture : live)
+	{
+		stats.residentBytes += pTexture->GetResidentBytes();
+		stats.pendingLoads += pTexture->loading ? 1u : 0u;
+		pTexture->requestedPixels = 0.0f;
+	}
+	stats.budgetBytes = budgetBytes;
+
+	if (pError)
+	{
+		std::rethrow_exception(pError);
+	}
+}
+
+void TextureStreamer::WaitForLoads()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	jobFinished.wait(lock, [this]()
+	{
+		return jobs.empty() && busyWorkers == 0u;
+	});
+}
+
+void TextureStreamer::SetBudget(size_t bytes) noexcept
+{
+	budgetBytes = bytes;
+}
+
+const TextureStreamer::Stats& TextureStreamer::GetStats() const noexcept
+{
+	return stats;
+}
+
+void TextureStreamer::Enqueue(Job job)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.push_back(std::move(job));
+	}
+	jobAdded.notify_one();
+}
+
+void TextureStreamer::RunWorker()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true)
+	{
+		jobAdded.wait(lock, [this]()
+		{
+			return stopping || !jobs.empty();
+		});
+		if (stopping)
+		{
+			return;
+		}
+		const auto job = std::move(jobs.front());
+		jobs.pop_front();
+		busyWorkers++;
+
+		lock.unlock();
+		auto result = RunJob(job);
+		lock.lock();
+
+		results.push_back(std::move(result));
+		busyWorkers--;
+		jobFinished.notify_all();
+	}
+}
+
+TextureStreamer::Result TextureStreamer::RunJob(const Job& job)
+{
+	Result result = { job.pTexture, 0u, 0u, 0u, {}, nullptr };
+	// nobody left to hand the levels to
+	if (job.pTexture.expired())
+	{
+		return result;
+	}
+	try
+	{
+		auto s = job.source();
+		result.width = s.GetWidth();
+		result.height = s.GetHeight();
+		const auto levelCount = Surface::GetMipCount(result.width, result.height);
+		result.top = std::min(job.top.value_or(Bind::StreamedTexture::GetTailLevel(result.width, result.height)), levelCount - 1u);
+
+		// the chain is built from the full image every time, the levels above top are dropped right after
+		auto mips = s.MakeMipChain();
+		if (result.top == 0u)
+		{
+			result.levels.push_back(std::move(s));
+		}
+		for (size_t i = std::max(result.top, 1u) - 1u; i < mips.size(); i++)
+		{
+			result.levels.push_back(std::move(mips[i]));
+		}
+	}
+	catch (...)
+	{
+		result.pError = std::current_exception();
+	}
+	return result;
+}
@@ -0,0 +1,81 @@
+﻿#pragma once
+#include "StreamedTexture.h"
+#include "Surface.h"
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+// keeps the mips of streamed textures on the gpu within a memory budget
+// a texture starts out with just its small tail levels, more detailed levels are loaded on worker threads once
+// something asks for them (StreamedTexture::RequestScreenSize), and when the budget runs short the levels of the
+// textures that went longest without being asked for are dropped again
+// workers only decode and build mip chains, every device / context call happens in Update on the render thread
+class TextureStreamer
+{
+public:
+	struct Stats
+	{
+		size_t textures;
+		size_t residentBytes;
+		size_t budgetBytes;
+		// loads in flight as of the last update
+		size_t pendingLoads;
+		// totals since the streamer was created
+		size_t levelsLoaded;
+		size_t levelsEvicted;
+	};
+public:
+	TextureStreamer(size_t budgetBytes, unsigned int workerCount = 2u);
+	TextureStreamer(const TextureStreamer&) = delete;
+	TextureStreamer& operator=(const TextureStreamer&) = delete;
+	~TextureStreamer();
+	// queues the tail levels right away, the texture binds a null view until they've been through an Update
+	std::shared_ptr<Bind::StreamedTexture> Load(Bind::StreamedTexture::Source source, UINT slot = 0u);
+	// once a frame before anything samples the textures: uploads finished loads, evicts to make room and starts
+	// loads for the demand recorded since the last update. errors thrown by a source are rethrown here
+	void Update(Graphics& gfx);
+	// blocks until no load is queued or running, what they produced still waits for the next Update
+	void WaitForLoads();
+	void SetBudget(size_t bytes) noexcept;
+	const Stats& GetStats() const noexcept;
+private:
+	struct Job
+	{
+		std::weak_ptr<Bind::StreamedTexture> pTexture;
+		Bind::StreamedTexture::Source source;
+		// most detailed level to produce, the tail when the size isn't known yet
+		std::optional<unsigned int> top;
+	};
+	// levels [top, level count) of the source
+	struct Result
+	{
+		std::weak_ptr<Bind::StreamedTexture> pTexture;
+		unsigned int width;
+		unsigned int height;
+		unsigned int top;
+		std::vector<Surface> levels;
+		std::exception_ptr pError;
+	};
+private:
+	void Enqueue(Job job);
+	void RunWorker();
+	static Result RunJob(const Job& job);
+private:
+	size_t budgetBytes;
+	size_t frame = 0u;
+	Stats stats = {};
+	std::vector<std::weak_ptr<Bind::StreamedTexture>> textures;
+	std::mutex mutex;
+	std::condition_variable jobAdded;
+	std::condition_variable jobFinished;
+	std::deque<Job> jobs;
+	std::vector<Result> results;
+	unsigned int busyWorkers = 0u;
+	bool stopping = false;
+	std::vector<std::thread> workers;
+};
@@ -4,7 +4,8 @@ namespace Bind
 {
 	TransformCbuf::TransformCbuf(Graphics& gfx, const Drawable& parent, UINT slot)
 		:
-		parent(parent)
+		parent(parent),
+		slot(slot)
 	{
 		if (!pVcBuf)
 		{
@@ -12,16 +13,41 @@ namespace Bind
 		}
 	}
 
+	void TransformCbuf::Stage(Graphics& gfx)
+	{
+		if (auto pRing = gfx.GetFrameConstants())
+		{
+			staged.push_back(pRing->Stage(GetTransforms(gfx)));
+		}
+	}
+
 	void TransformCbuf::Bind(Graphics& gfx) noexcept
 	{
-		const auto modelView = parent.GetTransformXM() * gfx.GetCamera();
-		const Transforms tf =
+		if (nextStaged < staged.size())
 		{
+			const auto allocation = staged[nextStaged++];
+			if (nextStaged == staged.size())
+			{
+				staged.clear();
+				nextStaged = 0u;
+			}
+			const auto pRing = gfx.GetFrameConstants();
+			ID3D11Buffer* const pBuffer = pRing->GetBuffer();
+			const UINT firstConstant = pRing->GetFirstConstant(allocation);
+			GetContext(gfx)->VSSetConstantBuffers1(slot, 1u, &pBuffer, &firstConstant, &allocation.numConstants);
+			return;
+		}
+		pVcBuf->Update(gfx, GetTransforms(gfx));
+		pVcBuf->Bind(gfx);
+	}
+
+	TransformCbuf::Transforms TransformCbuf::GetTransforms(Graphics& gfx) const noexcept
+	{
+		const auto modelView = parent.GetTransformXM() * gfx.GetCamera();
+		return {
 			DirectX::XMMatrixTranspose(modelView),
 			DirectX::XMMatrixTranspose(modelView * gfx.GetProjection())
 		};
-		pVcBuf->Update(gfx, tf);
-		pVcBuf->Bind(gfx);
 	}
 
 	std::unique_ptr<VertexConstantBuffer<TransformCbuf::Transforms>> TransformCbuf::pVcBuf;
@@ -1,7 +1,9 @@
 ﻿#pragma once
 #include "ConstantBuffers.h"
 #include "Drawable.h"
+#include "FrameConstantRing.h"
 #include <DirectXMath.h>
+#include <vector>
 
 namespace Bind
 {
@@ -15,10 +17,19 @@ namespace Bind
 		};
 	public:
 		TransformCbuf(Graphics& gfx, const Drawable& parent, UINT slot = 0u);
+		// queued draws stage their transforms into the frame constant ring and bind them by offset,
+		// direct draws (or devices without the ring) update the shared constant buffer instead
+		void Stage(Graphics& gfx) override;
 		void Bind(Graphics& gfx) noexcept override;
+	private:
+		Transforms GetTransforms(Graphics& gfx) const noexcept;
 	private:
 		static std::unique_ptr<VertexConstantBuffer<Transforms>> pVcBuf;
 		const Drawable& parent;
+		UINT slot;
+		// allocations of staged draws, consumed in order by Bind
+		std::vector<FrameConstantRing::Allocation> staged;
+		size_t nextStaged = 0u;
 	};
 	
 }
@@ -1,7 +1,82 @@
 ﻿#include "Vertex.h"
+#include <cstring>
 
 namespace Dvtx
 {
+	namespace
+	{
+		// copies one attribute stream into its slot of every vertex
+		// size is a compile time constant so each copy boils down to a couple of moves
+		template<size_t Size>
+		void ScatterStream( char* pDst,size_t stride,const char* pSrc,size_t count ) noexcept
+		{
+			for( size_t i = 0; i < count; i++,pDst += stride,pSrc += Size )
+			{
+				std::memcpy( pDst,pSrc,Size );
+			}
+		}
+		void ScatterStream( char* pDst,size_t stride,const char* pSrc,size_t size,size_t count ) noexcept
+		{
+			switch( size )
+			{
+			case 4u:
+				ScatterStream<4u>( pDst,stride,pSrc,count );
+				break;
+			case 8u:
+				ScatterStream<8u>( pDst,stride,pSrc,count );
+				break;
+			case 12u:
+				ScatterStream<12u>( pDst,stride,pSrc,count );
+				break;
+			case 16u:
+				ScatterStream<16u>( pDst,stride,pSrc,count );
+				break;
+			default:
+				for( size_t i = 0; i < count; i++,pDst += stride,pSrc += size )
+				{
+					std::memcpy( pDst,pSrc,size );
+				}
+			}
+		}
+		// two float3 streams (position + normal etc.) into 24 byte vertices
+		// 4 vertices per iteration: 3 loads from each stream, 6 stores, the shuffling stays in registers
+		void InterleaveFloat3Pair( char* pDst,const float* pA,const float* pB,size_t count ) noexcept
+		{
+			namespace dx = DirectX;
+			const auto load = []( const float* p )
+			{
+				return dx::XMLoadFloat4( reinterpret_cast<const dx::XMFLOAT4*>(p) );
+			};
+			const auto store = []( char* p,dx::FXMVECTOR v )
+			{
+				dx::XMStoreFloat4( reinterpret_cast<dx::XMFLOAT4*>(p),v );
+			};
+
+			size_t i = 0u;
+			for( ; i + 4u <= count; i += 4u,pA += 12u,pB += 12u,pDst += 96u )
+			{
+				// a0 = ax0 ay0 az0 ax1 | a1 = ay1 az1 ax2 ay2 | a2 = az2 ax3 ay3 az3 (same for b)
+				const auto a0 = load( pA );
+				const auto a1 = load( pA + 4u );
+				const auto a2 = load( pA + 8u );
+				const auto b0 = load( pB );
+				const auto b1 = load( pB + 4u );
+				const auto b2 = load( pB + 8u );
+				store( pDst,dx::XMVectorPermute<0,1,2,4>( a0,b0 ) );
+				store( pDst + 16u,dx::XMVectorPermute<1,2,4,5>( b0,dx::XMVectorPermute<3,4,3,4>( a0,a1 ) ) );
+				store( pDst + 32u,dx::XMVectorPermute<0,1,4,5>( dx::XMVectorPermute<1,7,1,7>( a1,b0 ),b1 ) );
+				store( pDst + 48u,dx::XMVectorPermute<2,3,4,5>( a1,dx::XMVectorPermute<0,6,0,6>( a2,b1 ) ) );
+				store( pDst + 64u,dx::XMVectorPermute<0,1,5,6>( dx::XMVectorPermute<3,4,3,4>( b1,b2 ),a2 ) );
+				store( pDst + 80u,dx::XMVectorPermute<3,5,6,7>( a2,b2 ) );
+			}
+			for( ; i < count; i++,pA += 3u,pB += 3u,pDst += 24u )
+			{
+				std::memcpy( pDst,pA,12u );
+				std::memcpy( pDst + 12u,pB,12u );
+			}
+		}
+	}
+
 	// VertexLayout
 	const VertexLayout::Element& VertexLayout::ResolveByIndex( size_t i ) const noxnd
 	{
@@ -68,6 +143,14 @@ namespace Dvtx
 			return sizeof( Map<Float4Color>::SysType );
 		case BGRAColor:
 			return sizeof( Map<BGRAColor>::SysType );
+		case Position3DHalf:
+			return sizeof( Map<Position3DHalf>::SysType );
+		case NormalOct16:
+			return sizeof( Map<NormalOct16>::SysType );
+		case Texture2DUnorm16:
+			return sizeof( Map<Texture2DUnorm16>::SysType );
+		case TangentFrame:
+			return sizeof( Map<TangentFrame>::SysType );
 		}
 		assert( "Invalid element type" && false );
 		return 0u;
@@ -94,6 +177,14 @@ namespace Dvtx
 			return GenerateDesc<Float4Color>( GetOffset() );
 		case BGRAColor:
 			return GenerateDesc<BGRAColor>( GetOffset() );
+		case Position3DHalf:
+			return GenerateDesc<Position3DHalf>( GetOffset() );
+		case NormalOct16:
+			return GenerateDesc<NormalOct16>( GetOffset() );
+		case Texture2DUnorm16:
+			return GenerateDesc<Texture2DUnorm16>( GetOffset() );
+		case TangentFrame:
+			return GenerateDesc<TangentFrame>( GetOffset() );
 		}
 		assert( "Invalid element type" && false );
 		return { "INVALID",0,DXGI_FORMAT_UNKNOWN,0,0,D3D11_INPUT_PER_VERTEX_DATA,0 };
@@ -119,6 +210,40 @@ namespace Dvtx
 		:
 		layout( std::move( layout ) )
 	{}
+	void VertexBuffer::Reserve( size_t vertexCount ) noxnd
+	{
+		buffer.reserve( vertexCount * layout.Size() );
+	}
+	void VertexBuffer::AppendStreams( size_t count,const void* const* pStreams ) noxnd
+	{
+		const size_t stride = layout.Size();
+		const size_t start = buffer.size();
+		buffer.resize( start + count * stride );
+		char* const pDst = buffer.data() + start;
+
+		if( layout.GetElementCount() == 2u &&
+			layout.ResolveByIndex( 0u ).Size() == 12u && layout.ResolveByIndex( 1u ).Size() == 12u )
+		{
+			InterleaveFloat3Pair( pDst,static_cast<const float*>(pStreams[0]),static_cast<const float*>(pStreams[1]),count );
+			return;
+		}
+		for( size_t i = 0; i < layout.GetElementCount(); i++ )
+		{
+			const auto& e = layout.ResolveByIndex( i );
+			ScatterStream( pDst + e.GetOffset(),stride,static_cast<const char*>(pStreams[i]),e.Size(),count );
+		}
+	}
+	void VertexBuffer::Remap( const std::vector<unsigned int>& order ) noxnd
+	{
+		const size_t stride = layout.Size();
+		std::vector<char> remapped( order.size() * stride );
+		for( size_t i = 0; i < order.size(); i++ )
+		{
+			assert( order[i] < Size() );
+			std::memcpy( remapped.data() + i * stride,buffer.data() + order[i] * stride,stride );
+		}
+		buffer = std::move( remapped );
+	}
 	const char* VertexBuffer::GetData() const noxnd
 	{
 		return buffer.data();
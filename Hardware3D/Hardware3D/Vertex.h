@@ -1,6 +1,9 @@
 ﻿#pragma once
 #include <vector>
+#include <array>
+#include <utility>
 #include "Graphics.h"
+#include <DirectXPackedVector.h>
 #include <type_traits>
 #include "Color.h"
 #include "ConditionalNoExcept.h"
@@ -20,6 +23,12 @@ namespace Dvtx
 			Float3Color,
 			Float4Color,
 			BGRAColor,
+			// quantized forms, see VertexQuantization.h
+			// half float xyz (w unused), octahedron mapped normal, unorm16 uv, snorm16 tangent frame quaternion
+			Position3DHalf,
+			NormalOct16,
+			Texture2DUnorm16,
+			TangentFrame,
 			Count,
 		};
 
@@ -66,6 +75,30 @@ namespace Dvtx
 			static constexpr DXGI_FORMAT dxgiFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
 			static constexpr const char* semantic = "Color";
 		};
+		template<> struct Map<Position3DHalf>
+		{
+			using SysType = DirectX::PackedVector::XMHALF4;
+			static constexpr DXGI_FORMAT dxgiFormat = DXGI_FORMAT_R16G16B16A16_FLOAT;
+			static constexpr const char* semantic = "Position";
+		};
+		template<> struct Map<NormalOct16>
+		{
+			using SysType = DirectX::PackedVector::XMSHORTN2;
+			static constexpr DXGI_FORMAT dxgiFormat = DXGI_FORMAT_R16G16_SNORM;
+			static constexpr const char* semantic = "Normal";
+		};
+		template<> struct Map<Texture2DUnorm16>
+		{
+			using SysType = DirectX::PackedVector::XMUSHORTN2;
+			static constexpr DXGI_FORMAT dxgiFormat = DXGI_FORMAT_R16G16_UNORM;
+			static constexpr const char* semantic = "Texcoord";
+		};
+		template<> struct Map<TangentFrame>
+		{
+			using SysType = DirectX::PackedVector::XMSHORTN4;
+			static constexpr DXGI_FORMAT dxgiFormat = DXGI_FORMAT_R16G16B16A16_SNORM;
+			static constexpr const char* semantic = "TangentFrame";
+		};
 		
 		class Element
 		{
@@ -110,6 +143,51 @@ namespace Dvtx
 		std::vector<Element> elements;
 	};
 
+	// compile time helpers for StaticLayout
+	template<VertexLayout::ElementType ...Types>
+	constexpr std::array<size_t, sizeof...(Types)> StaticOffsets() noexcept
+	{
+		constexpr size_t sizes[] = { sizeof(typename VertexLayout::Map<Types>::SysType)... };
+		std::array<size_t, sizeof...(Types)> offsets = {};
+		size_t offset = 0u;
+		for (size_t i = 0; i < offsets.size(); i++)
+		{
+			offsets[i] = offset;
+			offset += sizes[i];
+		}
+		return offsets;
+	}
+	template<VertexLayout::ElementType ...Types, size_t ...I>
+	constexpr std::array<D3D11_INPUT_ELEMENT_DESC, sizeof...(Types)> StaticDesc(std::index_sequence<I...>) noexcept
+	{
+		constexpr auto offsets = StaticOffsets<Types...>();
+		return { {
+			{ VertexLayout::Map<Types>::semantic,0,VertexLayout::Map<Types>::dxgiFormat,0,(UINT)offsets[I],D3D11_INPUT_PER_VERTEX_DATA,0 }...
+		} };
+	}
+
+	// vertex layout fixed at compile time: offsets, stride and the input element descs are constants,
+	// VertexLayout stays for formats only known at runtime
+	template<VertexLayout::ElementType ...Types>
+	class StaticLayout
+	{
+		static_assert(sizeof...(Types) > 0u, "Static layout needs at least one element");
+	public:
+		static constexpr size_t elementCount = sizeof...(Types);
+		static constexpr size_t stride = (sizeof(typename VertexLayout::Map<Types>::SysType) + ...);
+		static constexpr std::array<size_t, elementCount> offsets = StaticOffsets<Types...>();
+		static constexpr std::array<D3D11_INPUT_ELEMENT_DESC, elementCount> desc =
+			StaticDesc<Types...>(std::make_index_sequence<elementCount>{});
+	public:
+		// runtime equivalent, for everything that takes a dynamic layout
+		static VertexLayout MakeDynamic() noxnd
+		{
+			VertexLayout layout;
+			(layout.Append(Types), ...);
+			return layout;
+		}
+	};
+
 	class Vertex
 	{
 		friend class VertexBuffer;
@@ -148,6 +226,18 @@ namespace Dvtx
 			case VertexLayout::BGRAColor:
 				SetAttribute<VertexLayout::BGRAColor>(pAttribute, std::forward<T>(val));
 				break;
+			case VertexLayout::Position3DHalf:
+				SetAttribute<VertexLayout::Position3DHalf>(pAttribute, std::forward<T>(val));
+				break;
+			case VertexLayout::NormalOct16:
+				SetAttribute<VertexLayout::NormalOct16>(pAttribute, std::forward<T>(val));
+				break;
+			case VertexLayout::Texture2DUnorm16:
+				SetAttribute<VertexLayout::Texture2DUnorm16>(pAttribute, std::forward<T>(val));
+				break;
+			case VertexLayout::TangentFrame:
+				SetAttribute<VertexLayout::TangentFrame>(pAttribute, std::forward<T>(val));
+				break;
 			default:
 				assert("Bad element type" && false);
 			}
@@ -209,6 +299,22 @@ namespace Dvtx
 			buffer.resize(buffer.size() + layout.Size());
 			Back().Vertex::SetAttributeByIndex(0u, std::forward<Params>(params)...);
 		}
+		// appends count vertices at once from one tightly packed source stream per layout element (in layout order)
+		// storage grows once and common layouts get dedicated interleave kernels
+		template<typename ...Streams>
+		void EmplaceBackBulk(size_t count, const Streams*... streams) noxnd
+		{
+			assert(sizeof...(streams) == layout.GetElementCount() && "Stream count doesn't match number of vertex elements");
+			size_t i = 0u;
+			assert(((layout.ResolveByIndex(i++).Size() == sizeof(Streams)) && ...) && "Stream type doesn't match vertex element size");
+			const void* pStreams[] = { streams... };
+			AppendStreams(count, pStreams);
+		}
+		// untyped form of EmplaceBackBulk for layouts only known at runtime
+		void AppendStreams(size_t count, const void* const* pStreams) noxnd;
+		void Reserve(size_t vertexCount) noxnd;
+		// keeps only the listed vertices, in the listed order
+		void Remap(const std::vector<unsigned int>& order) noxnd;
 		Vertex Back() noxnd;
 		Vertex Front() noxnd;
 		Vertex operator[](size_t i) noxnd;
@@ -4,7 +4,13 @@ namespace Bind
 {
 	VertexBuffer::VertexBuffer(Graphics& gfx, const Dvtx::VertexBuffer& vbuf)
 		:
-	stride((UINT)vbuf.GetLayout().Size())
+		VertexBuffer(gfx, vbuf.GetLayout(), vbuf.GetData(), vbuf.SizeBytes())
+	{
+	}
+
+	VertexBuffer::VertexBuffer(Graphics& gfx, const Dvtx::VertexLayout& layout, const char* pData, size_t sizeBytes)
+		:
+		stride((UINT)layout.Size())
 	{
 		INFOMAN(gfx);
 
@@ -13,11 +19,11 @@ namespace Bind
 		bufDesc.Usage = D3D11_USAGE_DEFAULT;
 		bufDesc.CPUAccessFlags = 0u;
 		bufDesc.MiscFlags = 0u;
-		bufDesc.ByteWidth = UINT( vbuf.SizeBytes() );
+		bufDesc.ByteWidth = UINT( sizeBytes );
 		bufDesc.StructureByteStride = stride;
 
 		D3D11_SUBRESOURCE_DATA subData = {};
-		subData.pSysMem = vbuf.GetData();
+		subData.pSysMem = pData;
 		GFX_THROW_INFO(GetDevice(gfx)->CreateBuffer(&bufDesc, &subData, &pVertexBuffer));
 	}
 
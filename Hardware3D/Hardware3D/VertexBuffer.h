@@ -28,6 +28,8 @@ namespace Bind
 			GFX_THROW_INFO(GetDevice(gfx)->CreateBuffer(&bufDesc, &subData, &pVertexBuffer));
 		}
 		VertexBuffer(Graphics& gfx, const Dvtx::VertexBuffer& vbuf);
+		// builds straight from already interleaved vertex bytes (e.g. a mapped cache file)
+		VertexBuffer(Graphics& gfx, const Dvtx::VertexLayout& layout, const char* pData, size_t sizeBytes);
 		void Bind(Graphics& gfx) noexcept override;
 	protected:
 		UINT stride;
@@ -0,0 +1,221 @@
+﻿#include "VertexQuantization.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace dx = DirectX;
+namespace dxpv = DirectX::PackedVector;
+
+namespace Dvtx
+{
+	namespace
+	{
+		// smallest |w| that survives snorm16 so the handedness sign is never lost
+		constexpr float quaternionBias = 1.0f / 32767.0f;
+
+		template<typename T>
+		T Read(const char* pVertex, size_t offset) noexcept
+		{
+			T value;
+			std::memcpy(&value, pVertex + offset, sizeof(T));
+			return value;
+		}
+
+		// one packed stream per element, filled by the Quantize* helpers below
+		// they return false (and leave the stream alone) when the budget is blown
+		bool QuantizePositions(const VertexBuffer& vbuf, size_t offset, float budget, std::vector<char>& stream)
+		{
+			const size_t count = vbuf.Size();
+			const size_t stride = vbuf.GetLayout().Size();
+			std::vector<dxpv::XMHALF4> packed(count);
+			for (size_t i = 0; i < count; i++)
+			{
+				const auto p = Read<dx::XMFLOAT3>(vbuf.GetData() + stride * i, offset);
+				packed[i] = dxpv::XMHALF4(p.x, p.y, p.z, 1.0f);
+				const float error = std::max({
+					std::abs(dxpv::XMConvertHalfToFloat(packed[i].x) - p.x),
+					std::abs(dxpv::XMConvertHalfToFloat(packed[i].y) - p.y),
+					std::abs(dxpv::XMConvertHalfToFloat(packed[i].z) - p.z)
+				});
+				if (!(error <= budget))
+				{
+					return false;
+				}
+			}
+			const auto pBytes = reinterpret_cast<const char*>(packed.data());
+			stream.assign(pBytes, pBytes + packed.size() * sizeof(dxpv::XMHALF4));
+			return true;
+		}
+
+		bool QuantizeNormals(const VertexBuffer& vbuf, size_t offset, float budget, std::vector<char>& stream)
+		{
+			const size_t count = vbuf.Size();
+			const size_t stride = vbuf.GetLayout().Size();
+			std::vector<dxpv::XMSHORTN2> packed(count);
+			for (size_t i = 0; i < count; i++)
+			{
+				const auto n = Read<dx::XMFLOAT3>(vbuf.GetData() + stride * i, offset);
+				const auto original = dx::XMVector3Normalize(dx::XMLoadFloat3(&n));
+				packed[i] = EncodeOctNormal(original);
+				const float error = dx::XMVectorGetX(dx::XMVector3Length(
+					dx::XMVectorSubtract(DecodeOctNormal(packed[i]), original)
+				));
+				if (!(error <= budget))
+				{
+					return false;
+				}
+			}
+			const auto pBytes = reinterpret_cast<const char*>(packed.data());
+			stream.assign(pBytes, pBytes + packed.size() * sizeof(dxpv::XMSHORTN2));
+			return true;
+		}
+
+		bool QuantizeTexcoords(const VertexBuffer& vbuf, size_t offset, float budget, std::vector<char>& stream)
+		{
+			const size_t count = vbuf.Size();
+			const size_t stride = vbuf.GetLayout().Size();
+			std::vector<dxpv::XMUSHORTN2> packed(count);
+			for (size_t i = 0; i < count; i++)
+			{
+				const auto uv = Read<dx::XMFLOAT2>(vbuf.GetData() + stride * i, offset);
+				// no wrapping uvs, they would get clamped
+				if (uv.x < 0.0f || uv.x > 1.0f || uv.y < 0.0f || uv.y > 1.0f)
+				{
+					return false;
+				}
+				dxpv::XMStoreUShortN2(&packed[i], dx::XMLoadFloat2(&uv));
+				dx::XMFLOAT2 decoded;
+				dx::XMStoreFloat2(&decoded, dxpv::XMLoadUShortN2(&packed[i]));
+				const float error = std::max(std::abs(decoded.x - uv.x), std::abs(decoded.y - uv.y));
+				if (!(error <= budget))
+				{
+					return false;
+				}
+			}
+			const auto pBytes = reinterpret_cast<const char*>(packed.data());
+			stream.assign(pBytes, pBytes + packed.size() * sizeof(dxpv::XMUSHORTN2));
+			return true;
+		}
+	}
+
+	std::uint32_t QuantizationBudget::GetHash() const noexcept
+	{
+		std::uint32_t hash = 2166136261u;
+		for (const float f : { position, normal, texcoord })
+		{
+			std::uint32_t bits;
+			std::memcpy(&bits, &f, sizeof(bits));
+			hash = (hash ^ bits) * 16777619u;
+		}
+		return hash;
+	}
+
+	dxpv::XMSHORTN2 EncodeOctNormal(dx::FXMVECTOR normal) noexcept
+	{
+		dx::XMFLOAT3 n;
+		dx::XMStoreFloat3(&n, normal);
+		// project onto the octahedron |x| + |y| + |z| = 1, then fold the lower half over the diagonals
+		const float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+		float x = n.x / l1;
+		float y = n.y / l1;
+		if (n.z < 0.0f)
+		{
+			const float fx = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+			const float fy = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+			x = fx;
+			y = fy;
+		}
+		dxpv::XMSHORTN2 packed;
+		dxpv::XMStoreShortN2(&packed, dx::XMVectorSet(x, y, 0.0f, 0.0f));
+		return packed;
+	}
+
+	dx::XMVECTOR DecodeOctNormal(dxpv::XMSHORTN2 packed) noexcept
+	{
+		dx::XMFLOAT2 e;
+		dx::XMStoreFloat2(&e, dxpv::XMLoadShortN2(&packed));
+		dx::XMFLOAT3 n = { e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y) };
+		// same fold as the shader side (PhongOctVS)
+		const float t = std::max(-n.z, 0.0f);
+		n.x += n.x >= 0.0f ? -t : t;
+		n.y += n.y >= 0.0f ? -t : t;
+		return dx::XMVector3Normalize(dx::XMLoadFloat3(&n));
+	}
+
+	dxpv::XMSHORTN4 EncodeTangentFrame(dx::FXMVECTOR normal, dx::FXMVECTOR tangent, dx::FXMVECTOR bitangent) noexcept
+	{
+		// a quaternion can only hold a proper rotation, mirrored frames get their bitangent flipped
+		// and remember that in the sign of w instead
+		const bool mirrored = dx::XMVectorGetX(dx::XMVector3Dot(dx::XMVector3Cross(normal, tangent), bitangent)) < 0.0f;
+		const auto frame = dx::XMMATRIX(
+			tangent,
+			mirrored ? dx::XMVectorNegate(bitangent) : bitangent,
+			normal,
+			dx::g_XMIdentityR3
+		);
+		auto q = dx::XMQuaternionNormalize(dx::XMQuaternionRotationMatrix(frame));
+		// q and -q are the same rotation, which frees the sign of w for the handedness
+		if (dx::XMVectorGetW(q) < 0.0f)
+		{
+			q = dx::XMVectorNegate(q);
+		}
+		if (dx::XMVectorGetW(q) < quaternionBias)
+		{
+			const float scale = std::sqrt(1.0f - quaternionBias * quaternionBias);
+			q = dx::XMVectorSetW(dx::XMVectorScale(dx::XMVector3Normalize(q), scale), quaternionBias);
+		}
+		if (mirrored)
+		{
+			q = dx::XMVectorNegate(q);
+		}
+		dxpv::XMSHORTN4 packed;
+		dxpv::XMStoreShortN4(&packed, q);
+		return packed;
+	}
+
+	VertexBuffer Quantize(const VertexBuffer& vbuf, const QuantizationBudget& budget)
+	{
+		const auto& srcLayout = vbuf.GetLayout();
+		const size_t count = vbuf.Size();
+
+		VertexLayout layout;
+		std::vector<std::vector<char>> streams(srcLayout.GetElementCount());
+		for (size_t i = 0; i < srcLayout.GetElementCount(); i++)
+		{
+			const auto& e = srcLayout.ResolveByIndex(i);
+			auto& stream = streams[i];
+			if (e.GetType() == VertexLayout::Position3D && QuantizePositions(vbuf, e.GetOffset(), budget.position, stream))
+			{
+				layout.Append(VertexLayout::Position3DHalf);
+			}
+			else if (e.GetType() == VertexLayout::Normal && QuantizeNormals(vbuf, e.GetOffset(), budget.normal, stream))
+			{
+				layout.Append(VertexLayout::NormalOct16);
+			}
+			else if (e.GetType() == VertexLayout::Texture2D && QuantizeTexcoords(vbuf, e.GetOffset(), budget.texcoord, stream))
+			{
+				layout.Append(VertexLayout::Texture2DUnorm16);
+			}
+			else
+			{
+				// kept as is, gathered out of the interleaved source
+				stream.resize(count * e.Size());
+				for (size_t v = 0; v < count; v++)
+				{
+					std::memcpy(stream.data() + v * e.Size(), vbuf.GetData() + v * srcLayout.Size() + e.GetOffset(), e.Size());
+				}
+				layout.Append(e.GetType());
+			}
+		}
+
+		std::vector<const void*> pStreams;
+		pStreams.reserve(streams.size());
+		for (const auto& s : streams)
+		{
+			pStreams.push_back(s.data());
+		}
+		VertexBuffer quantized(std::move(layout));
+		quantized.AppendStreams(count, pStreams.data());
+		return quantized;
+	}
+}
@@ -0,0 +1,31 @@
+﻿#pragma once
+#include "Vertex.h"
+#include <cstdint>
+
+namespace Dvtx
+{
+	// how far a quantized attribute may land from the original, a quantized element type
+	// is only picked for a mesh if every one of its vertices stays inside the bound
+	struct QuantizationBudget
+	{
+		// absolute, in model units
+		float position = 0.005f;
+		// distance between original and decoded unit normal (roughly radians)
+		float normal = 0.002f;
+		// in uv units, unorm16 only applies at all when every uv is inside [0,1]
+		float texcoord = 1.0f / 4096.0f;
+		// changes whenever one of the bounds does, for cache keys
+		std::uint32_t GetHash() const noexcept;
+	};
+
+	// octahedral mapping of a unit normal onto two snorm16 values
+	DirectX::PackedVector::XMSHORTN2 EncodeOctNormal(DirectX::FXMVECTOR normal) noexcept;
+	DirectX::XMVECTOR DecodeOctNormal(DirectX::PackedVector::XMSHORTN2 packed) noexcept;
+	// orthonormal tangent frame as a snorm16 quaternion, the sign of w carries the bitangent handedness
+	DirectX::PackedVector::XMSHORTN4 EncodeTangentFrame(DirectX::FXMVECTOR normal, DirectX::FXMVECTOR tangent,
+		DirectX::FXMVECTOR bitangent) noexcept;
+
+	// copy of vbuf where every element that fits the budget is swapped for its quantized type
+	// Position3D -> Position3DHalf, Normal -> NormalOct16, Texture2D -> Texture2DUnorm16, everything else is kept
+	VertexBuffer Quantize(const VertexBuffer& vbuf, const QuantizationBudget& budget);
+}
@@ -1,5 +1,6 @@
 ﻿#include "VertexShader.h"
 #include "GraphicsErrorMacros.h"
+#include "BindableCodex.h"
 
 namespace Bind
 {
@@ -25,5 +26,12 @@ namespace Bind
 	{
 		return pBytecodeBlob.Get();
 	}
+
+	std::string VertexShader::GenerateUID(const std::wstring& path)
+	{
+		auto uid = Codex::MakeUID(typeid(VertexShader).name());
+		Codex::AppendUID(uid, path);
+		return uid;
+	}
 	
 }
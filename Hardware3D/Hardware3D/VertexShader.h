@@ -9,6 +9,7 @@ namespace Bind
 		VertexShader(Graphics& gfx, const std::wstring& path);
 		void Bind(Graphics& gfx) noexcept override;
 		ID3DBlob* GetBytecode() const noexcept;
+		static std::string GenerateUID(const std::wstring& path);
 	protected:
 		Microsoft::WRL::ComPtr<ID3DBlob> pBytecodeBlob;
 		Microsoft::WRL::ComPtr<ID3D11VertexShader> pVertexShader;